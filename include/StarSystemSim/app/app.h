@@ -12,6 +12,7 @@
 #include <glm/vec2.hpp>
 
 #include <cstdint>
+#include <functional>
 #include <vector>
 
 struct App {
@@ -26,6 +27,8 @@ struct App {
 
 	static graphics::Planet* addToScene(graphics::Planet& planet);
 	static graphics::Star* addToScene(graphics::Star& star);
+	// deletes the planet or star owning body
+	static void removeFromScene(physics::Body* body, graphics::Object* replacement = nullptr);
 	static void setSkybox(const graphics::Skybox& skybox);
 
 	static App* s_Instance;
@@ -39,6 +42,8 @@ struct App {
 	graphics::Scene scene;
 	graphics::Camera mainCamera;
 	std::vector<graphics::Object*> camTargets;
+	// called with a planet or star removed from the scene right before it is deleted
+	std::function<void(graphics::Object*)> onRemove;
 
 
 	bool isCursorVisible;
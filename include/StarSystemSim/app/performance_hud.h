@@ -0,0 +1,76 @@
+#pragma once
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/utilities/profiler.h"
+#include "StarSystemSim/utilities/alloc_tracker.h"
+#include "StarSystemSim/graphics/gl_call_counter.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace app {
+
+	// Frame times of the last HISTORY frames and where each of them went, read
+	// back from the zones the main thread records. Without the profiler only
+	// the frame times and counters are filled in.
+	class PerformanceHud {
+	public:
+		static const uint32_t HISTORY = 240;
+
+		enum class Phase {
+			PHYSICS, PREDICTION,
+			SKYBOX, STARS, PLANETS, LINES, PARTICLES, POST, RENDER,
+			IMGUI, SWAP, SLEEP, OTHER
+		};
+		static const uint32_t PHASE_COUNT = (uint32_t)Phase::OTHER + 1;
+
+		PerformanceHud();
+
+		// once per frame on the main thread outside of any zone,
+		// drawCalls are the ones issued by the frame that just ended
+		void collect(const physics::Engine& engine, uint32_t drawCalls);
+		void draw(bool* open);
+
+		static const char* getPhaseName(Phase phase);
+
+	private:
+		float m_FrameTimes[HISTORY];
+		float m_PhaseTimes[HISTORY][PHASE_COUNT];
+		// frames collected so far, the newest one is at (m_Frames - 1) % HISTORY
+		uint32_t m_Frames;
+		uint64_t m_LastTime;
+
+		// interaction rate over windows of about half a second
+		uint64_t m_RateTime, m_RateInteractions;
+		double m_InteractionRate;
+
+		size_t m_Bodies, m_Particles;
+		uint32_t m_DrawCalls;
+
+		physics::Invariants m_Invariants;
+		physics::Drift m_Drift;
+		// log10 of the energy drift of every frame in the history
+		float m_EnergyDrift[HISTORY];
+
+		// heap allocations of the main thread per frame and phase
+		float m_FrameAllocations[HISTORY];
+		float m_PhaseAllocations[HISTORY][PHASE_COUNT];
+		uint64_t m_FrameBytes, m_OtherThreadAllocations;
+		utils::AllocTracker::Counts m_ThreadCounts, m_TotalCounts;
+
+		// the engine's phase counters at the start of the rate window and over the last full one
+		physics::Engine::PhaseCounters m_PhaseCountersStart[physics::Engine::PHASE_COUNT];
+		physics::Engine::PhaseCounters m_PhaseCounters[physics::Engine::PHASE_COUNT];
+
+		// GL calls through glad per frame, only counted when the GLCallCounter is installed
+		float m_GlCalls[HISTORY];
+		std::vector<uint32_t> m_GlEntries;
+
+		std::vector<utils::Profiler::Zone> m_Zones;
+		std::vector<float> m_Sorted;
+
+		void addZones(float* phases, float* allocations) const;
+		float getPercentile(float fraction) const;
+	};
+
+}
\ No newline at end of file
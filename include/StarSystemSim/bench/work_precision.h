@@ -0,0 +1,18 @@
+#pragma once
+
+namespace bench {
+
+	struct WorkPrecisionSettings {
+		// only scenarios or solvers whose name contains it
+		const char* filter = nullptr;
+		// smaller steps of a solver are skipped once a run would take longer
+		double budget = 5.0;
+		// json, stdout when null
+		const char* outputPath = nullptr;
+	};
+
+	// runs every reference scenario with every solver over a range of steps and
+	// writes the cost and the error against a double precision reference of each run
+	int runWorkPrecision(const WorkPrecisionSettings& settings);
+
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+// glad's entry points are only wrapped when built with -DSTARSIM_GL_DEBUG=1
+#ifndef STARSIM_GL_DEBUG
+#define STARSIM_GL_DEBUG 0
+#endif
+
+// every entry point the renderer calls and how its calls are flagged
+#define STARSIM_GL_CALLS(X) \
+	X(glActiveTexture, BIND) X(glAttachShader, CALL) X(glBeginQuery, CALL) X(glBindAttribLocation, CALL) \
+	X(glBindBuffer, BIND) X(glBindFramebuffer, BIND) X(glBindRenderbuffer, CALL) X(glBindTexture, BIND) \
+	X(glBindVertexArray, BIND) X(glBlendFunc, CALL) X(glBlitFramebuffer, CALL) X(glBufferData, CALL) \
+	X(glCheckFramebufferStatus, QUERY) X(glClear, CALL) X(glClearColor, CALL) X(glCompileShader, CALL) \
+	X(glCreateProgram, CALL) X(glCreateShader, CALL) X(glCullFace, CALL) X(glDeleteBuffers, CALL) \
+	X(glDeleteFramebuffers, CALL) X(glDeleteProgram, CALL) X(glDeleteQueries, CALL) X(glDeleteRenderbuffers, CALL) \
+	X(glDeleteShader, CALL) X(glDeleteTextures, CALL) X(glDeleteVertexArrays, CALL) X(glDepthMask, CALL) \
+	X(glDetachShader, CALL) X(glDisable, CALL) X(glDrawArrays, CALL) X(glDrawBuffer, CALL) \
+	X(glDrawBuffers, CALL) X(glDrawElements, CALL) X(glEnable, CALL) X(glEnableVertexAttribArray, CALL) \
+	X(glEndQuery, CALL) X(glFramebufferRenderbuffer, CALL) X(glFramebufferTexture2D, CALL) X(glGenBuffers, CALL) \
+	X(glGenFramebuffers, CALL) X(glGenQueries, CALL) X(glGenRenderbuffers, CALL) X(glGenTextures, CALL) \
+	X(glGenVertexArrays, CALL) X(glGenerateMipmap, CALL) X(glGetQueryObjectui64v, QUERY) X(glGetShaderInfoLog, QUERY) \
+	X(glGetShaderiv, QUERY) X(glGetString, QUERY) X(glGetTexLevelParameteriv, QUERY) X(glGetUniformLocation, LOOKUP) \
+	X(glLinkProgram, CALL) X(glPatchParameteri, CALL) X(glPixelStorei, CALL) X(glPolygonMode, CALL) \
+	X(glReadBuffer, CALL) X(glRenderbufferStorageMultisample, CALL) X(glShaderSource, CALL) X(glTexImage2D, CALL) \
+	X(glTexParameteri, CALL) X(glTexSubImage2D, CALL) X(glUniform1f, CALL) X(glUniform1i, CALL) \
+	X(glUniform1ui, CALL) X(glUniform2f, CALL) X(glUniform3f, CALL) X(glUniform4f, CALL) \
+	X(glUniformMatrix4fv, CALL) X(glUseProgram, BIND) X(glVertexAttribPointer, CALL) X(glViewport, CALL)
+
+namespace graphics {
+
+	// Counts the calls made through glad per frame and entry point by swapping
+	// glad's function pointers for counting ones. Binding the program, vertex
+	// array, array buffer, framebuffer, texture unit or texture that is already
+	// bound counts as redundant; queries that may wait for the driver and uniform
+	// lookups are flagged on their own. ImGui loads GL itself and is not counted.
+	class GLCallCounter {
+	public:
+		enum class Kind {
+			CALL,
+			// binds whose redundant calls are detected
+			BIND,
+			// reads back from the driver, a possible sync point
+			QUERY,
+			// a name lookup that belongs in setup, not in the frame
+			LOOKUP
+		};
+
+		enum Entry {
+#define STARSIM_GL_ENTRY(name, kind) ENTRY_##name,
+			STARSIM_GL_CALLS(STARSIM_GL_ENTRY)
+#undef STARSIM_GL_ENTRY
+			ENTRY_COUNT
+		};
+
+		struct Frame {
+			uint32_t calls[ENTRY_COUNT];
+			uint32_t redundant[ENTRY_COUNT];
+
+			uint32_t getCalls() const;
+			uint32_t getRedundant() const;
+			// calls of QUERY and LOOKUP entries
+			uint32_t getQueries() const;
+		};
+
+		// swaps glad's pointers once they are loaded, false unless built with STARSIM_GL_DEBUG
+		static bool install();
+		static bool isInstalled();
+
+		// ends the frame getLastFrame() returns and starts counting the next one
+		static void endFrame();
+		static const Frame& getLastFrame();
+
+		static const char* getEntryName(uint32_t entry);
+		static Kind getEntryKind(uint32_t entry);
+	};
+
+}
\ No newline at end of file
@@ -40,6 +40,8 @@ namespace graphics {
 		uint64_t loadTexture(const std::string& path, bool required = false);
 
 		std::shared_ptr<Mesh> m_MainMesh;
+		// radius the mesh is currently scaled to, follows body.radius after merges
+		float m_Radius;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "StarSystemSim/graphics/camera.h"
+#include "StarSystemSim/graphics/object.h"
+#include "StarSystemSim/graphics/gl_call_counter.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace graphics {
+
+	// Renders a fixed number of frames along a scripted camera path and times
+	// every one of them on the CPU and, with timer queries, on the GPU. Query
+	// results are read a ring's length later so collecting them does not stall
+	// the frames being measured.
+	class RenderBenchmark {
+	public:
+		RenderBenchmark();
+		~RenderBenchmark();
+
+		RenderBenchmark(const RenderBenchmark&) = delete;
+		RenderBenchmark& operator=(const RenderBenchmark&) = delete;
+
+		// the first warmUp frames are drawn but not recorded, needs a current GL context
+		void start(uint32_t frames, uint32_t warmUp = 16);
+		inline bool isRunning() const { return m_FrameCount > 0 && !isDone(); }
+		inline bool isDone() const { return m_FrameCount > 0 && m_Frame >= m_WarmUp + m_FrameCount; }
+
+		// orbit, fly-by and zoom around target one after another, depends on nothing but the frame
+		void applyCamera(Camera& camera, Object* target) const;
+
+		// beginFrame() and endDraw() go around the frame's GL work, endFrame() after the swap
+		void beginFrame();
+		void endDraw();
+		void endFrame();
+
+		// per frame cpu, gpu and whole frame times with their percentiles, and GL calls when counted
+		bool writeResults(const char* path);
+
+	private:
+		static const uint32_t QUERY_RING = 8;
+
+		uint32_t m_FrameCount, m_WarmUp, m_Frame;
+		unsigned int m_Queries[QUERY_RING];
+		bool m_QueryPending[QUERY_RING];
+		uint32_t m_QueryFrame[QUERY_RING];
+
+		std::chrono::steady_clock::time_point m_DrawStart, m_LastFrameEnd;
+		// milliseconds of the recorded frames
+		std::vector<double> m_CpuTimes, m_GpuTimes, m_FrameTimes;
+		// GLCallCounter totals of the recorded frames
+		std::vector<uint32_t> m_GlCalls, m_GlRedundant;
+		uint64_t m_EntryCalls[GLCallCounter::ENTRY_COUNT], m_EntryRedundant[GLCallCounter::ENTRY_COUNT];
+
+		void collectQuery(uint32_t slot);
+	};
+
+}
\ No newline at end of file
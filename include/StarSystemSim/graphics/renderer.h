@@ -17,6 +17,8 @@ namespace graphics {
 	class Renderer {
 	public:
 		static float tessLevel;
+		// draw calls issued since the start of the last drawFrame()
+		static uint32_t drawCalls;
 
 		Renderer();
 		~Renderer();
@@ -35,6 +37,7 @@ namespace graphics {
 		inline int getBloomTextureCount() { return m_BloomTextureCount; }
 
 		std::vector<glm::vec3>* lines;
+		std::vector<glm::vec3>* particles;
 
 		bool bloomEnabled;
 
@@ -65,6 +68,7 @@ namespace graphics {
 		unsigned int m_RenderBuffers[3];
 
 		unsigned int m_VAO, m_VBO, m_EBO;
+		unsigned int m_ParticleVAO, m_ParticleVBO;
 
 		
 		Shader m_PostprocessingShader;
@@ -74,6 +78,7 @@ namespace graphics {
 		Shader m_CelestialShader;
 		Shader m_StarShader;
 		Shader m_LineShader;
+		Shader m_ParticleShader;
 
 		void setupFramebuffers();
 		void setupFramebuffers(uint16_t width, uint16_t height);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace graphics {
+
+	// Colour mapped RGBA texture of a 2D scalar grid, NaN cells are transparent.
+	class ScalarFieldTexture {
+	public:
+		ScalarFieldTexture();
+		~ScalarFieldTexture();
+
+		ScalarFieldTexture(const ScalarFieldTexture&) = delete;
+		ScalarFieldTexture& operator=(const ScalarFieldTexture&) = delete;
+
+		// values are row major and row y becomes texel row y,
+		// a range with min >= max is taken from the data
+		void upload(const float* values, uint32_t width, uint32_t height,
+			float min = 0.0f, float max = 0.0f, bool logScale = false);
+
+		// count of evenly spaced iso lines drawn over the colours by the next upload, 0 for none
+		inline void setContours(uint32_t count) { m_Contours = count; }
+
+		inline unsigned int getID() const { return m_Texture; }
+		inline uint32_t getWidth() const { return m_Width; }
+		inline uint32_t getHeight() const { return m_Height; }
+		inline float getMin() const { return m_Min; }
+		inline float getMax() const { return m_Max; }
+
+	private:
+		unsigned int m_Texture;
+		uint32_t m_Width, m_Height;
+		float m_Min, m_Max;
+		uint32_t m_Contours;
+		std::vector<uint8_t> m_Pixels;
+		std::vector<int32_t> m_Bands;
+	};
+
+}
\ No newline at end of file
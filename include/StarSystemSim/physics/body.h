@@ -12,11 +12,13 @@ namespace physics {
 	public:
 		Body();
 		Body(const glm::vec3 pos, float mass = 1.0f);
+		Body(const Body& otherBody) = default;
 		~Body();
 
 		glm::vec3 pos;
 		glm::vec3 vel;
 		float mass;
+		float radius;
 
 		enum class Type {
 			STATIC, DYNAMIC
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	class Engine;
+	class ParticleSystem;
+
+	// Snapshot of an engine: bodies, particle systems, trajectory preview, clock and flags.
+	// The file is a 64 byte header followed by 64 byte aligned columns, load() maps it
+	// and only points into the mapping, the columns are copied once restore() is called.
+	class Checkpoint {
+	public:
+		Checkpoint();
+		~Checkpoint();
+
+		Checkpoint(const Checkpoint&) = delete;
+		Checkpoint& operator=(const Checkpoint&) = delete;
+
+		static bool save(const char* path, const Engine& engine);
+
+		bool load(const char* path);
+		void clear();
+
+		// the engine has to hold as many bodies and particle systems as were saved,
+		// bodies are matched by mass and radius, particle systems by iteration order
+		bool restore(Engine& engine) const;
+
+		// for callers that own their bodies instead of an engine
+		void getBodies(std::vector<Body>& bodies) const;
+		// every saved particle system one after another
+		void getParticles(ParticleSystem& particles) const;
+
+		inline bool isEmpty() const { return m_Data == nullptr; }
+		inline size_t getBodyCount() const { return m_Header.bodyCount; }
+		inline size_t getParticleSystemCount() const { return m_Header.particleSystemCount; }
+		inline double getSimTime() const { return m_Header.simTime; }
+
+	private:
+		enum BodyColumn { POS_X, POS_Y, POS_Z, VEL_X, VEL_Y, VEL_Z, MASS, RADIUS, BODY_COLUMN_COUNT };
+		enum ParticleColumn { PARTICLE_COLUMN_COUNT = 6 };
+		enum PredictionColumn { PREDICTION_COLUMN_COUNT = 6 };
+
+		enum Flags : uint32_t {
+			PAUSED = 1 << 0,
+			PRED_CALCULATED = 1 << 1,
+			PREDICTION_ENABLED = 1 << 2,
+			COLLISIONS_ENABLED = 1 << 3
+		};
+
+		struct Header {
+			char magic[8];
+			uint32_t version;
+			uint32_t bodyCount;
+			uint32_t predictionSteps;
+			uint32_t particleSystemCount;
+			uint32_t flags;
+			float timeMultiplier;
+			float deltaTime;
+			uint32_t padding0;
+			double simTime;
+			uint8_t padding[16];
+		};
+
+		// byte offsets of every column, derived from the header alone
+		struct Layout {
+			size_t particleCounts;
+			size_t types;
+			size_t bodyColumns[BODY_COLUMN_COUNT];
+			size_t prediction[PREDICTION_COLUMN_COUNT];
+			std::vector<size_t> particleColumns;
+			size_t size;
+		};
+
+		Header m_Header;
+		const uint8_t* m_Data;
+		std::vector<uint8_t> m_Owned;
+
+		const uint64_t* m_ParticleCounts;
+		const uint8_t* m_Types;
+		const float* m_BodyColumns[BODY_COLUMN_COUNT];
+		const float* m_Prediction[PREDICTION_COLUMN_COUNT];
+		std::vector<const float*> m_ParticleColumns;
+
+		void* m_Mapping;
+		size_t m_MappingSize;
+
+		// the engine body every saved body is restored into
+		bool matchBodies(const Engine& engine, std::vector<Body*>& targets) const;
+
+		// the particle counts are only known once they have been read
+		static void calcLayout(const Header& header, const uint64_t* particleCounts, Layout& layout);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace physics {
+
+	class ParticleSystem;
+
+	// Uniform grid broad phase. Boxes are hashed into every cell they overlap and
+	// the (cell, box) entries are kept sorted, so a cell is a contiguous run.
+	// Boxes much larger than a cell are kept in a list of their own and tested
+	// against every box.
+	class SpatialHash {
+	public:
+		void build(const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax, float cellSize);
+
+		// every overlapping pair of boxes exactly once
+		void findPairs(std::vector<std::pair<uint32_t, uint32_t>>& pairs) const;
+
+		// boxes overlapping the given box, may contain duplicates
+		void query(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& result) const;
+
+		inline float getCellSize() const { return m_CellSize; }
+
+	private:
+		struct Entry {
+			uint64_t key;
+			uint32_t index;
+		};
+
+		std::vector<Entry> m_Entries;
+		// sorted indices of the boxes left out of the grid
+		std::vector<uint32_t> m_Large;
+		const std::vector<glm::vec3>* m_Min = nullptr;
+		const std::vector<glm::vec3>* m_Max = nullptr;
+		float m_CellSize = 1.0f;
+
+		glm::ivec3 getCell(const glm::vec3& pos) const;
+		bool isLarge(uint32_t index) const;
+		static uint64_t getKey(const glm::ivec3& cell);
+	};
+
+	// earliest time in [0, deltaTime] at which two spheres moving linearly touch,
+	// negative when they stay apart during the step
+	float calcContactTime(const glm::vec3& posA, const glm::vec3& velA, float radiusA,
+		const glm::vec3& posB, const glm::vec3& velB, float radiusB, float deltaTime);
+
+	class CollisionDetector {
+	public:
+		struct Contact {
+			uint32_t a, b;
+			float time;
+		};
+
+		// swept-sphere contacts between bodies over the next step, sorted by time
+		void findContacts(const std::vector<glm::vec3>& pos, const std::vector<glm::vec3>& vel,
+			const std::vector<float>& radius, float deltaTime, std::vector<Contact>& contacts);
+
+		// sorted indices of particles that hit one of the bodies during the next step
+		void findParticleHits(const ParticleSystem& particles, const std::vector<glm::vec3>& pos,
+			const std::vector<glm::vec3>& vel, const std::vector<float>& radius, float deltaTime,
+			std::vector<uint32_t>& hits);
+
+	private:
+		SpatialHash m_Hash;
+		std::vector<glm::vec3> m_BoxMin, m_BoxMax;
+		std::vector<float> m_Sizes;
+		std::vector<std::pair<uint32_t, uint32_t>> m_Pairs;
+		std::vector<uint32_t> m_Candidates;
+	};
+
+}
\ No newline at end of file
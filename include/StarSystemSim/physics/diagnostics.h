@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+namespace physics {
+
+	class Body;
+
+	// Quantities an exact integration keeps constant, summed in double.
+	// Static bodies only add to the potential energy. Angular momentum is taken
+	// about the centre of mass of the static bodies, the point it is conserved
+	// about when there is one, or about the origin when every body moves.
+	struct Invariants {
+		double kinetic, potential;
+		glm::dvec3 momentum, angularMomentum;
+
+		inline double getEnergy() const { return kinetic + potential; }
+		// adds the kinetic energy, momentum and angular momentum of a dynamic body
+		void addMotion(const Body& body, const glm::dvec3& origin);
+	};
+
+	// relative change of each invariant since a reference, see getRelativeError()
+	struct Drift {
+		double energy, momentum, angularMomentum;
+	};
+
+	Invariants measureInvariants(const std::vector<Body>& bodies);
+	Drift getDrift(const Invariants& invariants, const Invariants& reference);
+
+	// |value - reference| / |reference|, the absolute difference when the reference is zero
+	double getRelativeError(double value, double reference);
+	double getRelativeError(const glm::dvec3& value, const glm::dvec3& reference);
+
+	// largest distance between a body and the same body in reference
+	double getPositionError(const std::vector<Body>& bodies, const std::vector<Body>& reference);
+
+}
\ No newline at end of file
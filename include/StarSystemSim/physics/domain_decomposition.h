@@ -0,0 +1,78 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/transport.h"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	// One rank's share of a simulation split into spatial domains by recursive bisection.
+	// Every step a rank publishes the bodies near its domain's surface one by one and the
+	// rest of its mass as the centres of mass of a coarse grid of cells, the other ranks
+	// feel its domain through those point masses only.
+	class DomainDecomposition {
+	public:
+		struct Settings {
+			// bodies closer than this to their domain's surface are sent individually
+			float boundaryWidth = 2.0f;
+			uint32_t cellsPerAxis = 8;
+			// steps between repartitions, bodies stay with their rank in between
+			uint32_t rebalanceEvery = 16;
+		};
+
+		// what a rank sends about one body when the domains are redrawn
+		struct Record {
+			glm::vec3 pos, vel;
+			float mass, radius;
+			uint32_t id;
+			uint32_t dynamic;
+		};
+
+		DomainDecomposition(Transport& transport);
+		DomainDecomposition(Transport& transport, const Settings& settings);
+
+		// collective, every rank passes the same bodies and keeps the ones of its domain
+		void init(const std::vector<Body>& bodies, double startTime = 0.0);
+
+		// collective, kick-drift-kick leapfrog step
+		void step(float deltaTime);
+
+		// collective, every rank receives all bodies in the order given to init()
+		void gather(std::vector<Body>& bodies);
+
+		inline size_t getLocalCount() const { return m_Local.size(); }
+		inline double getTime() const { return m_Time; }
+
+		// bytes a rank may need to send in one exchange for bodyCount bodies in total
+		static size_t getMaxMessageSize(size_t bodyCount);
+
+	private:
+		struct Source {
+			glm::vec3 pos;
+			float mass;
+		};
+
+		Transport& m_Transport;
+		Settings m_Settings;
+
+		std::vector<Record> m_Local;
+		std::vector<glm::vec3> m_Acc;
+		std::vector<Source> m_Remote;
+		size_t m_BodyCount;
+		uint64_t m_Steps;
+		double m_Time;
+
+		std::vector<Source> m_Outgoing;
+		std::vector<std::vector<uint8_t>> m_Received;
+
+		void rebalance();
+		void partition(std::vector<Record>& records, size_t begin, size_t end, uint32_t rankBegin, uint32_t rankEnd);
+		void exchangeSources();
+		void calcAccelerations();
+	};
+
+}
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/collision.h"
+#include "StarSystemSim/physics/diagnostics.h"
 #include "StarSystemSim/utilities/timer.h"
+#include "StarSystemSim/utilities/perf_counters.h"
 
 #include <glm/vec3.hpp>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <set>
@@ -12,38 +17,186 @@ namespace physics {
 
 	const float GRAVITATIONAL_CONSTANT = 0.05f;
 	const float MAX_DELTA_TIME = 0.034f;
+	// the trajectory preview covers PREDICTION_STEPS steps of PREDICTION_STEP seconds
+	const uint16_t PREDICTION_STEPS = 300;
+	const float PREDICTION_STEP = 0.04f;
 
 	class Body;
+	class Ephemeris;
+	class ParticleSystem;
+	class EventDetector;
+	class Checkpoint;
+	class TrajectoryRecorder;
+	class Timeline;
 
 	class Engine {
 	public:
+		// the parts a step is made of, in the order simulateStep() runs them
+		enum class Phase {
+			GRAVITY, COLLISIONS, PARTICLES, ADVANCE,
+			// the trajectory preview, integrated or evaluated from the ephemeris
+			PREDICTION, EPHEMERIS_PREDICTION,
+			// handing the step to the trajectory recorder
+			RECORDING
+		};
+		static const uint32_t PHASE_COUNT = (uint32_t)Phase::RECORDING + 1;
+
+		// hardware counters summed over every time update() ran a phase
+		struct PhaseCounters {
+			utils::PerfCounters::Values values;
+			uint64_t interactions, runs;
+		};
+
 		Engine();
 		~Engine();
 
 		void addBody(Body* body);
 		void remBody(Body* body);
+		// copies the bodies into one block owned by the engine instead of
+		// adding them one by one, returns the first of the copies
+		Body* addBodies(const std::vector<Body>& bodies);
+
+		void addParticleSystem(ParticleSystem* particles);
+		void remParticleSystem(ParticleSystem* particles);
 
 		void update();
 
+		// one integration step of exactly deltaTime without the clock, events or
+		// recording, update() goes through it so replays match the original run
+		void simulateStep(float deltaTime);
+
+		// runs one phase alone with a step of deltaTime, for benchmarks
+		void runPhase(Phase phase, float deltaTime);
+		static const char* getPhaseName(Phase phase);
+
 		void skipIteration();
 
 		void getPredictedPos(std::vector<glm::vec3>& pos);
 
+		// copies the bodies in the engine's iteration order
+		void getBodies(std::vector<Body>& bodies) const;
+		inline size_t getBodyCount() const { return m_Bodies.size(); }
+		// position of body in the iteration order, getBodyCount() if it is not in the engine
+		size_t getBodyIndex(const Body* body) const;
+		// overwrites the bodies in iteration order, the count has to match
+		void setBodies(const std::vector<Body>& bodies);
+
+		inline const std::vector<ParticleSystem*>& getParticleSystems() const { return m_ParticleSystems; }
+
+		// while an ephemeris covering the current time is set, bodies are
+		// evaluated from it instead of being integrated; its bodies are matched
+		// to the engine's by type, mass and radius and a mismatch is refused
+		void setEphemeris(const Ephemeris* ephemeris);
+		inline const Ephemeris* getEphemeris() const { return m_Ephemeris; }
+		// the ephemeris body played back for the body at index (see getBodyIndex)
+		inline size_t getEphemerisBody(size_t index) const { return m_EphemerisBodies[index]; }
+
+		// the detector is checked after every integrated or played back step
+		inline void setEventDetector(EventDetector* detector) { m_EventDetector = detector; }
+
+		// the recorder is handed the bodies after every integrated or played back step
+		inline void setRecorder(TrajectoryRecorder* recorder) { m_Recorder = recorder; }
+		// the timeline logs every integrated step and keeps keyframes for rewinding
+		inline void setTimeline(Timeline* timeline) { m_Timeline = timeline; }
+
+		// counters opened on the thread calling update(), read around every phase
+		// it runs; nullptr stops reading them
+		inline void setPerfCounters(const utils::PerfCounters* counters) { m_PerfCounters = counters; }
+		inline const PhaseCounters& getPhaseCounters(Phase phase) const { return m_PhaseCounters[(uint32_t)phase]; }
+
+		// pairwise gravity evaluations since the engine was made, body pairs of
+		// steps and previews plus particle and body pairs
+		inline uint64_t getInteractionCount() const { return m_Interactions; }
+		size_t getParticleCount() const;
+
+		// invariants of the state at the start of the last integrated step, the
+		// gravity pass sums the potential energy along with the forces; momentum
+		// is only conserved while no body is static
+		inline const Invariants& getInvariants() const { return m_Invariants; }
+		// the first invariants integrated since bodies were last added or removed,
+		// merges included, drift is measured against them
+		inline const Invariants& getInitialInvariants() const { return m_InitialInvariants; }
+		inline Drift getDrift() const { return physics::getDrift(m_Invariants, m_InitialInvariants); }
+		// the next integrated step becomes the reference
+		inline void resetInvariants() { m_HasInitialInvariants = false; }
+
+		inline double getSimTime() const { return m_SimTime; }
+		void setSimTime(double time);
+
+		// source of the wall time that update() steps by
+		inline void setClock(std::function<double()> clock) { m_Timer.setClock(std::move(clock)); }
+
 		bool paused, predCalculated;
+		// the trajectory preview is only needed for drawing
+		bool predictionEnabled;
 		float timeMultiplier;
 
+		bool collisionsEnabled;
+		// called after absorbed has been merged into survivor and removed from the engine
+		std::function<void(Body* survivor, Body* absorbed)> onMerge;
+
 	private:
+		friend class Checkpoint;
+
 		std::set<Body*> m_Bodies;
+		std::vector<std::unique_ptr<Body[]>> m_OwnedBodies;
 
 		std::vector<std::vector<Body>> m_PosPrediction;
 
+		std::vector<ParticleSystem*> m_ParticleSystems;
+		std::vector<float> m_AttrX, m_AttrY, m_AttrZ, m_AttrGM;
+
+		CollisionDetector m_CollisionDetector;
+		std::vector<Body*> m_BodyList;
+		std::vector<glm::vec3> m_CollPos, m_CollVel;
+		std::vector<float> m_CollRadius;
+		std::vector<CollisionDetector::Contact> m_Contacts;
+		std::vector<uint32_t> m_ParticleHits;
+		std::vector<std::pair<Body*, Body*>> m_Merges;
+		std::vector<Body*> m_Absorbed;
+
 		utils::Timer m_Timer;
 		bool m_SkipIteration;
+		double m_SimTime;
+		uint64_t m_Interactions;
+
+		Invariants m_Invariants, m_InitialInvariants;
+		bool m_HasInitialInvariants;
+
+		const Ephemeris* m_Ephemeris;
+		// the ephemeris body each body in iteration order plays back
+		std::vector<uint32_t> m_EphemerisBodies;
+		EventDetector* m_EventDetector;
+		TrajectoryRecorder* m_Recorder;
+		Timeline* m_Timeline;
+
+		const utils::PerfCounters* m_PerfCounters;
+		PhaseCounters m_PhaseCounters[PHASE_COUNT];
+
+		// adds the counters and interactions of its scope to a phase while counters are set
+		class PhaseCounterScope {
+		public:
+			PhaseCounterScope(Engine& engine, Phase phase);
+			~PhaseCounterScope();
+
+		private:
+			Engine& m_Engine;
+			Phase m_Phase;
+			utils::PerfCounters::Values m_Start;
+			uint64_t m_Interactions;
+		};
 
 		void applyGravityForce();
-		void calcGravityVelChange(Body& body1, Body& body2, float deltaTime);
+		// returns the potential energy of the pair
+		float calcGravityVelChange(Body& body1, Body& body2, float deltaTime);
 		void advanceBodies();
+		void advanceParticles();
+		void resolveCollisions();
 		void calcFuturePos(uint16_t steps, float timeOffset);
+		// maps the engine's bodies onto the ephemeris' by type, mass and radius
+		bool matchEphemeris(const Ephemeris& ephemeris);
+		void evalEphemeris(double time);
+		void evalFuturePos(uint16_t steps, float timeOffset);
 	};
 
 }
\ No newline at end of file
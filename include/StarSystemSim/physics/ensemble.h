@@ -0,0 +1,89 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/utilities/thread_pool.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace physics {
+
+	// Many perturbed copies (members) of one scenario advanced together with leapfrog.
+	// Members are interleaved in blocks of ENSEMBLE_LANES so that consecutive floats hold
+	// the same body of different members and the forces of four members are summed per
+	// SSE instruction, blocks are spread over a thread pool.
+	class Ensemble {
+	public:
+		static const size_t ENSEMBLE_LANES = 8;
+
+		enum class Quantity {
+			DISTANCE, // between body and reference
+			SPEED     // of body relative to reference
+		};
+
+		enum class Reduction {
+			MIN, MAX, FINAL
+		};
+
+		// one value per member reduced over the samples of a run, summarized
+		// over all members once the run is done
+		struct Statistic {
+			Quantity quantity;
+			Reduction reduction;
+			size_t body, reference;
+
+			float histogramMin, histogramMax;
+			std::vector<uint32_t> histogram;
+
+			float min, max, mean;
+			std::vector<float> memberValues;
+		};
+
+		using Perturbation = std::function<void(size_t member, std::vector<Body>& bodies)>;
+
+		Ensemble();
+
+		// every member starts as base and is then handed to perturb if given
+		void init(const std::vector<Body>& base, size_t memberCount, const Perturbation& perturb = nullptr);
+		void clear();
+
+		void setMember(size_t member, const std::vector<Body>& bodies);
+		void getMember(size_t member, std::vector<Body>& bodies) const;
+
+		// histogram bins cover [histogramMin, histogramMax], values outside go to the edge bins
+		size_t addStatistic(Quantity quantity, Reduction reduction, size_t body, size_t reference,
+			float histogramMin = 0.0f, float histogramMax = 1.0f, uint32_t bins = 32);
+		inline const Statistic& getStatistic(size_t statistic) const { return m_Statistics[statistic]; }
+		inline size_t getStatisticCount() const { return m_Statistics.size(); }
+
+		// statistics sample every sampleEvery steps and restart with every call
+		void advance(double duration, float maxStep, utils::ThreadPool& pool, uint32_t sampleEvery = 1);
+
+		inline size_t getMemberCount() const { return m_MemberCount; }
+		inline size_t getBodyCount() const { return m_BodyCount; }
+		inline double getTime() const { return m_Time; }
+
+	private:
+		enum Column { POS_X, POS_Y, POS_Z, VEL_X, VEL_Y, VEL_Z, MASS, DYNAMIC, COLUMN_COUNT };
+
+		size_t m_MemberCount, m_BodyCount, m_BlockCount;
+		double m_Time;
+
+		// [block][column][body][lane]
+		std::vector<float> m_Data;
+		std::vector<Statistic> m_Statistics;
+
+		inline float* getColumn(size_t block, Column column) {
+			return m_Data.data() + (block * COLUMN_COUNT + column) * m_BodyCount * ENSEMBLE_LANES;
+		}
+		inline const float* getColumn(size_t block, Column column) const {
+			return m_Data.data() + (block * COLUMN_COUNT + column) * m_BodyCount * ENSEMBLE_LANES;
+		}
+
+		void advanceBlock(size_t block, uint64_t steps, float deltaTime, uint32_t sampleEvery);
+		void sampleBlock(size_t block, bool first);
+		void summarize();
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	// Trajectories of a fixed set of bodies stored as piecewise Chebyshev polynomials.
+	// Coefficients are laid out as [segment][body][axis][degree + 1] so that a file
+	// written by save() can be memory mapped by load() and evaluated in place.
+	class Ephemeris {
+	public:
+		Ephemeris();
+		~Ephemeris();
+
+		Ephemeris(const Ephemeris&) = delete;
+		Ephemeris& operator=(const Ephemeris&) = delete;
+
+		// integrates the bodies from startTime over duration and fits every segment
+		void build(const std::vector<Body>& bodies, double startTime, double duration,
+			float segmentLength = 1.0f, uint16_t degree = 12, float maxStep = 0.001f);
+
+		bool save(const char* path) const;
+		bool load(const char* path);
+		void clear();
+
+		glm::vec3 getPos(size_t body, double time) const;
+		glm::vec3 getVel(size_t body, double time) const;
+		void getState(double time, std::vector<Body>& bodies) const;
+
+		bool covers(double time) const;
+
+		inline bool isEmpty() const { return m_Coeffs == nullptr; }
+		inline size_t getBodyCount() const { return m_Header.bodyCount; }
+		inline float getMass(size_t body) const { return m_Masses[body]; }
+		inline float getRadius(size_t body) const { return m_Radii[body]; }
+		inline Body::Type getType(size_t body) const { return (Body::Type)m_Types[body]; }
+		inline double getStartTime() const { return m_Header.startTime; }
+		inline double getEndTime() const { return m_Header.startTime + m_Header.segmentLength * m_Header.segmentCount; }
+
+	private:
+		struct Header {
+			char magic[8];
+			uint32_t version;
+			uint32_t bodyCount;
+			uint32_t segmentCount;
+			uint32_t degree;
+			double startTime;
+			double segmentLength;
+			uint8_t padding[24];
+		};
+
+		Header m_Header;
+		std::vector<uint8_t> m_Types;
+		std::vector<float> m_Masses, m_Radii;
+
+		const double* m_Coeffs;
+		std::vector<double> m_OwnedCoeffs;
+
+		void* m_Mapping;
+		size_t m_MappingSize;
+
+		// finds the segment of time and the local coordinate in [-1, 1]
+		const double* locate(size_t body, double time, double& x) const;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace physics {
+
+	// Watches event functions g(t) of body states and reports the times at which
+	// they change sign during a step. Every watch is evaluated once per step from
+	// gathered arrays, only sign changes are refined on the step's Hermite interpolant.
+	class EventDetector {
+	public:
+		enum class EventType {
+			PERIAPSIS, APOAPSIS,
+			APPROACH_BEGIN, APPROACH_END,
+			OCCLUSION_BEGIN, OCCLUSION_END
+		};
+
+		struct Event {
+			EventType type;
+			Body* a;
+			Body* b;
+			Body* c;
+			double time;
+		};
+
+		EventDetector();
+		~EventDetector();
+
+		// closest and farthest points of body relative to primary (zero relative radial velocity)
+		void watchApsides(Body* body, Body* primary);
+		// separation of a and b crossing distance
+		void watchProximity(Body* a, Body* b, float distance);
+		// occluder's sphere crossing the line of sight from observer to target
+		void watchOcclusion(Body* observer, Body* target, Body* occluder);
+
+		// drops every watch involving body
+		void forget(Body* body);
+		void clear();
+		// forgets the last step's values after the state jumped, so no sign change is bracketed across the jump
+		void invalidate();
+
+		// oldest undelivered event, events are queued only while no callback is set
+		bool pollEvent(Event& event);
+		std::function<void(const Event&)> callback;
+
+		static const char* getEventName(EventType type);
+
+		// called by the engine around every integrated step
+		void beginStep();
+		void endStep(double startTime, float deltaTime);
+
+	private:
+		enum class WatchType : uint8_t {
+			APSIS, PROXIMITY, OCCLUSION
+		};
+
+		// structure of arrays, one entry per watch
+		std::vector<WatchType> m_WatchTypes;
+		std::vector<uint32_t> m_WatchA, m_WatchB, m_WatchC;
+		std::vector<float> m_WatchParam;
+		std::vector<float> m_PrevValue;
+		std::vector<float> m_CurrValue;
+		std::vector<uint8_t> m_PrevValid;
+
+		std::vector<Body*> m_Tracked;
+		std::vector<glm::vec3> m_StartPos, m_StartVel;
+		std::vector<float> m_PosX, m_PosY, m_PosZ;
+		std::vector<float> m_VelX, m_VelY, m_VelZ;
+		std::vector<float> m_Radius;
+
+		std::deque<Event> m_Queue;
+
+		uint32_t track(Body* body);
+		void addWatch(WatchType type, uint32_t a, uint32_t b, uint32_t c, float param);
+		void evalWatches();
+
+		float evalAt(size_t watch, float tau, float deltaTime) const;
+		glm::vec3 interpolatePos(uint32_t body, float tau, float deltaTime) const;
+		glm::vec3 interpolateVel(uint32_t body, float tau, float deltaTime) const;
+		void emit(const Event& event);
+	};
+
+}
\ No newline at end of file
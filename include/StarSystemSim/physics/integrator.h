@@ -0,0 +1,25 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+
+#include <glm/vec3.hpp>
+#include <vector>
+
+namespace physics {
+
+	enum class Integrator {
+		EULER, LEAPFROG, RK4
+	};
+
+	// fills acc with gravitational accelerations of every body (same law as Engine)
+	void calcAccelerations(const std::vector<Body>& bodies, std::vector<glm::vec3>& acc);
+
+	// advances a snapshot of bodies by deltaTime, static bodies stay in place
+	void integrate(std::vector<Body>& bodies, float deltaTime, Integrator method = Integrator::LEAPFROG);
+
+	// advances a snapshot by duration using steps no longer than maxStep
+	void integrateFor(std::vector<Body>& bodies, double duration, float maxStep, Integrator method = Integrator::LEAPFROG);
+
+	const char* getIntegratorName(Integrator method);
+
+}
\ No newline at end of file
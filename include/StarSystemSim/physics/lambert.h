@@ -0,0 +1,21 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+namespace physics {
+
+	struct LambertProblem {
+		glm::dvec3 r1, r2;
+		double timeOfFlight;
+	};
+
+	struct LambertSolution {
+		glm::dvec3 v1, v2;
+		bool valid;
+	};
+
+	// single revolution transfer from r1 to r2 around a body with gravitational
+	// parameter mu, the motion follows the direction of normal (right hand rule)
+	LambertSolution solveLambert(const LambertProblem& problem, double mu, const glm::dvec3& normal);
+
+}
\ No newline at end of file
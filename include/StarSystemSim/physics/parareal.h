@@ -0,0 +1,37 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/integrator.h"
+#include "StarSystemSim/utilities/thread_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	struct PararealSettings {
+		double duration = 0.0;
+		// 0 uses four slices per pool thread
+		uint32_t slices = 0;
+		float coarseStep = 0.1f;
+		float fineStep = 0.001f;
+		Integrator fineMethod = Integrator::LEAPFROG;
+		uint32_t maxIterations = 16;
+		// largest change of any slice boundary position plus velocity that counts as converged,
+		// float round-off in long fine runs puts a floor under what can be reached
+		float tolerance = 1e-3f;
+	};
+
+	struct PararealResult {
+		uint32_t iterations;
+		float correction;
+		bool converged;
+	};
+
+	// advances bodies by settings.duration with the parallel-in-time Parareal scheme:
+	// a coarse leapfrog pass seeds every slice boundary, the slices are integrated with
+	// the fine method on the pool and the coarse pass is corrected until the boundaries
+	// stop moving, after k iterations the first k slices match a serial fine run
+	PararealResult integrateParareal(std::vector<Body>& bodies, const PararealSettings& settings, utils::ThreadPool& pool);
+
+}
\ No newline at end of file
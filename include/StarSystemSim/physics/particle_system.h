@@ -0,0 +1,58 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	// Massless test particles (belts, rings) kept in structure-of-arrays form.
+	// They are attracted by the engine's bodies but never act on them, so a
+	// step costs O(bodies * particles) instead of O((bodies + particles)^2).
+	class ParticleSystem {
+	public:
+		ParticleSystem();
+		~ParticleSystem();
+
+		size_t addParticle(const glm::vec3& pos, const glm::vec3& vel);
+
+		// scatters count particles on circular orbits around center
+		void addRing(const Body& center, float innerRadius, float outerRadius, size_t count,
+			float thickness = 0.0f, uint32_t seed = 1);
+
+		void reserve(size_t count);
+		void clear();
+
+		// replaces every particle, columns are pos x y z and vel x y z
+		void assign(const float* const columns[6], size_t count);
+
+		// compacts the arrays in one pass, indices have to be sorted
+		void removeParticles(const std::vector<uint32_t>& indices);
+
+		inline size_t getCount() const { return m_PosX.size(); }
+		glm::vec3 getPos(size_t particle) const;
+		glm::vec3 getVel(size_t particle) const;
+
+		// gathers positions into an interleaved array (e.g. for rendering)
+		void getPositions(std::vector<glm::vec3>& positions) const;
+
+		// every column back to back, for in-memory snapshots
+		void saveState(std::vector<float>& state) const;
+		void loadState(const std::vector<float>& state);
+
+		// attractors are given as arrays of positions and G * mass
+		void accelerate(const float* attrX, const float* attrY, const float* attrZ, const float* attrGM,
+			size_t attrCount, float deltaTime);
+		void advance(float deltaTime);
+
+	private:
+		friend class Checkpoint;
+
+		std::vector<float> m_PosX, m_PosY, m_PosZ;
+		std::vector<float> m_VelX, m_VelY, m_VelZ;
+	};
+
+}
\ No newline at end of file
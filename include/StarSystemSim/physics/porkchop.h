@@ -0,0 +1,49 @@
+#pragma once
+
+#include "StarSystemSim/physics/ephemeris.h"
+#include "StarSystemSim/utilities/thread_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	// Departure date x arrival date grid of Lambert transfers between two bodies
+	// of an ephemeris, around its most massive body.
+	class Porkchop {
+	public:
+		struct Settings {
+			size_t departureBody;
+			size_t arrivalBody;
+			double departureStart, departureEnd;
+			double arrivalStart, arrivalEnd;
+			uint32_t width, height;
+		};
+
+		Porkchop();
+
+		// fills the grids, cells without a transfer hold NaN
+		void compute(const Ephemeris& ephemeris, const Settings& settings, utils::ThreadPool& pool);
+
+		inline const Settings& getSettings() const { return m_Settings; }
+		inline uint32_t getWidth() const { return m_Settings.width; }
+		inline uint32_t getHeight() const { return m_Settings.height; }
+
+		// row major, rows are arrival dates and columns departure dates
+		inline const std::vector<float>& getDeltaV() const { return m_DeltaV; }
+		inline const std::vector<float>& getC3() const { return m_C3; }
+
+		inline float getBestDeltaV() const { return m_BestDeltaV; }
+		inline double getBestDeparture() const { return m_BestDeparture; }
+		inline double getBestArrival() const { return m_BestArrival; }
+
+	private:
+		Settings m_Settings;
+		std::vector<float> m_DeltaV;
+		std::vector<float> m_C3;
+
+		float m_BestDeltaV;
+		double m_BestDeparture, m_BestArrival;
+	};
+
+}
\ No newline at end of file
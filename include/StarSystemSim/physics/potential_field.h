@@ -0,0 +1,68 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/utilities/thread_pool.h"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	// Gravitational potential of a set of bodies sampled on a grid spanned from
+	// origin by up to three axes, optionally with the centrifugal term of a
+	// rotating frame added so Lagrange points and Hill regions show up.
+	// The potential is a sum over bodies, so an update only takes out and puts
+	// back the bodies that moved further than a tolerance since they were summed.
+	class PotentialField {
+	public:
+		struct Settings {
+			glm::vec3 origin;
+			// full extent of the grid along each direction, axisW is unused while depth is 1
+			glm::vec3 axisU, axisV, axisW;
+			uint32_t width, height, depth;
+			// keeps the wells finite at the bodies' centres
+			float softening;
+
+			bool rotating;
+			glm::vec3 rotationCenter, rotationAxis;
+			float angularVelocity;
+		};
+
+		PotentialField();
+
+		// drops every summed body, the next update evaluates the whole grid
+		void setSettings(const Settings& settings);
+		inline const Settings& getSettings() const { return m_Settings; }
+
+		// returns whether any value changed
+		bool update(const std::vector<Body>& bodies, utils::ThreadPool& pool, float tolerance);
+
+		// [z][y][x], x runs along axisU
+		inline const std::vector<float>& getValues() const { return m_Values; }
+		inline uint32_t getWidth() const { return m_Settings.width; }
+		inline uint32_t getHeight() const { return m_Settings.height; }
+		inline uint32_t getDepth() const { return m_Settings.depth; }
+		// bodies summed again by the last update
+		inline size_t getUpdatedBodies() const { return m_UpdatedBodies; }
+
+	private:
+		// position and G * mass of a body as it went into the sum
+		struct Source {
+			glm::vec3 pos;
+			float gm;
+		};
+
+		Settings m_Settings;
+		std::vector<float> m_PointX, m_PointY, m_PointZ;
+		std::vector<float> m_Gravity, m_Centrifugal, m_Values;
+		std::vector<Source> m_Summed;
+		uint32_t m_IncrementalUpdates;
+		size_t m_UpdatedBodies;
+
+		// adds gm / distance of every source with the sign of its gm
+		void accumulate(const std::vector<Source>& sources, utils::ThreadPool& pool);
+	};
+
+}
\ No newline at end of file
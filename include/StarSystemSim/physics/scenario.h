@@ -0,0 +1,30 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/particle_system.h"
+
+#include <string>
+#include <vector>
+
+namespace physics {
+
+	// Bodies and start time of a simulation, stored as plain text:
+	//   # comment
+	//   time <start time>
+	//   body <mass> <radius> <px> <py> <pz> <vx> <vy> <vz> [static] [model <name>]
+	// or, for large catalogs, as 64 byte aligned binary columns (see saveScenario).
+	// Massless dynamic bodies are loaded as particles since they cannot pull on anything.
+	struct Scenario {
+		double startTime = 0.0;
+		std::vector<Body> bodies;
+		// render asset per body, empty for bodies that only exist in the physics
+		std::vector<std::string> models;
+		ParticleSystem particles;
+	};
+
+	// the format is told by the file's first bytes, text is parsed in chunks on the shared pool
+	bool loadScenario(const char* path, Scenario& scenario);
+	// paths ending in .ssc are written in the binary form
+	bool saveScenario(const char* path, const Scenario& scenario);
+
+}
\ No newline at end of file
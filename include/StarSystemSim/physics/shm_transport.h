@@ -0,0 +1,60 @@
+#pragma once
+
+#include "StarSystemSim/physics/transport.h"
+
+#include <functional>
+#include <string>
+
+namespace physics {
+
+	// Transport between processes on one machine through a POSIX shared memory
+	// segment holding one slot per rank and a barrier. Slots are double buffered
+	// so an exchange costs a single barrier. A rank that finds a peer gone marks
+	// the segment failed, and the ranks waiting in the barrier give up with it.
+	class ShmTransport : public Transport {
+	public:
+		ShmTransport();
+		~ShmTransport() override;
+
+		ShmTransport(const ShmTransport&) = delete;
+		ShmTransport& operator=(const ShmTransport&) = delete;
+
+		// rank 0 creates the segment, the other ranks wait for it to appear;
+		// slotCapacity bounds the bytes a rank can send in one exchange
+		bool open(const char* name, uint32_t rank, uint32_t rankCount, size_t slotCapacity);
+		void close();
+
+		inline bool isOpen() const { return m_Segment != nullptr; }
+
+		// called now and then while waiting for the segment or in a barrier, returning
+		// false fails the transport; rank 0 can reap its workers here, workers can
+		// check their parent
+		inline void setLivenessCheck(std::function<bool()> check) { m_LivenessCheck = std::move(check); }
+		// fails the transport on every rank
+		void abort();
+
+		uint32_t getRank() const override { return m_Rank; }
+		uint32_t getRankCount() const override { return m_RankCount; }
+
+		bool allGather(const void* data, size_t size, std::vector<std::vector<uint8_t>>& received) override;
+		bool barrier() override;
+		inline bool hasFailed() const override { return m_Failed; }
+
+	private:
+		struct Header;
+
+		std::string m_Name;
+		uint32_t m_Rank, m_RankCount;
+		size_t m_SlotCapacity, m_SegmentSize;
+		uint64_t m_Exchanges;
+
+		void* m_Segment;
+		Header* m_Header;
+
+		std::function<bool()> m_LivenessCheck;
+		bool m_Failed;
+
+		uint8_t* getSlot(uint32_t buffer, uint32_t rank) const;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace physics {
+
+	class Engine;
+
+	// Start of a state export segment, other tools can map it without linking
+	// against the simulator. The columns follow at 64 byte aligned offsets:
+	// pos x y z, vel x y z and mass of bodyCapacity floats each, then
+	// pos x y z and vel x y z of particleCapacity floats each.
+	// sequence is odd while the writer is inside a frame, a read is only
+	// valid if it saw the same even sequence before and after copying.
+	struct StateExportHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		uint64_t bodyCapacity;
+		uint64_t particleCapacity;
+
+		alignas(64) std::atomic<uint64_t> sequence;
+		double simTime;
+		uint64_t bodyCount;
+		uint64_t particleCount;
+	};
+
+	enum StateExportColumn {
+		EXPORT_POS_X, EXPORT_POS_Y, EXPORT_POS_Z, EXPORT_VEL_X, EXPORT_VEL_Y, EXPORT_VEL_Z, EXPORT_MASS,
+		EXPORT_BODY_COLUMN_COUNT
+	};
+
+	// Publishes an engine's bodies and particles into a POSIX shared memory
+	// segment guarded by a seqlock, readers never hold the writer up.
+	class StateExport {
+	public:
+		StateExport();
+		~StateExport();
+
+		StateExport(const StateExport&) = delete;
+		StateExport& operator=(const StateExport&) = delete;
+
+		// bodies and particles past the capacities are left out
+		bool open(const char* name, size_t bodyCapacity, size_t particleCapacity);
+		void close();
+		inline bool isOpen() const { return m_Header != nullptr; }
+
+		void publish(const Engine& engine);
+
+		inline uint64_t getFrame() const { return m_Header ? m_Header->sequence.load(std::memory_order_relaxed) / 2 : 0; }
+
+	private:
+		std::string m_Name;
+		void* m_Segment;
+		size_t m_SegmentSize;
+		StateExportHeader* m_Header;
+		bool m_Truncated;
+
+		std::vector<Body> m_Bodies;
+		std::vector<float> m_Columns[EXPORT_BODY_COLUMN_COUNT];
+		std::vector<float> m_ParticleState;
+	};
+
+	// Read-only view of a segment written by StateExport, e.g. in another process.
+	class StateExportReader {
+	public:
+		struct Frame {
+			uint64_t frame;
+			double simTime;
+			std::vector<float> bodies[EXPORT_BODY_COLUMN_COUNT];
+			std::vector<float> particles[6];
+		};
+
+		StateExportReader();
+		~StateExportReader();
+
+		StateExportReader(const StateExportReader&) = delete;
+		StateExportReader& operator=(const StateExportReader&) = delete;
+
+		bool open(const char* name);
+		void close();
+		inline bool isOpen() const { return m_Header != nullptr; }
+
+		// copies the latest complete frame, fails if the writer kept overwriting it
+		bool read(Frame& frame, uint32_t attempts = 64) const;
+
+	private:
+		const void* m_Segment;
+		size_t m_SegmentSize;
+		const StateExportHeader* m_Header;
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	// Frames of body positions for streaming. Positions are quantized to
+	// fixed point inside a bounding box that is fixed between keyframes.
+	// A keyframe carries the box and every value packed at the chosen width;
+	// a delta carries zigzag varints of the change since the previous frame.
+	// Each message is a 16 byte header (magic, payload size, type, bits, body count)
+	// followed by the frame number, simulation time and the payload.
+	class StreamEncoder {
+	public:
+		// bits per axis between 8 and 24
+		StreamEncoder(uint32_t bits, uint32_t keyframeInterval);
+
+		// appends one message to out, a keyframe when forced, due, the body
+		// count changed or a body left the box
+		void encode(uint64_t frame, double simTime, const std::vector<glm::vec3>& positions, std::vector<uint8_t>& out,
+			bool forceKeyframe = false);
+
+		inline uint32_t getBits() const { return m_Bits; }
+
+	private:
+		uint32_t m_Bits;
+		uint32_t m_KeyframeInterval;
+		uint32_t m_SinceKeyframe;
+
+		glm::vec3 m_BoxMin, m_BoxExtent;
+		// quantized positions of the last frame, [axis][body]
+		std::vector<int32_t> m_Previous[3];
+		std::vector<int32_t> m_Current[3];
+	};
+
+	class StreamDecoder {
+	public:
+		struct Frame {
+			uint64_t frame;
+			double simTime;
+			bool keyframe;
+			std::vector<glm::vec3> positions;
+		};
+
+		StreamDecoder();
+
+		// bytes may arrive in any split, next() returns frames once they are complete
+		void feed(const uint8_t* data, size_t size);
+		bool next(Frame& frame);
+
+		// set when a message did not parse, the stream cannot be followed any further
+		inline bool hasFailed() const { return m_Failed; }
+
+	private:
+		std::vector<uint8_t> m_Buffer;
+		size_t m_Offset;
+		bool m_Failed;
+		bool m_HasKeyframe;
+
+		uint32_t m_Bits;
+		glm::vec3 m_BoxMin, m_BoxExtent;
+		std::vector<int32_t> m_Values[3];
+	};
+
+}
\ No newline at end of file
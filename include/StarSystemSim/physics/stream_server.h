@@ -0,0 +1,75 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/stream_codec.h"
+
+#include <glm/vec3.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace physics {
+
+	class Engine;
+
+	// Streams body positions to any number of subscribers on a local socket,
+	// encoded with a StreamEncoder per subscriber. publish() only hands the
+	// latest positions to a network thread. A subscriber that cannot keep up
+	// misses frames instead of queueing them: a frame is only encoded for it
+	// once everything sent before has left, so deltas always follow what it got.
+	class StreamServer {
+	public:
+		struct Settings {
+			uint32_t bits = 16;
+			uint32_t keyframeInterval = 256;
+		};
+
+		StreamServer();
+		~StreamServer();
+
+		StreamServer(const StreamServer&) = delete;
+		StreamServer& operator=(const StreamServer&) = delete;
+
+		// "host:port" listens on TCP, anything else is the path of a unix socket
+		bool open(const char* address, const Settings& settings);
+		void close();
+		inline bool isOpen() const { return m_Thread.joinable(); }
+
+		// never blocks, a frame published while the network thread is taking the last one is dropped
+		void publish(const Engine& engine);
+
+		inline uint32_t getSubscriberCount() const { return m_SubscriberCount.load(std::memory_order_relaxed); }
+		inline uint64_t getSentBytes() const { return m_SentBytes.load(std::memory_order_relaxed); }
+		// frames subscribers skipped because their socket was still full
+		inline uint64_t getDroppedFrames() const { return m_DroppedFrames.load(std::memory_order_relaxed); }
+
+	private:
+		struct Subscriber;
+
+		Settings m_Settings;
+		std::string m_UnixPath;
+		int m_ListenSocket;
+		int m_WakePipe[2];
+		std::thread m_Thread;
+		std::atomic<bool> m_Quit;
+
+		// written by publish(), taken by the network thread
+		std::mutex m_FrameMutex;
+		std::vector<glm::vec3> m_Latest;
+		double m_LatestTime;
+		uint64_t m_LatestFrame;
+		std::vector<Body> m_Bodies;
+
+		std::atomic<uint32_t> m_SubscriberCount;
+		std::atomic<uint64_t> m_SentBytes;
+		std::atomic<uint64_t> m_DroppedFrames;
+
+		void networkLoop();
+	};
+
+}
\ No newline at end of file
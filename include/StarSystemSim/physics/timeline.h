@@ -0,0 +1,97 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+
+#include <cstdint>
+#include <future>
+#include <vector>
+
+namespace physics {
+
+	class Engine;
+
+	// History of an engine for scrubbing back and forth in time. Every integrated
+	// step's delta time is logged and the full state is kept every few steps, any
+	// logged time is rebuilt by replaying the steps after the nearest keyframe.
+	// When the keyframes outgrow the memory budget every other one is dropped.
+	class Timeline {
+	public:
+		Timeline();
+		Timeline(size_t keyframeInterval, size_t memoryBudget);
+		~Timeline();
+
+		Timeline(const Timeline&) = delete;
+		Timeline& operator=(const Timeline&) = delete;
+
+		void clear();
+
+		// called by the engine after every integrated step, starts a new history
+		// when the step does not follow the current one or bodies were added or removed
+		void onStep(const Engine& engine, float deltaTime);
+
+		// puts the engine in the latest logged state not after time,
+		// stepping the engine afterwards discards the history past that point
+		bool seek(Engine& engine, double time);
+
+		// the replay runs on a background thread, poll() applies it once it is done,
+		// seeks requested in the meantime are merged into one
+		void seekAsync(double time);
+		bool poll(Engine& engine);
+		inline bool isSeeking() const { return m_Job.valid(); }
+
+		inline bool isEmpty() const { return m_Times.empty(); }
+		inline double getStartTime() const { return m_Times.empty() ? 0.0 : m_Times.front(); }
+		inline double getEndTime() const { return m_Times.empty() ? 0.0 : m_Times.back(); }
+		inline double getCurrentTime() const { return m_Times.empty() ? 0.0 : m_Times[m_Cursor]; }
+
+		inline size_t getStepCount() const { return m_Steps.size(); }
+		inline size_t getKeyframeCount() const { return m_Keyframes.size(); }
+		inline size_t getKeyframeInterval() const { return m_Interval; }
+		inline size_t getMemoryUsage() const { return m_KeyframeBytes; }
+
+	private:
+		struct Keyframe {
+			size_t step;
+			std::vector<Body> bodies;
+			std::vector<std::vector<float>> particles;
+			size_t bytes;
+		};
+
+		// a keyframe's state and the delta times leading from it to step
+		struct Replay {
+			size_t step;
+			uint64_t revision;
+			bool collisionsEnabled;
+			std::vector<float> steps;
+			std::vector<Body> bodies;
+			std::vector<std::vector<float>> particles;
+		};
+
+		size_t m_Interval;
+		size_t m_MemoryBudget;
+
+		// m_Times[i] is the time after i steps, m_Steps[i] the delta time of step i
+		std::vector<double> m_Times;
+		std::vector<float> m_Steps;
+		std::vector<Keyframe> m_Keyframes;
+		size_t m_KeyframeBytes;
+		size_t m_Cursor;
+		bool m_CollisionsEnabled;
+
+		// bumped whenever the history changes, replays of an older one are thrown away
+		uint64_t m_Revision;
+		std::future<Replay> m_Job;
+		bool m_PendingSeek;
+		double m_PendingTime;
+
+		void addKeyframe(const Engine& engine);
+		void thinKeyframes();
+		void truncate(size_t step);
+
+		size_t findStep(double time) const;
+		Replay startReplay(size_t step) const;
+		static void runReplay(Replay& replay);
+		void apply(Engine& engine, const Replay& replay);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "StarSystemSim/physics/body.h"
+
+#include <glm/vec3.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace physics {
+
+	class Engine;
+
+	// entry of the chunk index at the end of a recording
+	struct TrajectoryChunk {
+		uint64_t offset;
+		double startTime, endTime;
+		uint64_t sampleCount;
+	};
+
+	// Records body positions and velocities every few steps into chunks of columns.
+	// The simulation thread only fills preallocated chunks of a single producer ring,
+	// a writer thread encodes them (see utils::encodeColumn) and does all file I/O,
+	// including the index written once recording stops.
+	// When the writer falls behind, samples are dropped rather than waited for.
+	class TrajectoryRecorder {
+	public:
+		TrajectoryRecorder();
+		~TrajectoryRecorder();
+
+		TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+		TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+		bool open(const char* path, size_t bodyCount, uint32_t every = 1, uint32_t samplesPerChunk = 256);
+		// stops recording and returns at once, the writer flushes the last partial
+		// chunk and writes the chunk index on its own
+		void finish();
+		// finishes and waits for the writer
+		void close();
+
+		inline bool isOpen() const { return m_Writer.joinable() && !m_Stop.load(std::memory_order_relaxed); }
+
+		// takes a sample on every every-th call, the engine calls it after each step
+		void record(const Engine& engine);
+		void record(double time, const std::vector<Body>& bodies);
+
+		inline uint64_t getDroppedSamples() const { return m_Dropped.load(std::memory_order_relaxed); }
+		inline uint64_t getWrittenBytes() const { return m_Written.load(std::memory_order_relaxed); }
+
+	private:
+		static const size_t RING_SIZE = 8;
+
+		struct Chunk {
+			uint32_t sampleCount;
+			std::vector<double> times;
+			// [pos x, y, z, vel x, y, z][body][sample]
+			std::vector<float> columns;
+		};
+
+		size_t m_BodyCount;
+		uint32_t m_Every, m_SamplesPerChunk;
+		uint64_t m_Calls;
+		std::vector<Body> m_Scratch;
+
+		Chunk m_Ring[RING_SIZE];
+		// chunks published by the simulation and chunks finished by the writer
+		std::atomic<uint64_t> m_Head, m_Tail;
+		Chunk* m_Filling;
+
+		std::thread m_Writer;
+		std::atomic<bool> m_Stop;
+		std::mutex m_WakeMutex;
+		std::condition_variable m_Wake;
+
+		std::ofstream m_File;
+		uint64_t m_Offset;
+		std::vector<TrajectoryChunk> m_Index;
+		std::vector<uint8_t> m_Encoded;
+
+		std::atomic<uint64_t> m_Dropped, m_Written;
+
+		void writerLoop();
+		void writeChunk(const Chunk& chunk);
+		void writeBytes(const void* data, size_t size);
+	};
+
+	// Random access to recordings, falls back to scanning the chunks when the
+	// index is missing (e.g. the recording program did not exit cleanly).
+	class TrajectoryReader {
+	public:
+		struct Frames {
+			std::vector<double> times;
+			// [sample][body]
+			std::vector<glm::vec3> pos, vel;
+		};
+
+		TrajectoryReader();
+
+		bool open(const char* path);
+		void close();
+
+		inline size_t getBodyCount() const { return m_BodyCount; }
+		inline size_t getChunkCount() const { return m_Chunks.size(); }
+		inline uint32_t getEvery() const { return m_Every; }
+		double getStartTime() const;
+		double getEndTime() const;
+
+		// appends every sample with from <= time <= to, only the chunks overlapping it are read
+		bool read(double from, double to, Frames& frames);
+
+	private:
+		std::ifstream m_File;
+		size_t m_BodyCount;
+		uint32_t m_Every;
+		std::vector<TrajectoryChunk> m_Chunks;
+
+		std::vector<uint8_t> m_Encoded;
+		std::vector<double> m_Times;
+		std::vector<float> m_Column;
+
+		bool scanChunks(uint64_t fileSize);
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+
+	// Message passing between the ranks (processes) of one distributed simulation.
+	class Transport {
+	public:
+		virtual ~Transport() = default;
+
+		virtual uint32_t getRank() const = 0;
+		virtual uint32_t getRankCount() const = 0;
+
+		// every rank sends its bytes and receives those of all ranks (its own included)
+		// in rank order, all ranks have to call it the same number of times;
+		// once the transport failed nothing is received
+		virtual bool allGather(const void* data, size_t size, std::vector<std::vector<uint8_t>>& received) = 0;
+
+		// false once the transport failed
+		virtual bool barrier() = 0;
+
+		// a rank died or gave up, every later exchange fails on every rank
+		virtual bool hasFailed() const = 0;
+	};
+
+}
\ No newline at end of file
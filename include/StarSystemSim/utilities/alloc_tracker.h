@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+// the global operator new is only replaced while built with the default
+// -DSTARSIM_ALLOC_TRACKING=1, without it every count stays at zero
+#ifndef STARSIM_ALLOC_TRACKING
+#define STARSIM_ALLOC_TRACKING 1
+#endif
+
+namespace utils {
+
+	// Counts of the allocations made through the global operator new. Every
+	// thread counts its own, so counting needs no atomic operations; the totals
+	// over all threads are summed from the threads' counters when read.
+	class AllocTracker {
+	public:
+		struct Counts {
+			uint64_t allocations, bytes;
+		};
+
+		// made by the calling thread since it started
+		static Counts getThreadCounts();
+		// made by every thread since the process started
+		static Counts getTotalCounts();
+
+		// no-allocation scopes that allocated, over all threads
+		static uint64_t getViolations();
+		// name of the scope that allocated last, nullptr while there was none
+		static const char* getLastViolation();
+
+		// with assertions on, an allocation inside a no-allocation scope aborts
+		// right away so a debugger stops at the code that allocated
+		static void setAssertions(bool enabled);
+		static bool getAssertions();
+	};
+
+	// Declares that the calling thread must not allocate until the end of the
+	// scope; an allocation is counted as a violation or aborts with assertions on.
+	class NoAllocScope {
+	public:
+		// has to outlive the scope, scopes take string literals
+		NoAllocScope(const char* name);
+		~NoAllocScope();
+
+		NoAllocScope(const NoAllocScope&) = delete;
+		NoAllocScope& operator=(const NoAllocScope&) = delete;
+
+	private:
+		const char* m_Name;
+		const char* m_Outer;
+		uint64_t m_Allocations;
+	};
+
+}
+
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+
+#if STARSIM_ALLOC_TRACKING
+#define NO_ALLOC_SCOPE(name) utils::NoAllocScope ALLOC_CONCAT(noAllocScope, __LINE__)(name)
+#else
+#define NO_ALLOC_SCOPE(name) ((void)0)
+#endif
\ No newline at end of file
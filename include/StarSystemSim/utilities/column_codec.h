@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+
+	// Lossless packing of a column of 4 or 8 byte values: every value is replaced by the
+	// difference of its bit pattern to the previous one, the bytes are shuffled so that
+	// byte k of every value is stored together, and runs of zero bytes are collapsed.
+	// Smoothly changing columns end up mostly as zero runs.
+	void encodeColumn(const void* values, size_t count, size_t width, std::vector<uint8_t>& encoded);
+
+	// returns false if the data does not decode to exactly count values
+	bool decodeColumn(const uint8_t* encoded, size_t size, size_t count, size_t width, void* values);
+
+}
\ No newline at end of file
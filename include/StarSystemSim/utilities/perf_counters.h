@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+namespace utils {
+
+	// Hardware counters of the calling thread's user space work, read through
+	// perf_event_open on Linux. On other platforms, when the kernel refuses the
+	// events (see /proc/sys/kernel/perf_event_paranoid) or in a virtual machine
+	// without a PMU, open() fails and every value reads as zero. Work a thread
+	// hands to the pool is not counted.
+	class PerfCounters {
+	public:
+		enum class Counter {
+			CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES
+		};
+		static const uint32_t COUNTER_COUNT = (uint32_t)Counter::BRANCH_MISSES + 1;
+
+		struct Values {
+			uint64_t counts[COUNTER_COUNT];
+
+			inline uint64_t get(Counter counter) const { return counts[(uint32_t)counter]; }
+			// instructions per cycle, 0 without any cycles
+			double getIPC() const;
+
+			Values& operator+=(const Values& other);
+			Values operator-(const Values& other) const;
+		};
+
+		PerfCounters();
+		~PerfCounters();
+
+		// starts counting on the calling thread, true if at least one counter opened
+		bool open();
+		void close();
+		inline bool isOpen() const { return m_Leader >= 0; }
+		// PMUs without some of the events leave those at zero
+		inline bool hasCounter(Counter counter) const { return m_Fds[(uint32_t)counter] >= 0; }
+
+		// totals since open(), scaled up when the kernel had to share the PMU with others
+		Values read() const;
+
+		static const char* getCounterName(Counter counter);
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters& operator=(const PerfCounters&) = delete;
+
+	private:
+		int m_Fds[COUNTER_COUNT];
+		// the group is read through its first counter, values come in the order they were opened
+		int m_Leader;
+		Counter m_Order[COUNTER_COUNT];
+		uint32_t m_Opened;
+	};
+
+}
\ No newline at end of file
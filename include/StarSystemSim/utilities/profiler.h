@@ -0,0 +1,84 @@
+#pragma once
+
+#include "StarSystemSim/utilities/alloc_tracker.h"
+
+#include <cstdint>
+#include <vector>
+
+// zones compile to nothing when built with -DSTARSIM_PROFILER=0
+#ifndef STARSIM_PROFILER
+#define STARSIM_PROFILER 1
+#endif
+
+namespace utils {
+
+	// Timed zones recorded into a ring per thread. Only the owning thread writes
+	// its ring, so recording is two clock reads and a store; once a ring is full
+	// the oldest zones are overwritten. writeTrace() copies every ring without
+	// stopping the writers and saves them as Chrome trace events, which
+	// chrome://tracing and ui.perfetto.dev open.
+	class Profiler {
+	public:
+		struct Zone {
+			// has to outlive the profiler, zones take string literals
+			const char* name;
+			uint64_t start, end;
+			// made by the thread while the zone was open, nested zones included
+			uint64_t allocations, bytes;
+		};
+
+		static void setEnabled(bool enabled);
+		static bool isEnabled();
+
+		// shown for the calling thread in the trace
+		static void setThreadName(const char* name);
+
+		// nanoseconds since the profiler started
+		static uint64_t now();
+		static void record(const char* name, uint64_t start, uint64_t end,
+			uint64_t allocations = 0, uint64_t bytes = 0);
+
+		// zones of the calling thread that ended after since, oldest first
+		static void getThreadZones(uint64_t since, std::vector<Zone>& zones);
+
+		static bool writeTrace(const char* path);
+	};
+
+	class ProfileZone {
+	public:
+		inline ProfileZone(const char* name)
+			: m_Name(name), m_Start(Profiler::isEnabled() ? Profiler::now() : 0),
+			m_Allocations(AllocTracker::getThreadCounts())
+		{}
+
+		inline ~ProfileZone() { end(); }
+
+		// closes the zone before the end of its scope
+		inline void end() {
+			if (m_Start) {
+				AllocTracker::Counts allocations = AllocTracker::getThreadCounts();
+				Profiler::record(m_Name, m_Start, Profiler::now(), allocations.allocations - m_Allocations.allocations,
+					allocations.bytes - m_Allocations.bytes);
+			}
+			m_Start = 0;
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+		AllocTracker::Counts m_Allocations;
+	};
+
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if STARSIM_PROFILER
+#define PROFILE_ZONE(name) utils::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+	// Fixed set of worker threads for data-parallel loops.
+	class ThreadPool {
+	public:
+		// threadCount of 0 uses every hardware thread
+		ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// calls func(begin, end) on chunks of [begin, end) across the workers and
+		// the calling thread, returns once every chunk is done; loops started from
+		// several threads or from inside a chunk run side by side
+		void parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& func, size_t grain = 1);
+
+		inline uint32_t getThreadCount() const { return (uint32_t)m_Workers.size() + 1; }
+
+		static ThreadPool& getShared();
+
+	private:
+		struct Job {
+			const std::function<void(size_t, size_t)>* func;
+			size_t next, end, grain;
+			uint32_t busy;
+		};
+
+		std::vector<std::thread> m_Workers;
+		std::mutex m_Mutex;
+		std::condition_variable m_WorkReady;
+		std::condition_variable m_WorkDone;
+
+		// loops with chunks left to hand out, they live on their callers' stacks
+		std::vector<Job*> m_Jobs;
+		bool m_Quit;
+
+		void workerLoop();
+		void runChunks(std::unique_lock<std::mutex>& lock, Job& job);
+	};
+
+}
\ No newline at end of file
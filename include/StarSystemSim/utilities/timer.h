@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 namespace utils {
 
     class Timer {
@@ -7,7 +9,34 @@ namespace utils {
         float deltaTime = 0.0f;
         float lastTime = 0.0f;
 
-        float measureTime();
+        Timer();
+
+        // the clock's reading, deltaTime is set to the time since the last call
+        double measureTime();
+
+        // clock returns seconds, by default the steady clock since the first timer was made
+        void setClock(std::function<double()> clock);
+
+    private:
+        std::function<double()> m_Clock;
+        // deltas are taken in double, lastTime alone would round them once the clock grows
+        double m_LastTime;
+    };
+
+    // Clock that only moves when told to, for headless runs and replays,
+    // hand it to a timer through std::ref so the timer sees it advance.
+    class VirtualClock {
+    public:
+        VirtualClock(double time = 0.0) : m_Time(time) {}
+
+        inline void advance(double deltaTime) { m_Time += deltaTime; }
+        inline void setTime(double time) { m_Time = time; }
+        inline double getTime() const { return m_Time; }
+
+        inline double operator()() const { return m_Time; }
+
+    private:
+        double m_Time;
     };
 
 }
\ No newline at end of file
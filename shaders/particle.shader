@@ -0,0 +1,21 @@
+#vertex_shader
+#version 330 core
+
+layout (location=0) in vec3 pos;
+
+uniform mat4 _projMat;
+uniform mat4 _viewMat;
+
+void main() {
+	gl_Position = _projMat * _viewMat * vec4(pos, 1.0);
+	gl_PointSize = 2.0;
+}
+
+#fragment_shader
+#version 330 core
+
+layout (location=0) out vec4 outColor;
+
+void main() {
+	outColor = vec4(0.75, 0.7, 0.65, 1.0);
+}
\ No newline at end of file
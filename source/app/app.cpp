@@ -2,6 +2,7 @@
 #include "StarSystemSim/app/event_manager.h"
 #include "StarSystemSim/utilities/error.h"
 #include "StarSystemSim/graphics/renderer.h"
+#include "StarSystemSim/graphics/gl_call_counter.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_glfw.h>
@@ -10,6 +11,7 @@
 #include <glm/vec2.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <cstdlib>
 
 utils::Timer App::mainTimer;
@@ -25,6 +27,8 @@ void App::start(uint32_t width, uint32_t height) {
 
     // setting up window and OpenGL
     glfwInit();
+    mainTimer.setClock(glfwGetTime);
+    frameClock.setClock(glfwGetTime);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -52,6 +56,7 @@ void App::start(uint32_t width, uint32_t height) {
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         utils::fatalError("Failed to initialize GLAD");
     }
+    graphics::GLCallCounter::install();
 
     ImGui_ImplGlfw_InitForOpenGL(s_Window, true);
     ImGui_ImplOpenGL3_Init("#version 430 core");
@@ -103,6 +108,45 @@ graphics::Star* App::addToScene(graphics::Star& star) {
     return &star;
 }
 
+void App::removeFromScene(physics::Body* body, graphics::Object* replacement) {
+    if (!s_Instance)
+        return;
+
+    graphics::Scene& scene = s_Instance->scene;
+    graphics::Planet* owner = nullptr;
+
+    for (auto iter = scene.planets.begin(); iter != scene.planets.end(); ++iter) {
+        if (&(*iter)->body == body) {
+            owner = *iter;
+            scene.planets.erase(iter);
+            break;
+        }
+    }
+    if (!owner) {
+        for (auto iter = scene.stars.begin(); iter != scene.stars.end(); ++iter) {
+            if (&(*iter)->body == body) {
+                owner = *iter;
+                scene.stars.erase(iter);
+                break;
+            }
+        }
+    }
+    if (!owner)
+        return;
+
+    s_Instance->physicsEngine.remBody(body);
+
+    std::vector<graphics::Object*>& targets = s_Instance->camTargets;
+    targets.erase(std::remove(targets.begin(), targets.end(), (graphics::Object*)owner), targets.end());
+
+    if (s_Instance->mainCamera.target == owner)
+        s_Instance->mainCamera.target = replacement ? replacement : (targets.empty() ? nullptr : targets[0]);
+
+    if (s_Instance->onRemove)
+        s_Instance->onRemove(owner);
+    delete owner;
+}
+
 void App::setSkybox(const graphics::Skybox& skybox) {
     if (s_Instance) {
         s_Instance->scene.skybox = skybox;
@@ -120,6 +164,19 @@ App::App(uint32_t windowWidth, uint32_t windowHeight)
     renderer.resize(m_ScrWidth, m_ScrHeight);
     renderer.bindScene(&this->scene);
 
+    physicsEngine.setClock(glfwGetTime);
+    physicsEngine.onMerge = [this](physics::Body* survivor, physics::Body* absorbed) {
+        graphics::Object* survivorObject = nullptr;
+        for (graphics::Planet* planet : scene.planets)
+            if (&planet->body == survivor)
+                survivorObject = planet;
+        for (graphics::Star* star : scene.stars)
+            if (&star->body == survivor)
+                survivorObject = star;
+
+        App::removeFromScene(absorbed, survivorObject);
+    };
+
     this->isCursorVisible = true;
     this->isFirstMouseMovement = true;
     
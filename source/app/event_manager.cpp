@@ -3,6 +3,7 @@
 #include "StarSystemSim/graphics/camera.h"
 
 #include "StarSystemSim/utilities/error.h"
+#include "StarSystemSim/utilities/profiler.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -75,6 +76,9 @@ namespace app {
 	}
 
     void EventManager::key_press_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+        if (key == GLFW_KEY_F9 && action == GLFW_PRESS)
+            utils::Profiler::writeTrace("trace.json");
+
         if (glfwGetKey(window, GLFW_KEY_TAB) == GLFW_PRESS) {
             for (size_t i = 0; i < App::s_Instance->camTargets.size(); ++i) {
                 if (App::s_Instance->mainCamera.target == App::s_Instance->camTargets[i]) {
@@ -0,0 +1,368 @@
+#include "StarSystemSim/app/performance_hud.h"
+
+#include <imgui/imgui.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace app {
+
+    static const char* PHASE_NAMES[PerformanceHud::PHASE_COUNT] = {
+        "Physics", "Prediction",
+        "Skybox", "Stars", "Planets", "Lines", "Particles", "Post", "Render",
+        "ImGui", "Swap", "Sleep", "Other"
+    };
+
+    static const ImU32 PHASE_COLORS[PerformanceHud::PHASE_COUNT] = {
+        IM_COL32(230, 85, 70, 255), IM_COL32(240, 160, 60, 255),
+        IM_COL32(70, 90, 170, 255), IM_COL32(90, 130, 220, 255), IM_COL32(80, 180, 230, 255),
+        IM_COL32(70, 200, 180, 255), IM_COL32(110, 210, 120, 255), IM_COL32(170, 120, 220, 255), IM_COL32(120, 120, 160, 255),
+        IM_COL32(230, 210, 80, 255), IM_COL32(200, 200, 200, 255), IM_COL32(70, 70, 70, 255), IM_COL32(140, 100, 80, 255)
+    };
+
+    // zones inside "draw frame" and the pass they are charged to
+    static const struct {
+        const char* name;
+        PerformanceHud::Phase phase;
+    } RENDER_PASSES[] = {
+        { "skybox", PerformanceHud::Phase::SKYBOX },
+        { "stars", PerformanceHud::Phase::STARS },
+        { "planets", PerformanceHud::Phase::PLANETS },
+        { "lines", PerformanceHud::Phase::LINES },
+        { "particles", PerformanceHud::Phase::PARTICLES },
+        { "msaa blit", PerformanceHud::Phase::POST },
+        { "bloom", PerformanceHud::Phase::POST },
+        { "post", PerformanceHud::Phase::POST }
+    };
+
+    static const uint64_t RATE_WINDOW = 500000000;
+
+    PerformanceHud::PerformanceHud()
+        : m_FrameTimes(), m_PhaseTimes(), m_Frames(0), m_LastTime(utils::Profiler::now()),
+        m_RateTime(m_LastTime), m_RateInteractions(0), m_InteractionRate(0.0),
+        m_Bodies(0), m_Particles(0), m_DrawCalls(0),
+        m_Invariants(), m_Drift(), m_EnergyDrift(),
+        m_FrameAllocations(), m_PhaseAllocations(), m_FrameBytes(0), m_OtherThreadAllocations(0),
+        m_ThreadCounts(utils::AllocTracker::getThreadCounts()), m_TotalCounts(utils::AllocTracker::getTotalCounts()),
+        m_PhaseCountersStart(), m_PhaseCounters(), m_GlCalls()
+    {}
+
+    const char* PerformanceHud::getPhaseName(Phase phase) {
+        return PHASE_NAMES[(uint32_t)phase];
+    }
+
+    void PerformanceHud::collect(const physics::Engine& engine, uint32_t drawCalls) {
+        uint64_t now = utils::Profiler::now();
+        uint32_t frame = m_Frames % HISTORY;
+
+        m_FrameTimes[frame] = (now - m_LastTime) * 1e-6f;
+        float* phases = m_PhaseTimes[frame];
+        std::fill(phases, phases + PHASE_COUNT, 0.0f);
+
+        const utils::AllocTracker::Counts threadCounts = utils::AllocTracker::getThreadCounts();
+        const utils::AllocTracker::Counts totalCounts = utils::AllocTracker::getTotalCounts();
+        m_FrameAllocations[frame] = (float)(threadCounts.allocations - m_ThreadCounts.allocations);
+        m_FrameBytes = threadCounts.bytes - m_ThreadCounts.bytes;
+        m_OtherThreadAllocations = (totalCounts.allocations - m_TotalCounts.allocations) - (threadCounts.allocations - m_ThreadCounts.allocations);
+        m_ThreadCounts = threadCounts;
+        m_TotalCounts = totalCounts;
+
+        float* allocations = m_PhaseAllocations[frame];
+        std::fill(allocations, allocations + PHASE_COUNT, 0.0f);
+
+        utils::Profiler::getThreadZones(m_LastTime, m_Zones);
+        addZones(phases, allocations);
+
+        float attributed = 0.0f, attributedAllocations = 0.0f;
+        for (uint32_t phase = 0; phase < PHASE_COUNT; ++phase) {
+            attributed += phases[phase];
+            attributedAllocations += allocations[phase];
+        }
+        phases[(uint32_t)Phase::OTHER] = std::max(0.0f, m_FrameTimes[frame] - attributed);
+        allocations[(uint32_t)Phase::OTHER] = std::max(0.0f, m_FrameAllocations[frame] - attributedAllocations);
+
+        uint64_t interactions = engine.getInteractionCount();
+        if (m_Frames == 0)
+            m_RateInteractions = interactions;
+        if (now - m_RateTime >= RATE_WINDOW) {
+            m_InteractionRate = (interactions - m_RateInteractions) * 1e9 / (now - m_RateTime);
+            m_RateTime = now;
+            m_RateInteractions = interactions;
+
+            for (uint32_t phase = 0; phase < physics::Engine::PHASE_COUNT; ++phase) {
+                const physics::Engine::PhaseCounters& counters = engine.getPhaseCounters((physics::Engine::Phase)phase);
+                physics::Engine::PhaseCounters& start = m_PhaseCountersStart[phase];
+                m_PhaseCounters[phase] = { counters.values - start.values, counters.interactions - start.interactions, counters.runs - start.runs };
+                start = counters;
+            }
+        }
+
+        m_Bodies = engine.getBodyCount();
+        m_Particles = engine.getParticleCount();
+        m_DrawCalls = drawCalls;
+        m_GlCalls[frame] = (float)graphics::GLCallCounter::getLastFrame().getCalls();
+
+        m_Invariants = engine.getInvariants();
+        m_Drift = engine.getDrift();
+        m_EnergyDrift[frame] = (float)std::log10(std::max(m_Drift.energy, 1e-12));
+
+        m_LastTime = now;
+        m_Frames += 1;
+    }
+
+    void PerformanceHud::addZones(float* phases, float* allocations) const {
+        // the engine and the renderer both have a "particles" zone, passes are told apart by lying inside a draw
+        auto isRenderPass = [this](const utils::Profiler::Zone& zone) {
+            for (const utils::Profiler::Zone& draw : m_Zones) {
+                if (!std::strcmp(draw.name, "draw frame") && draw.start <= zone.start && zone.end <= draw.end)
+                    return true;
+            }
+            return false;
+        };
+
+        for (const utils::Profiler::Zone& zone : m_Zones) {
+            // a zone nested in another one is taken out of its parent's phase
+            int phase = -1, parent = -1;
+
+            if (!std::strcmp(zone.name, "engine update"))
+                phase = (int)Phase::PHYSICS;
+            else if (!std::strcmp(zone.name, "prediction")) {
+                phase = (int)Phase::PREDICTION;
+                parent = (int)Phase::PHYSICS;
+            }
+            else if (!std::strcmp(zone.name, "draw frame"))
+                phase = (int)Phase::RENDER;
+            else if (!std::strcmp(zone.name, "imgui"))
+                phase = (int)Phase::IMGUI;
+            else if (!std::strcmp(zone.name, "swap"))
+                phase = (int)Phase::SWAP;
+            else if (!std::strcmp(zone.name, "frame cap"))
+                phase = (int)Phase::SLEEP;
+            else {
+                for (const auto& pass : RENDER_PASSES) {
+                    if (!std::strcmp(zone.name, pass.name) && isRenderPass(zone)) {
+                        phase = (int)pass.phase;
+                        parent = (int)Phase::RENDER;
+                        break;
+                    }
+                }
+            }
+
+            if (phase < 0)
+                continue;
+
+            float time = (zone.end - zone.start) * 1e-6f;
+            phases[phase] += time;
+            allocations[phase] += (float)zone.allocations;
+            if (parent >= 0) {
+                phases[parent] -= time;
+                allocations[parent] -= (float)zone.allocations;
+            }
+        }
+    }
+
+    float PerformanceHud::getPercentile(float fraction) const {
+        if (m_Sorted.empty())
+            return 0.0f;
+        return m_Sorted[(size_t)std::lround(fraction * (m_Sorted.size() - 1))];
+    }
+
+    void PerformanceHud::draw(bool* open) {
+        if (!ImGui::Begin("Performance", open, ImGuiWindowFlags_NoFocusOnAppearing)) {
+            ImGui::End();
+            return;
+        }
+
+        const uint32_t count = m_Frames < HISTORY ? m_Frames : HISTORY;
+        // oldest frame first
+        const uint32_t first = m_Frames > HISTORY ? m_Frames % HISTORY : 0;
+
+        m_Sorted.assign(m_FrameTimes, m_FrameTimes + count);
+        std::sort(m_Sorted.begin(), m_Sorted.end());
+        float mean = 0.0f;
+        for (float time : m_Sorted)
+            mean += time;
+        mean /= std::max(count, 1u);
+        const float maxTime = m_Sorted.empty() ? 0.0f : m_Sorted.back();
+
+        ImGui::Text("%.1f FPS  %.2f ms mean", mean > 0.0f ? 1000.0f / mean : 0.0f, mean);
+        ImGui::Text("p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms", getPercentile(0.5f), getPercentile(0.95f), getPercentile(0.99f), maxTime);
+
+        // both graphs share the scale, never below a 144 Hz frame
+        const float scale = std::max(maxTime, 1000.0f / 144.0f);
+        const float width = std::max(ImGui::GetContentRegionAvail().x, 64.0f);
+
+        ImGui::PlotLines("##frame times", m_FrameTimes, count, first, nullptr, 0.0f, scale, ImVec2(width, 60.0f));
+
+        // one stacked bar per frame, phases bottom up in declaration order
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        const ImVec2 size(width, 100.0f);
+        ImGui::InvisibleButton("##phases", size);
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        drawList->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+        const float barWidth = size.x / HISTORY;
+        for (uint32_t i = 0; i < count; ++i) {
+            const float* phases = m_PhaseTimes[(first + i) % HISTORY];
+            float x = origin.x + i * barWidth;
+            float y = origin.y + size.y;
+
+            for (uint32_t phase = 0; phase < PHASE_COUNT; ++phase) {
+                float height = phases[phase] / scale * size.y;
+                if (height <= 0.0f)
+                    continue;
+                drawList->AddRectFilled(ImVec2(x, std::max(y - height, origin.y)), ImVec2(x + barWidth, y), PHASE_COLORS[phase]);
+                y -= height;
+            }
+        }
+
+        if (ImGui::IsItemHovered() && count) {
+            uint32_t i = std::min((uint32_t)((ImGui::GetIO().MousePos.x - origin.x) / barWidth), count - 1);
+            const float* phases = m_PhaseTimes[(first + i) % HISTORY];
+
+            ImGui::BeginTooltip();
+            ImGui::Text("%.2f ms", m_FrameTimes[(first + i) % HISTORY]);
+            const float* allocations = m_PhaseAllocations[(first + i) % HISTORY];
+            for (uint32_t phase = 0; phase < PHASE_COUNT; ++phase)
+                ImGui::Text("%-10s %6.2f ms %4.0f allocs", PHASE_NAMES[phase], phases[phase], allocations[phase]);
+            ImGui::EndTooltip();
+        }
+
+        // legend with the mean of every phase over the history
+        for (uint32_t phase = 0; phase < PHASE_COUNT; ++phase) {
+            float total = 0.0f, totalAllocations = 0.0f;
+            for (uint32_t i = 0; i < count; ++i) {
+                total += m_PhaseTimes[i][phase];
+                totalAllocations += m_PhaseAllocations[i][phase];
+            }
+
+            ImGui::ColorButton(PHASE_NAMES[phase], ImGui::ColorConvertU32ToFloat4(PHASE_COLORS[phase]), ImGuiColorEditFlags_NoTooltip, ImVec2(10.0f, 10.0f));
+            ImGui::SameLine();
+            ImGui::Text("%-10s %6.2f ms %5.1f allocs", PHASE_NAMES[phase], total / std::max(count, 1u), totalAllocations / std::max(count, 1u));
+            if (phase % 2 == 0 && phase + 1 < PHASE_COUNT)
+                ImGui::SameLine(width * 0.5f);
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Bodies: %zu  Particles: %zu", m_Bodies, m_Particles);
+        ImGui::Text("Pair interactions: %.3g /s", m_InteractionRate);
+        ImGui::Text("Draw calls: %u", m_DrawCalls);
+
+        // GL calls of the last frame by entry point, the ones a frame should not need highlighted
+        using graphics::GLCallCounter;
+        if (!GLCallCounter::isInstalled())
+            ImGui::TextDisabled("GL calls not counted, build with STARSIM_GL_DEBUG=1");
+        else {
+            const GLCallCounter::Frame& calls = GLCallCounter::getLastFrame();
+            float maxCalls = 1.0f;
+            for (uint32_t i = 0; i < count; ++i)
+                maxCalls = std::max(maxCalls, m_GlCalls[i]);
+
+            ImGui::Text("GL calls: %u  redundant %u  queries %u", calls.getCalls(), calls.getRedundant(), calls.getQueries());
+            ImGui::PlotHistogram("##gl calls", m_GlCalls, count, first, nullptr, 0.0f, maxCalls, ImVec2(width, 40.0f));
+
+            m_GlEntries.clear();
+            for (uint32_t entry = 0; entry < GLCallCounter::ENTRY_COUNT; ++entry) {
+                if (calls.calls[entry])
+                    m_GlEntries.push_back(entry);
+            }
+            std::sort(m_GlEntries.begin(), m_GlEntries.end(), [&calls](uint32_t a, uint32_t b) { return calls.calls[a] > calls.calls[b]; });
+
+            if (ImGui::TreeNode("GL entry points")) {
+                if (ImGui::BeginTable("##gl entries", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+                    ImGui::TableSetupColumn("Entry point");
+                    ImGui::TableSetupColumn("Calls");
+                    ImGui::TableSetupColumn("Redundant");
+                    ImGui::TableHeadersRow();
+
+                    const ImVec4 warning(1.0f, 0.6f, 0.3f, 1.0f);
+                    for (uint32_t entry : m_GlEntries) {
+                        GLCallCounter::Kind kind = GLCallCounter::getEntryKind(entry);
+                        bool flagged = kind == GLCallCounter::Kind::QUERY || kind == GLCallCounter::Kind::LOOKUP || calls.redundant[entry];
+
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        if (flagged)
+                            ImGui::TextColored(warning, "%s", GLCallCounter::getEntryName(entry));
+                        else
+                            ImGui::TextUnformatted(GLCallCounter::getEntryName(entry));
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%u", calls.calls[entry]);
+                        ImGui::TableNextColumn();
+                        if (kind == GLCallCounter::Kind::BIND)
+                            ImGui::Text("%u", calls.redundant[entry]);
+                        else if (kind != GLCallCounter::Kind::CALL)
+                            ImGui::TextUnformatted(kind == GLCallCounter::Kind::QUERY ? "query" : "lookup");
+                    }
+                    ImGui::EndTable();
+                }
+                ImGui::TreePop();
+            }
+        }
+
+        // main thread allocations, the legend above splits them by phase
+        ImGui::Separator();
+        float meanAllocations = 0.0f, maxAllocations = 1.0f;
+        for (uint32_t i = 0; i < count; ++i) {
+            meanAllocations += m_FrameAllocations[i];
+            maxAllocations = std::max(maxAllocations, m_FrameAllocations[i]);
+        }
+        meanAllocations /= std::max(count, 1u);
+
+        ImGui::Text("Allocations: %.1f per frame (%llu bytes last frame), %llu in other threads",
+            meanAllocations, (unsigned long long)m_FrameBytes, (unsigned long long)m_OtherThreadAllocations);
+        ImGui::PlotHistogram("##allocations", m_FrameAllocations, count, first, nullptr, 0.0f, maxAllocations, ImVec2(width, 40.0f));
+        if (utils::AllocTracker::getViolations()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "%llu no-allocation scopes allocated, last \"%s\"",
+                (unsigned long long)utils::AllocTracker::getViolations(), utils::AllocTracker::getLastViolation());
+        }
+
+        // hardware counters per phase, misses per pair interaction or per step for phases without pairs
+        ImGui::Separator();
+        bool counting = false;
+        for (const physics::Engine::PhaseCounters& counters : m_PhaseCounters)
+            counting |= counters.values.get(utils::PerfCounters::Counter::CYCLES) != 0;
+
+        if (!counting)
+            ImGui::TextDisabled("Hardware counters off, start with --perf-counters on Linux");
+        else if (ImGui::BeginTable("##counters", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            const char* headers[] = { "Phase", "IPC", "L1D miss", "LLC miss", "Br miss", "per" };
+            for (const char* header : headers)
+                ImGui::TableSetupColumn(header);
+            ImGui::TableHeadersRow();
+
+            using Counter = utils::PerfCounters::Counter;
+            for (uint32_t phase = 0; phase < physics::Engine::PHASE_COUNT; ++phase) {
+                const physics::Engine::PhaseCounters& counters = m_PhaseCounters[phase];
+                if (!counters.runs)
+                    continue;
+
+                double per = (double)(counters.interactions ? counters.interactions : counters.runs);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(physics::Engine::getPhaseName((physics::Engine::Phase)phase));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", counters.values.getIPC());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4g", counters.values.get(Counter::L1D_MISSES) / per);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4g", counters.values.get(Counter::LLC_MISSES) / per);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.4g", counters.values.get(Counter::BRANCH_MISSES) / per);
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(counters.interactions ? "pair" : "step");
+            }
+            ImGui::EndTable();
+        }
+
+        // against the first integrated step since bodies were last added or removed
+        ImGui::Separator();
+        ImGui::Text("Energy: %.6g (kinetic %.4g, potential %.4g)", m_Invariants.getEnergy(), m_Invariants.kinetic, m_Invariants.potential);
+        ImGui::Text("Drift: energy %.2e  momentum %.2e  angular momentum %.2e", m_Drift.energy, m_Drift.momentum, m_Drift.angularMomentum);
+        ImGui::PlotLines("##energy drift", m_EnergyDrift, count, first, "log10 energy drift", -12.0f, 0.0f, ImVec2(width, 40.0f));
+
+        ImGui::End();
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,475 @@
+#include "StarSystemSim/bench/work_precision.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/particle_system.h"
+#include "StarSystemSim/physics/ephemeris.h"
+#include "StarSystemSim/physics/integrator.h"
+
+#include "StarSystemSim/utilities/error.h"
+#include "StarSystemSim/utilities/alloc_tracker.h"
+#include "StarSystemSim/utilities/perf_counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static void printUsage() {
+    fprintf(stderr,
+        "usage: starsim_bench [options]\n"
+        "       starsim_bench --work-precision [--filter <text>] [--budget <s>] [--output <path>]\n"
+        "  --work-precision     error against cost of every solver and step on the reference scenarios\n"
+        "  --filter <text>      only benchmarks, scenarios or solvers whose name contains text\n"
+        "  --min-n <n>          smallest body count (default 2)\n"
+        "  --max-n <n>          largest body count (default 1000000)\n"
+        "  --min-time <s>       time spent measuring each case (default 0.2)\n"
+        "  --repeat <n>         rounds over every case, the fastest is kept (default 3)\n"
+        "  --budget <s>         skip body counts whose single run would take longer (default 5)\n"
+        "  --output <path>      write the results as json (default stdout)\n"
+        "  --baseline <path>    compare the fastest batches against results written before, fails on regressions\n"
+        "  --tolerance <ratio>  slowdown per interaction that counts as a regression (default 0.1)\n"
+        "  --perf-counters      add ipc and cache and branch misses per interaction, Linux only\n");
+}
+
+// bodies on circular orbits around a heavy static one, small enough that they rarely touch
+static std::vector<physics::Body> makeBodies(size_t count) {
+    std::vector<physics::Body> bodies(count);
+    if (count == 0)
+        return bodies;
+
+    bodies[0].pos = glm::vec3(0.0f);
+    bodies[0].vel = glm::vec3(0.0f);
+    bodies[0].mass = 1000.0f;
+    bodies[0].radius = 1.0f;
+    bodies[0].type = physics::Body::Type::STATIC;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (size_t i = 1; i < count; ++i) {
+        float radius = 5.0f + 45.0f * unit(random);
+        float angle = 6.2831853f * unit(random);
+        float speed = std::sqrt(physics::GRAVITATIONAL_CONSTANT * bodies[0].mass / radius);
+
+        physics::Body& body = bodies[i];
+        body.pos = glm::vec3(radius * std::cos(angle), 0.1f * (unit(random) - 0.5f), radius * std::sin(angle));
+        body.vel = glm::vec3(-speed * std::sin(angle), 0.0f, speed * std::cos(angle));
+        body.mass = 0.001f;
+        body.radius = 0.001f;
+        body.type = physics::Body::Type::DYNAMIC;
+    }
+    return bodies;
+}
+
+struct Fixture {
+    physics::Engine engine;
+    std::vector<physics::Body> bodies;
+    physics::ParticleSystem particles;
+    physics::Ephemeris ephemeris;
+};
+
+struct Benchmark {
+    const char* name;
+    // what one interaction is, so results of different phases read alike
+    const char* unit;
+    // how the cost of a run grows with n, including the setup
+    double exponent;
+    std::function<double(size_t n)> interactions;
+    std::function<std::function<void()>(Fixture& fixture, size_t n)> setup;
+};
+
+static double pairs(size_t n) {
+    return 0.5 * (double)n * (double)(n > 0 ? n - 1 : 0);
+}
+
+static std::vector<Benchmark> makeBenchmarks() {
+    using physics::Engine;
+    const float deltaTime = 0.01f;
+
+    auto enginePhase = [deltaTime](Engine::Phase phase) {
+        return [phase, deltaTime](Fixture& fixture, size_t n) -> std::function<void()> {
+            fixture.bodies = makeBodies(n);
+            fixture.engine.addBodies(fixture.bodies);
+            Engine* engine = &fixture.engine;
+            return [engine, phase, deltaTime]() { engine->runPhase(phase, deltaTime); };
+        };
+    };
+
+    std::vector<Benchmark> benchmarks;
+    benchmarks.push_back({ "gravity", "pair", 2.0, pairs, enginePhase(Engine::Phase::GRAVITY) });
+    benchmarks.push_back({ "advance", "body", 1.0, [](size_t n) { return (double)n; }, enginePhase(Engine::Phase::ADVANCE) });
+    benchmarks.push_back({ "collisions", "body", 1.0, [](size_t n) { return (double)n; }, enginePhase(Engine::Phase::COLLISIONS) });
+
+    // n particles around the three bodies of the default scene
+    benchmarks.push_back({ "particles", "particle-body", 1.0, [](size_t n) { return 3.0 * n; },
+        [deltaTime](Fixture& fixture, size_t n) -> std::function<void()> {
+            fixture.bodies = makeBodies(3);
+            physics::Body* bodies = fixture.engine.addBodies(fixture.bodies);
+            fixture.particles.addRing(bodies[0], 10.0f, 20.0f, n, 0.5f);
+            fixture.engine.addParticleSystem(&fixture.particles);
+            Engine* engine = &fixture.engine;
+            return [engine, deltaTime]() { engine->runPhase(Engine::Phase::PARTICLES, deltaTime); };
+        } });
+
+    // the future backends: the integrated preview, the one evaluated from an ephemeris and the snapshot integrators
+    benchmarks.push_back({ "prediction", "pair-step", 2.0, [](size_t n) { return pairs(n) * (physics::PREDICTION_STEPS - 1); },
+        enginePhase(Engine::Phase::PREDICTION) });
+    benchmarks.push_back({ "ephemeris_prediction", "body-step", 2.0, [](size_t n) { return (double)n * (physics::PREDICTION_STEPS - 1); },
+        [deltaTime](Fixture& fixture, size_t n) -> std::function<void()> {
+            fixture.bodies = makeBodies(n);
+            fixture.engine.addBodies(fixture.bodies);
+            // coarse steps, only the evaluation is measured
+            fixture.ephemeris.build(fixture.bodies, 0.0, physics::PREDICTION_STEPS * physics::PREDICTION_STEP + 1.0, 1.0f, 12, 0.04f);
+            fixture.engine.setEphemeris(&fixture.ephemeris);
+            Engine* engine = &fixture.engine;
+            return [engine, deltaTime]() { engine->runPhase(Engine::Phase::EPHEMERIS_PREDICTION, deltaTime); };
+        } });
+
+    const physics::Integrator methods[] = { physics::Integrator::EULER, physics::Integrator::LEAPFROG, physics::Integrator::RK4 };
+    const char* names[] = { "integrate_euler", "integrate_leapfrog", "integrate_rk4" };
+    const double evaluations[] = { 1.0, 2.0, 4.0 };
+    for (int i = 0; i < 3; ++i) {
+        physics::Integrator method = methods[i];
+        double perStep = evaluations[i];
+        benchmarks.push_back({ names[i], "pair", 2.0, [perStep](size_t n) { return perStep * pairs(n); },
+            [method, deltaTime](Fixture& fixture, size_t n) -> std::function<void()> {
+                fixture.bodies = makeBodies(n);
+                std::vector<physics::Body>* bodies = &fixture.bodies;
+                return [bodies, method, deltaTime]() { physics::integrate(*bodies, deltaTime, method); };
+            } });
+    }
+
+    return benchmarks;
+}
+
+struct Result {
+    std::string name;
+    const char* unit;
+    size_t n;
+    uint64_t runs;
+    double nsPerInteraction;
+    // of the fastest batch, what the baseline comparison uses
+    double minNsPerInteraction;
+    double stepsPerSecond;
+    double allocsPerStep;
+    // only filled in while hardware counters are open
+    double ipc, l1dMissesPerInteraction, llcMissesPerInteraction, branchMissesPerInteraction;
+};
+
+struct Measurement {
+    double seconds;
+    double fastest;
+    uint64_t runs;
+    double allocsPerRun;
+    // summed over every run
+    utils::PerfCounters::Values counters;
+};
+
+static double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// median and fastest time per run over batches of at least 10ms, one run is already done as the warm-up
+static Measurement measure(const std::function<void()>& run, double warmUp, double minTime, const utils::PerfCounters& perfCounters) {
+    const uint64_t batch = std::max<uint64_t>(1, (uint64_t)(0.01 / std::max(warmUp, 1e-9)));
+    std::vector<double> samples;
+    uint64_t runs = 0, allocations = 0;
+    utils::PerfCounters::Values counters = {};
+
+    double start = now();
+    while (samples.size() < 5 || now() - start < minTime) {
+        // only the runs are counted, not the samples growing
+        uint64_t allocationsBefore = utils::AllocTracker::getTotalCounts().allocations;
+        utils::PerfCounters::Values countersBefore = perfCounters.read();
+        double batchStart = now();
+        for (uint64_t i = 0; i < batch; ++i)
+            run();
+        double batchTime = now() - batchStart;
+        counters += perfCounters.read() - countersBefore;
+        allocations += utils::AllocTracker::getTotalCounts().allocations - allocationsBefore;
+
+        samples.push_back(batchTime / batch);
+        runs += batch;
+
+        // a run longer than the whole measurement is only taken once
+        if (samples.back() >= minTime)
+            break;
+    }
+
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    double median = samples[samples.size() / 2];
+    return { median, *std::min_element(samples.begin(), samples.end()), runs, (double)allocations / runs, counters };
+}
+
+struct Case {
+    const Benchmark* benchmark;
+    size_t n;
+    Measurement measurement;
+};
+
+// sets the case up on a fresh fixture and measures it, returns what the setup and a single run cost
+static double runCase(const Benchmark& benchmark, size_t n, double minTime, const utils::PerfCounters& perfCounters,
+    Measurement& measurement)
+{
+    double start = now();
+    std::unique_ptr<Fixture> fixture(new Fixture());
+    std::function<void()> run = benchmark.setup(*fixture, n);
+    double setup = now() - start;
+
+    double warmUpStart = now();
+    run();
+    double warmUp = now() - warmUpStart;
+
+    measurement = measure(run, warmUp, minTime, perfCounters);
+    return setup + std::max(warmUp, measurement.seconds);
+}
+
+static bool writeResults(const char* path, const std::vector<Result>& results, bool counters) {
+    FILE* file = path ? fopen(path, "w") : stdout;
+    if (!file) {
+        utils::printError("Failed to open %s", path);
+        return false;
+    }
+
+#ifdef NDEBUG
+    const char* build = "optimized";
+#else
+    const char* build = "debug";
+#endif
+    // one result per line, the baseline reader relies on it
+    fprintf(file, "{\n  \"build\": \"%s\",\n  \"results\": [\n", build);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"n\": %zu, \"unit\": \"%s\", \"runs\": %llu, \"ns_per_interaction\": %.6g, "
+            "\"min_ns_per_interaction\": %.6g, \"steps_per_second\": %.6g, \"allocs_per_step\": %.6g",
+            result.name.c_str(), result.n, result.unit, (unsigned long long)result.runs, result.nsPerInteraction,
+            result.minNsPerInteraction, result.stepsPerSecond, result.allocsPerStep);
+        if (counters) {
+            fprintf(file, ", \"ipc\": %.4g, \"l1d_misses_per_interaction\": %.4g, \"llc_misses_per_interaction\": %.4g, "
+                "\"branch_misses_per_interaction\": %.4g", result.ipc, result.l1dMissesPerInteraction,
+                result.llcMissesPerInteraction, result.branchMissesPerInteraction);
+        }
+        fprintf(file, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    if (path)
+        fclose(file);
+    return true;
+}
+
+// reads the lines writeResults() produces, not json in general
+static bool readBaseline(const char* path, std::vector<Result>& results) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        utils::printError("Failed to open baseline %s, store one with starsim_bench --output %s (make bench_baseline)", path, path);
+        return false;
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        const char* name = strstr(line, "\"name\": \"");
+        const char* n = strstr(line, "\"n\": ");
+        const char* ns = strstr(line, "\"ns_per_interaction\": ");
+        const char* minNs = strstr(line, "\"min_ns_per_interaction\": ");
+        if (!name || !n || !ns)
+            continue;
+
+        name += strlen("\"name\": \"");
+        const char* nameEnd = strchr(name, '"');
+        if (!nameEnd)
+            continue;
+
+        Result result = {};
+        result.name.assign(name, nameEnd);
+        result.n = (size_t)strtoull(n + strlen("\"n\": "), nullptr, 10);
+        result.nsPerInteraction = strtod(ns + strlen("\"ns_per_interaction\": "), nullptr);
+        // baselines from before the fastest batch was recorded only have the median
+        result.minNsPerInteraction = minNs ? strtod(minNs + strlen("\"min_ns_per_interaction\": "), nullptr) : result.nsPerInteraction;
+        results.push_back(result);
+    }
+
+    fclose(file);
+    return true;
+}
+
+// returns the number of cases slower than the baseline by more than tolerance, interference
+// only ever slows a batch down, so the fastest batches are the ones compared
+static size_t compare(const std::vector<Result>& results, const std::vector<Result>& baseline, double tolerance) {
+    size_t regressions = 0, compared = 0;
+
+    for (const Result& result : results) {
+        auto it = std::find_if(baseline.begin(), baseline.end(), [&](const Result& old) {
+            return old.name == result.name && old.n == result.n;
+        });
+        if (it == baseline.end() || it->minNsPerInteraction <= 0.0)
+            continue;
+
+        compared += 1;
+        double change = result.minNsPerInteraction / it->minNsPerInteraction - 1.0;
+        if (change > tolerance) {
+            regressions += 1;
+            utils::printError("%s n=%zu: %.4g ns per interaction against %.4g (%+.1f%%)", result.name.c_str(), result.n,
+                result.minNsPerInteraction, it->minNsPerInteraction, 100.0 * change);
+        }
+    }
+
+    utils::print("%zu of %zu cases compared with the baseline regressed by more than %.0f%%", regressions, compared, 100.0 * tolerance);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    size_t minN = 2, maxN = 1000000;
+    double minTime = 0.2, budget = 5.0;
+    uint32_t repeat = 3;
+    const char* outputPath = nullptr;
+    const char* baselinePath = nullptr;
+    double tolerance = 0.1;
+    bool workPrecision = false;
+    bool countersRequested = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(argv[i], "--work-precision"))
+            workPrecision = true;
+        else if (!strcmp(argv[i], "--filter") && hasValue)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "--min-n") && hasValue)
+            minN = std::max<size_t>(2, strtoull(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--max-n") && hasValue)
+            maxN = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--min-time") && hasValue)
+            minTime = strtod(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--repeat") && hasValue)
+            repeat = std::max<uint32_t>(1, (uint32_t)strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--budget") && hasValue)
+            budget = strtod(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--output") && hasValue)
+            outputPath = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && hasValue)
+            baselinePath = argv[++i];
+        else if (!strcmp(argv[i], "--tolerance") && hasValue)
+            tolerance = strtod(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--perf-counters"))
+            countersRequested = true;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+#ifndef NDEBUG
+    utils::printError("Built without NDEBUG, configure with -DCMAKE_BUILD_TYPE=Release for numbers worth comparing");
+#endif
+
+    if (workPrecision) {
+        bench::WorkPrecisionSettings settings;
+        settings.filter = filter;
+        settings.budget = budget;
+        settings.outputPath = outputPath;
+        return bench::runWorkPrecision(settings);
+    }
+
+    // powers of four from 2 and the largest count itself
+    std::vector<size_t> sizes;
+    for (size_t n = 2; n < maxN; n *= 4) {
+        if (n >= minN)
+            sizes.push_back(n);
+    }
+    sizes.push_back(maxN);
+
+    // the runs happen on this thread, a case that uses the pool only counts its share
+    utils::PerfCounters perfCounters;
+    const bool counters = countersRequested && perfCounters.open();
+
+    // the first round picks the body counts within the budget, the later ones measure the same cases again
+    // on fresh fixtures, so a stretch of interference on the machine does not hit every repeat of a case
+    const std::vector<Benchmark> benchmarks = makeBenchmarks();
+    std::vector<Case> cases;
+    for (const Benchmark& benchmark : benchmarks) {
+        if (filter && !strstr(benchmark.name, filter))
+            continue;
+
+        double lastCost = 0.0;
+        size_t lastN = 0;
+        for (size_t n : sizes) {
+            if (lastN && lastCost * std::pow((double)n / lastN, benchmark.exponent) > budget) {
+                utils::print("%s: skipping n >= %zu, a run would take longer than %.1fs", benchmark.name, n, budget);
+                break;
+            }
+
+            Case entry = { &benchmark, n, {} };
+            lastCost = runCase(benchmark, n, minTime, perfCounters, entry.measurement);
+            lastN = n;
+            cases.push_back(entry);
+        }
+    }
+
+    for (uint32_t round = 1; round < repeat; ++round) {
+        utils::print("Round %u of %u", round + 1, repeat);
+        for (Case& entry : cases) {
+            Measurement again;
+            runCase(*entry.benchmark, entry.n, minTime, perfCounters, again);
+
+            // the lowest median is reported, the fastest batch of all rounds is compared
+            again.fastest = std::min(again.fastest, entry.measurement.fastest);
+            if (again.seconds < entry.measurement.seconds)
+                entry.measurement = again;
+            else
+                entry.measurement.fastest = again.fastest;
+        }
+    }
+
+    std::vector<Result> results;
+    for (const Case& entry : cases) {
+        const Benchmark& benchmark = *entry.benchmark;
+        const Measurement& measurement = entry.measurement;
+        const size_t n = entry.n;
+
+        double interactions = benchmark.interactions(n);
+        Result result = { benchmark.name, benchmark.unit, n, measurement.runs,
+            interactions > 0.0 ? 1e9 * measurement.seconds / interactions : 0.0,
+            interactions > 0.0 ? 1e9 * measurement.fastest / interactions : 0.0,
+            measurement.seconds > 0.0 ? 1.0 / measurement.seconds : 0.0, measurement.allocsPerRun,
+            measurement.counters.getIPC(), 0.0, 0.0, 0.0 };
+
+        double counted = interactions * measurement.runs;
+        if (counted > 0.0) {
+            using Counter = utils::PerfCounters::Counter;
+            result.l1dMissesPerInteraction = measurement.counters.get(Counter::L1D_MISSES) / counted;
+            result.llcMissesPerInteraction = measurement.counters.get(Counter::LLC_MISSES) / counted;
+            result.branchMissesPerInteraction = measurement.counters.get(Counter::BRANCH_MISSES) / counted;
+        }
+        results.push_back(result);
+
+        fprintf(stderr, "%-22s n=%-8zu %10.3f ns/%s %12.1f steps/s %8.1f allocs/step", result.name.c_str(), n,
+            result.nsPerInteraction, result.unit, result.stepsPerSecond, result.allocsPerStep);
+        if (counters) {
+            fprintf(stderr, " %6.2f ipc %8.4f l1d %8.4f llc %8.4f br /%s", result.ipc, result.l1dMissesPerInteraction,
+                result.llcMissesPerInteraction, result.branchMissesPerInteraction, result.unit);
+        }
+        fprintf(stderr, "\n");
+    }
+
+    if (!writeResults(outputPath, results, counters))
+        return 1;
+
+    if (baselinePath) {
+        std::vector<Result> baseline;
+        if (!readBaseline(baselinePath, baseline))
+            return 1;
+        if (compare(results, baseline, tolerance) > 0)
+            return 2;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,348 @@
+#include "StarSystemSim/bench/work_precision.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/integrator.h"
+#include "StarSystemSim/physics/parareal.h"
+#include "StarSystemSim/physics/diagnostics.h"
+
+#include "StarSystemSim/utilities/thread_pool.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+    struct Scenario {
+        const char* name;
+        std::vector<physics::Body> bodies;
+        double duration;
+        // steps run from largestStep down by halving
+        float largestStep;
+        uint32_t halvings;
+    };
+
+    static physics::Body makeBody(const glm::vec3& pos, const glm::vec3& vel, float mass, bool dynamic = true) {
+        physics::Body body(pos, mass);
+        body.vel = vel;
+        body.type = dynamic ? physics::Body::Type::DYNAMIC : physics::Body::Type::STATIC;
+        return body;
+    }
+
+    // a body on an orbit around center, starting at its apoapsis on the x axis
+    static physics::Body makeOrbit(const physics::Body& center, float mass, float apoapsis, float eccentricity) {
+        float mu = physics::GRAVITATIONAL_CONSTANT * (center.mass + mass);
+        float semiMajorAxis = apoapsis / (1.0f + eccentricity);
+        float speed = std::sqrt(mu / semiMajorAxis * (1.0f - eccentricity) / (1.0f + eccentricity));
+        return makeBody(center.pos + glm::vec3(apoapsis, 0.0f, 0.0f), center.vel + glm::vec3(0.0f, 0.0f, speed), mass);
+    }
+
+    // moves the dynamic bodies into their centre of mass frame
+    static void centre(std::vector<physics::Body>& bodies) {
+        glm::vec3 pos(0.0f), vel(0.0f);
+        float mass = 0.0f;
+        for (const physics::Body& body : bodies) {
+            pos += body.pos * body.mass;
+            vel += body.vel * body.mass;
+            mass += body.mass;
+        }
+        for (physics::Body& body : bodies) {
+            body.pos -= pos / mass;
+            body.vel -= vel / mass;
+        }
+    }
+
+    static std::vector<Scenario> makeScenarios() {
+        std::vector<Scenario> scenarios;
+        const float mu = physics::GRAVITATIONAL_CONSTANT * 1000.0f;
+        const float pi = 3.14159265f;
+
+        // eccentric two body orbit over two periods
+        {
+            std::vector<physics::Body> bodies = { makeBody(glm::vec3(0.0f), glm::vec3(0.0f), 1000.0f) };
+            bodies.push_back(makeOrbit(bodies[0], 1.0f, 10.0f, 0.5f));
+            centre(bodies);
+            float semiMajorAxis = 10.0f / 1.5f;
+            scenarios.push_back({ "kepler", bodies, 2.0 * 2.0 * pi * std::sqrt(semiMajorAxis * semiMajorAxis * semiMajorAxis / mu), 0.1f, 7 });
+        }
+
+        // the viewer's default pair around its static sun over one orbit, the steps include MAX_DELTA_TIME
+        {
+            std::vector<physics::Body> bodies = {
+                makeBody(glm::vec3(5.0f, 0.0f, 0.0f), glm::vec3(0.0f), 1000.0f, false),
+                makeBody(glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -2.445f), 1.0f)
+            };
+            scenarios.push_back({ "sun_earth", bodies, 2.0 * pi * std::sqrt(1000.0f / mu), 4.0f * physics::MAX_DELTA_TIME, 6 });
+        }
+
+        // jupiter and saturn at the scaled radii of their near 5:2 resonance over four saturn orbits
+        {
+            std::vector<physics::Body> bodies = { makeBody(glm::vec3(0.0f), glm::vec3(0.0f), 1000.0f) };
+            bodies.push_back(makeOrbit(bodies[0], 0.9546f, 5.2f, 0.048f));
+            bodies.push_back(makeOrbit(bodies[0], 0.2858f, 9.54f, 0.054f));
+            // saturn starts on the far side
+            bodies[2].pos.x = -bodies[2].pos.x;
+            bodies[2].vel.z = -bodies[2].vel.z;
+            centre(bodies);
+            scenarios.push_back({ "jupiter_saturn", bodies, 4.0 * 2.0 * pi * std::sqrt(9.54f * 9.54f * 9.54f / mu), 0.2f, 6 });
+        }
+
+        // plummer sphere sampled as in Aarseth, Henon and Wielen (1974) over about one crossing time
+        {
+            const size_t count = 32;
+            const float totalMass = 10.0f, scale = 1.0f;
+            std::mt19937 random(7);
+            std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+            auto direction = [&]() {
+                float z = 2.0f * unit(random) - 1.0f, angle = 2.0f * pi * unit(random);
+                float r = std::sqrt(1.0f - z * z);
+                return glm::vec3(r * std::cos(angle), r * std::sin(angle), z);
+            };
+
+            std::vector<physics::Body> bodies;
+            while (bodies.size() < count) {
+                float radius = scale / std::sqrt(std::pow(std::max(unit(random), 1e-6f), -2.0f / 3.0f) - 1.0f);
+                if (radius > 10.0f * scale)
+                    continue;
+
+                // q^2 (1 - q^2)^3.5 by rejection, its maximum is below 0.1
+                float q = 0.0f;
+                do {
+                    q = unit(random);
+                } while (0.1f * unit(random) > q * q * std::pow(1.0f - q * q, 3.5f));
+
+                float escape = std::sqrt(2.0f * physics::GRAVITATIONAL_CONSTANT * totalMass / scale) * std::pow(1.0f + radius * radius / (scale * scale), -0.25f);
+                bodies.push_back(makeBody(direction() * radius, direction() * (q * escape), totalMass / count));
+            }
+            centre(bodies);
+            scenarios.push_back({ "plummer", bodies, 2.0, 0.02f, 5 });
+        }
+
+        return scenarios;
+    }
+
+    // double precision RK4 the solvers are measured against
+    static void integrateReference(std::vector<physics::Body>& bodies, double duration, double step) {
+        const size_t count = bodies.size();
+        const uint64_t steps = (uint64_t)std::ceil(duration / step);
+        const double deltaTime = duration / steps;
+
+        std::vector<glm::dvec3> pos(count), vel(count), kPos[4], kVel[4];
+        std::vector<double> gm(count);
+        std::vector<bool> dynamic(count);
+        for (size_t i = 0; i < count; ++i) {
+            pos[i] = bodies[i].pos;
+            vel[i] = bodies[i].type == physics::Body::Type::DYNAMIC ? glm::dvec3(bodies[i].vel) : glm::dvec3(0.0);
+            gm[i] = (double)physics::GRAVITATIONAL_CONSTANT * bodies[i].mass;
+            dynamic[i] = bodies[i].type == physics::Body::Type::DYNAMIC;
+        }
+        for (int stage = 0; stage < 4; ++stage) {
+            kPos[stage].resize(count);
+            kVel[stage].resize(count);
+        }
+
+        auto derive = [&](const std::vector<glm::dvec3>& p, const std::vector<glm::dvec3>& v, int stage) {
+            for (size_t i = 0; i < count; ++i) {
+                kPos[stage][i] = v[i];
+                kVel[stage][i] = glm::dvec3(0.0);
+            }
+            for (size_t a = 0; a < count; ++a) {
+                for (size_t b = a + 1; b < count; ++b) {
+                    glm::dvec3 AtoB = p[b] - p[a];
+                    double distSq = glm::dot(AtoB, AtoB);
+                    if (distSq <= 0.0)
+                        continue;
+
+                    glm::dvec3 dir = AtoB / (distSq * std::sqrt(distSq));
+                    kVel[stage][a] += dir * gm[b];
+                    kVel[stage][b] -= dir * gm[a];
+                }
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (!dynamic[i])
+                    kPos[stage][i] = kVel[stage][i] = glm::dvec3(0.0);
+            }
+        };
+
+        const double offsets[4] = { 0.0, 0.5, 0.5, 1.0 };
+        std::vector<glm::dvec3> tempPos(count), tempVel(count);
+        for (uint64_t step = 0; step < steps; ++step) {
+            for (int stage = 0; stage < 4; ++stage) {
+                if (stage == 0) {
+                    derive(pos, vel, 0);
+                    continue;
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    tempPos[i] = pos[i] + kPos[stage - 1][i] * (offsets[stage] * deltaTime);
+                    tempVel[i] = vel[i] + kVel[stage - 1][i] * (offsets[stage] * deltaTime);
+                }
+                derive(tempPos, tempVel, stage);
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                pos[i] += (kPos[0][i] + 2.0 * kPos[1][i] + 2.0 * kPos[2][i] + kPos[3][i]) * (deltaTime / 6.0);
+                vel[i] += (kVel[0][i] + 2.0 * kVel[1][i] + 2.0 * kVel[2][i] + kVel[3][i]) * (deltaTime / 6.0);
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            bodies[i].pos = pos[i];
+            if (dynamic[i])
+                bodies[i].vel = vel[i];
+        }
+    }
+
+    struct Solver {
+        const char* name;
+        std::function<void(std::vector<physics::Body>& bodies, double duration, float step)> run;
+    };
+
+    static std::vector<Solver> makeSolvers() {
+        std::vector<Solver> solvers;
+
+        // the engine's own step, with the same pairwise force and semi-implicit euler as the viewer
+        solvers.push_back({ "engine", [](std::vector<physics::Body>& bodies, double duration, float step) {
+            physics::Engine engine;
+            engine.collisionsEnabled = false;
+            engine.addBodies(bodies);
+
+            const uint64_t steps = (uint64_t)std::ceil(duration / step);
+            const float deltaTime = (float)(duration / steps);
+            for (uint64_t i = 0; i < steps; ++i)
+                engine.simulateStep(deltaTime);
+            engine.getBodies(bodies);
+        } });
+
+        const physics::Integrator methods[] = { physics::Integrator::EULER, physics::Integrator::LEAPFROG, physics::Integrator::RK4 };
+        for (physics::Integrator method : methods) {
+            solvers.push_back({ physics::getIntegratorName(method), [method](std::vector<physics::Body>& bodies, double duration, float step) {
+                physics::integrateFor(bodies, duration, step, method);
+            } });
+        }
+
+        // leapfrog parallel in time with the default tolerance, the coarse pass steps ten times further
+        solvers.push_back({ "parareal", [](std::vector<physics::Body>& bodies, double duration, float step) {
+            physics::PararealSettings settings;
+            settings.duration = duration;
+            settings.fineStep = step;
+            settings.coarseStep = 10.0f * step;
+            physics::integrateParareal(bodies, settings, utils::ThreadPool::getShared());
+        } });
+
+        return solvers;
+    }
+
+    struct Point {
+        std::string scenario, solver;
+        float step;
+        uint64_t steps;
+        double cpuSeconds, wallSeconds;
+        double energyError, angularMomentumError, positionError;
+    };
+
+    static bool matches(const char* filter, const char* scenario, const char* solver) {
+        return !filter || strstr(scenario, filter) || strstr(solver, filter);
+    }
+
+    static bool writePoints(const char* path, const std::vector<Point>& points) {
+        FILE* file = path ? fopen(path, "w") : stdout;
+        if (!file) {
+            utils::printError("Failed to open %s", path);
+            return false;
+        }
+
+#ifdef NDEBUG
+        const char* build = "optimized";
+#else
+        const char* build = "debug";
+#endif
+        // one run per line like the phase results, each scenario and solver is a curve of cpu time against error
+        fprintf(file, "{\n  \"build\": \"%s\",\n  \"work_precision\": [\n", build);
+        for (size_t i = 0; i < points.size(); ++i) {
+            const Point& point = points[i];
+            fprintf(file, "    {\"scenario\": \"%s\", \"solver\": \"%s\", \"step\": %.6g, \"steps\": %llu, \"cpu_seconds\": %.6g, "
+                "\"wall_seconds\": %.6g, \"energy_error\": %.6g, \"angular_momentum_error\": %.6g, \"position_error\": %.6g}%s\n",
+                point.scenario.c_str(), point.solver.c_str(), point.step, (unsigned long long)point.steps, point.cpuSeconds,
+                point.wallSeconds, point.energyError, point.angularMomentumError, point.positionError,
+                i + 1 < points.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+
+        if (path)
+            fclose(file);
+        return true;
+    }
+
+    int runWorkPrecision(const WorkPrecisionSettings& settings) {
+        std::vector<Solver> solvers = makeSolvers();
+        std::vector<Point> points;
+
+        for (const Scenario& scenario : makeScenarios()) {
+            bool any = false;
+            for (const Solver& solver : solvers)
+                any = any || matches(settings.filter, scenario.name, solver.name);
+            if (!any)
+                continue;
+
+            // a quarter of the smallest step leaves RK4 in double far below what float solvers reach
+            float smallestStep = scenario.largestStep / (float)(1u << scenario.halvings);
+            std::vector<physics::Body> reference = scenario.bodies;
+            auto start = std::chrono::steady_clock::now();
+            integrateReference(reference, scenario.duration, 0.25 * smallestStep);
+            utils::print("%s: %zu bodies over %.3g, reference in %.2fs", scenario.name, scenario.bodies.size(), scenario.duration,
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+            const physics::Invariants initial = physics::measureInvariants(scenario.bodies);
+
+            for (const Solver& solver : solvers) {
+                if (!matches(settings.filter, scenario.name, solver.name))
+                    continue;
+
+                double lastWall = 0.0;
+                for (uint32_t halving = 0; halving <= scenario.halvings; ++halving) {
+                    // halving the step doubles the work
+                    if (2.0 * lastWall > settings.budget) {
+                        utils::print("%s %s: skipping steps below %g, a run would take longer than %.1fs", scenario.name, solver.name,
+                            points.back().step, settings.budget);
+                        break;
+                    }
+
+                    float step = scenario.largestStep / (float)(1u << halving);
+                    std::vector<physics::Body> bodies = scenario.bodies;
+
+                    std::clock_t cpuStart = std::clock();
+                    auto wallStart = std::chrono::steady_clock::now();
+                    solver.run(bodies, scenario.duration, step);
+                    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+                    double cpu = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+                    lastWall = wall;
+
+                    const physics::Invariants invariants = physics::measureInvariants(bodies);
+                    Point point = { scenario.name, solver.name, step, (uint64_t)std::ceil(scenario.duration / step), cpu, wall,
+                        physics::getRelativeError(invariants.getEnergy(), initial.getEnergy()),
+                        physics::getRelativeError(invariants.angularMomentum, initial.angularMomentum),
+                        physics::getPositionError(bodies, reference) };
+                    points.push_back(point);
+
+                    fprintf(stderr, "%-15s %-9s step %-10.4g %9.4fs cpu  energy %9.3e  angular momentum %9.3e  position %9.3e\n",
+                        scenario.name, solver.name, step, cpu, point.energyError, point.angularMomentumError, point.positionError);
+                }
+            }
+        }
+
+        return writePoints(settings.outputPath, points) ? 0 : 1;
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,457 @@
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/physics/scenario.h"
+#include "StarSystemSim/physics/parareal.h"
+#include "StarSystemSim/physics/ensemble.h"
+#include "StarSystemSim/physics/domain_decomposition.h"
+#include "StarSystemSim/physics/shm_transport.h"
+#include "StarSystemSim/physics/checkpoint.h"
+#include "StarSystemSim/physics/trajectory.h"
+#include "StarSystemSim/physics/state_export.h"
+#include "StarSystemSim/physics/stream_server.h"
+
+#include "StarSystemSim/utilities/timer.h"
+#include "StarSystemSim/utilities/error.h"
+#include "StarSystemSim/utilities/profiler.h"
+#include "StarSystemSim/utilities/perf_counters.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+
+static void printUsage() {
+    fprintf(stderr,
+        "usage: starsim_cli <scenario> [options]\n"
+        "       starsim_cli --resume <checkpoint> [options]\n"
+        "  --steps <n>          number of steps to run (default 1000)\n"
+        "  --dt <seconds>       length of a step (default and maximum %g)\n"
+        "  --output <path>      final state as a scenario, binary if it ends in .ssc (default result.txt)\n"
+        "  --trajectory <path>  csv of every body's state during the run\n"
+        "  --every <n>          steps between trajectory rows (default 1)\n"
+        "  --record <path>      compressed binary trajectory of the run\n"
+        "  --record-every <n>   steps between recorded samples (default 1)\n"
+        "  --checkpoint <path>  binary snapshot of the engine after the run\n"
+        "  --resume <path>      start from a snapshot instead of a scenario\n"
+        "  --parareal <slices>  run parallel in time with leapfrog instead of the engine\n"
+        "  --coarse <seconds>   coarse step of the parareal runs (default 10 * dt)\n"
+        "  --ranks <n>          split the bodies over n processes sharing memory\n"
+        "  --ensemble <k>       run k copies with leapfrog and print the spread of their encounters\n"
+        "  --perturb <sigma>    deviation of the ensemble's start positions (default 0.01)\n"
+        "  --export <name>      publish every step into a shared memory segment (e.g. /starsim)\n"
+        "  --serve <address>    stream positions on a unix socket path or host:port\n"
+        "  --serve-bits <n>     bits per quantized axis of the stream, 8 to 24 (default 16)\n"
+        "  --trace <path>       chrome trace of the last steps' phases\n"
+        "  --perf-counters      ipc and cache and branch misses of every phase, Linux only\n",
+        (double)physics::MAX_DELTA_TIME);
+}
+
+static void writeTrajectory(FILE* file, double time, const std::vector<physics::Body>& bodies) {
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        const physics::Body& body = bodies[i];
+        fprintf(file, "%.9g,%zu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", time, i,
+            body.pos.x, body.pos.y, body.pos.z, body.vel.x, body.vel.y, body.vel.z);
+    }
+}
+
+// every member starts with the dynamic bodies moved by a normal deviation, the summary gives
+// each body's closest approach to and final distance from the heaviest body over the members
+static int runEnsemble(const physics::Scenario& scenario, uint32_t members, float perturbation, uint64_t steps,
+    float deltaTime)
+{
+    if (scenario.bodies.size() < 2) {
+        utils::printError("An ensemble needs at least two bodies");
+        return 1;
+    }
+    if (scenario.particles.getCount())
+        utils::printError("Particles are left out of ensemble runs");
+
+    size_t reference = 0;
+    for (size_t i = 1; i < scenario.bodies.size(); ++i) {
+        if (scenario.bodies[i].mass > scenario.bodies[reference].mass)
+            reference = i;
+    }
+
+    physics::Ensemble ensemble;
+    ensemble.init(scenario.bodies, members, [perturbation](size_t member, std::vector<physics::Body>& bodies) {
+        std::mt19937 random((uint32_t)member + 1);
+        std::normal_distribution<float> deviation(0.0f, perturbation);
+        for (physics::Body& body : bodies) {
+            if (body.type == physics::Body::Type::DYNAMIC)
+                body.pos += glm::vec3(deviation(random), deviation(random), deviation(random));
+        }
+    });
+
+    for (size_t i = 0; i < scenario.bodies.size(); ++i) {
+        if (i == reference)
+            continue;
+
+        float start = glm::length(scenario.bodies[i].pos - scenario.bodies[reference].pos);
+        ensemble.addStatistic(physics::Ensemble::Quantity::DISTANCE, physics::Ensemble::Reduction::MIN, i, reference, 0.0f, 2.0f * start);
+        ensemble.addStatistic(physics::Ensemble::Quantity::DISTANCE, physics::Ensemble::Reduction::FINAL, i, reference, 0.0f, 2.0f * start);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ensemble.advance((double)steps * deltaTime, deltaTime, utils::ThreadPool::getShared());
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    utils::print("%u members of %zu bodies, %llu steps in %.3fs", members, scenario.bodies.size(),
+        (unsigned long long)steps, seconds);
+    for (size_t i = 0; i < ensemble.getStatisticCount(); ++i) {
+        const physics::Ensemble::Statistic& statistic = ensemble.getStatistic(i);
+        utils::print("body %zu, %s to body %zu: min %g, mean %g, max %g", statistic.body,
+            statistic.reduction == physics::Ensemble::Reduction::MIN ? "closest approach" : "final distance",
+            statistic.reference, (double)statistic.min, (double)statistic.mean, (double)statistic.max);
+    }
+
+    return 0;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// forks rankCount - 1 workers, every process runs one domain and rank 0 writes the result
+static int runDistributed(physics::Scenario& scenario, uint32_t rankCount, uint64_t steps, float deltaTime,
+    const char* outputPath, bool trajectory)
+{
+    if (trajectory)
+        utils::printError("Trajectories are not written in distributed runs");
+
+    std::string name = "/starsim_" + std::to_string(getpid());
+    pid_t parent = getpid();
+    uint32_t rank = 0;
+    std::vector<pid_t> workers;
+    for (uint32_t worker = 1; worker < rankCount; ++worker) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            rank = worker;
+            workers.clear();
+            break;
+        }
+        if (pid > 0) {
+            workers.push_back(pid);
+            continue;
+        }
+
+        // the ranks started so far would wait for this one forever
+        utils::printError("Failed to start rank %u", worker);
+        for (pid_t started : workers)
+            kill(started, SIGKILL);
+        for (pid_t started : workers)
+            waitpid(started, nullptr, 0);
+        return 1;
+    }
+
+    // rank 0 reaps workers that exit early, a worker checks that rank 0 is still its parent
+    std::vector<int> statuses(workers.size(), 0);
+    std::vector<bool> reaped(workers.size(), false);
+    physics::ShmTransport transport;
+    transport.setLivenessCheck([&]() {
+        if (rank != 0)
+            return getppid() == parent;
+
+        bool alive = true;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (!reaped[i] && waitpid(workers[i], &statuses[i], WNOHANG) == workers[i]) {
+                reaped[i] = true;
+                alive = false;
+            }
+        }
+        return alive;
+    });
+
+    bool ok = transport.open(name.c_str(), rank, rankCount,
+        physics::DomainDecomposition::getMaxMessageSize(scenario.bodies.size()));
+
+    if (ok) {
+        physics::DomainDecomposition domain(transport);
+        domain.init(scenario.bodies, scenario.startTime);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t step = 0; step < steps && !transport.hasFailed(); ++step)
+            domain.step(deltaTime);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        domain.gather(scenario.bodies);
+        scenario.startTime = domain.getTime();
+        ok = !transport.hasFailed();
+
+        if (rank == 0 && ok) {
+            utils::print("%llu steps of %zu bodies on %u ranks in %.3fs (%.0f steps/s)", (unsigned long long)steps,
+                scenario.bodies.size(), rankCount, seconds, seconds > 0.0 ? steps / seconds : 0.0);
+            ok = physics::saveScenario(outputPath, scenario);
+        }
+
+        // the segment has to outlive every rank's last read
+        ok = transport.barrier() && ok;
+    }
+    else if (rank == 0) {
+        // the workers cannot attach without rank 0's segment
+        for (pid_t worker : workers)
+            kill(worker, SIGKILL);
+    }
+
+    if (rank != 0)
+        _exit(ok ? 0 : 1);
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (!reaped[i])
+            waitpid(workers[i], &statuses[i], 0);
+        ok = ok && WIFEXITED(statuses[i]) && WEXITSTATUS(statuses[i]) == 0;
+    }
+
+    return ok ? 0 : 1;
+}
+#else
+static int runDistributed(physics::Scenario&, uint32_t, uint64_t, float, const char*, bool) {
+    utils::printError("Distributed runs are not supported on this platform");
+    return 1;
+}
+#endif
+
+int main(int argc, char** argv) {
+    const char* scenarioPath = nullptr;
+    const char* outputPath = "result.txt";
+    const char* trajectoryPath = nullptr;
+    const char* checkpointPath = nullptr;
+    const char* recordPath = nullptr;
+    uint32_t recordEvery = 1;
+    const char* resumePath = nullptr;
+    uint64_t steps = 1000, every = 1;
+    float deltaTime = physics::MAX_DELTA_TIME;
+    uint32_t pararealSlices = 0;
+    float coarseStep = 0.0f;
+    uint32_t rankCount = 1;
+    uint32_t ensembleMembers = 0;
+    float perturbation = 0.01f;
+    const char* exportName = nullptr;
+    const char* serveAddress = nullptr;
+    physics::StreamServer::Settings serveSettings;
+    const char* tracePath = nullptr;
+    bool perfCountersRequested = false;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(argv[i], "--steps") && hasValue)
+            steps = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--dt") && hasValue)
+            deltaTime = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--output") && hasValue)
+            outputPath = argv[++i];
+        else if (!strcmp(argv[i], "--trajectory") && hasValue)
+            trajectoryPath = argv[++i];
+        else if (!strcmp(argv[i], "--every") && hasValue)
+            every = std::max<uint64_t>(1, strtoull(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--record") && hasValue)
+            recordPath = argv[++i];
+        else if (!strcmp(argv[i], "--record-every") && hasValue)
+            recordEvery = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--checkpoint") && hasValue)
+            checkpointPath = argv[++i];
+        else if (!strcmp(argv[i], "--resume") && hasValue)
+            resumePath = argv[++i];
+        else if (!strcmp(argv[i], "--parareal") && hasValue)
+            pararealSlices = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--coarse") && hasValue)
+            coarseStep = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--ranks") && hasValue)
+            rankCount = std::max(1u, (uint32_t)strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--ensemble") && hasValue)
+            ensembleMembers = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--perturb") && hasValue)
+            perturbation = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--export") && hasValue)
+            exportName = argv[++i];
+        else if (!strcmp(argv[i], "--serve") && hasValue)
+            serveAddress = argv[++i];
+        else if (!strcmp(argv[i], "--serve-bits") && hasValue)
+            serveSettings.bits = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--trace") && hasValue)
+            tracePath = argv[++i];
+        else if (!strcmp(argv[i], "--perf-counters"))
+            perfCountersRequested = true;
+        else if (argv[i][0] != '-' && !scenarioPath)
+            scenarioPath = argv[i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!scenarioPath == !resumePath) {
+        printUsage();
+        return 1;
+    }
+
+    // zones are only recorded when someone reads them
+    utils::Profiler::setEnabled(tracePath != nullptr);
+    utils::Profiler::setThreadName("main");
+
+    if (!(deltaTime > 0.0f) || deltaTime > physics::MAX_DELTA_TIME) {
+        utils::printError("Step length must be in (0, %g]", (double)physics::MAX_DELTA_TIME);
+        return 1;
+    }
+
+    physics::Scenario scenario;
+    if (resumePath) {
+        physics::Checkpoint checkpoint;
+        if (!checkpoint.load(resumePath))
+            return 1;
+        checkpoint.getBodies(scenario.bodies);
+        checkpoint.getParticles(scenario.particles);
+        scenario.startTime = checkpoint.getSimTime();
+    }
+    else if (!physics::loadScenario(scenarioPath, scenario))
+        return 1;
+
+    if (ensembleMembers)
+        return runEnsemble(scenario, ensembleMembers, perturbation, steps, deltaTime);
+
+    if (pararealSlices) {
+        if (trajectoryPath)
+            utils::printError("Trajectories are not written in parareal runs");
+
+        physics::PararealSettings settings;
+        settings.duration = (double)steps * deltaTime;
+        settings.slices = pararealSlices;
+        settings.fineStep = deltaTime;
+        settings.coarseStep = coarseStep > 0.0f ? coarseStep : 10.0f * deltaTime;
+
+        auto start = std::chrono::steady_clock::now();
+        physics::PararealResult parareal = physics::integrateParareal(scenario.bodies, settings, utils::ThreadPool::getShared());
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        utils::print("%u slices, %u iterations, last correction %g%s in %.3fs", pararealSlices, parareal.iterations,
+            (double)parareal.correction, parareal.converged ? "" : " (not converged)", seconds);
+
+        scenario.startTime += settings.duration;
+        return physics::saveScenario(outputPath, scenario) ? 0 : 1;
+    }
+
+    if (rankCount > 1)
+        return runDistributed(scenario, rankCount, steps, deltaTime, outputPath, trajectoryPath != nullptr);
+
+    // the engine steps by however much the virtual clock is advanced
+    utils::VirtualClock clock;
+    physics::Engine engine;
+    engine.setClock(std::ref(clock));
+    engine.predictionEnabled = false;
+    engine.paused = false;
+
+    engine.addBodies(scenario.bodies);
+    if (scenario.particles.getCount())
+        engine.addParticleSystem(&scenario.particles);
+    engine.setSimTime(scenario.startTime);
+
+    FILE* trajectory = nullptr;
+    if (trajectoryPath) {
+        trajectory = fopen(trajectoryPath, "w");
+        if (!trajectory) {
+            utils::printError("Failed to write trajectory (\"%s\")", trajectoryPath);
+            return 1;
+        }
+        fprintf(trajectory, "time,body,px,py,pz,vx,vy,vz\n");
+    }
+
+    std::vector<physics::Body> bodies;
+    if (trajectory) {
+        engine.getBodies(bodies);
+        writeTrajectory(trajectory, engine.getSimTime(), bodies);
+    }
+
+    physics::TrajectoryRecorder recorder;
+    if (recordPath) {
+        if (!recorder.open(recordPath, engine.getBodyCount(), recordEvery))
+            return 1;
+        engine.setRecorder(&recorder);
+    }
+
+    physics::StateExport stateExport;
+    if (exportName && !stateExport.open(exportName, engine.getBodyCount(), scenario.particles.getCount()))
+        return 1;
+
+    physics::StreamServer streamServer;
+    if (serveAddress && !streamServer.open(serveAddress, serveSettings))
+        return 1;
+
+    // the first update only starts the timer
+    engine.update();
+
+    utils::PerfCounters perfCounters;
+    if (perfCountersRequested && perfCounters.open())
+        engine.setPerfCounters(&perfCounters);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t step = 1; step <= steps; ++step) {
+        clock.advance(deltaTime);
+        engine.update();
+        stateExport.publish(engine);
+        streamServer.publish(engine);
+
+        if (trajectory && step % every == 0) {
+            engine.getBodies(bodies);
+            writeTrajectory(trajectory, engine.getSimTime(), bodies);
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    utils::print("%llu steps of %zu bodies and %zu particles in %.3fs (%.0f steps/s)", (unsigned long long)steps,
+        engine.getBodyCount(), scenario.particles.getCount(), seconds, seconds > 0.0 ? steps / seconds : 0.0);
+
+    const physics::Drift drift = engine.getDrift();
+    utils::print("Energy %.9g, drift of energy %.3e, momentum %.3e, angular momentum %.3e", engine.getInvariants().getEnergy(),
+        drift.energy, drift.momentum, drift.angularMomentum);
+
+    if (perfCounters.isOpen()) {
+        using Counter = utils::PerfCounters::Counter;
+        for (uint32_t phase = 0; phase < physics::Engine::PHASE_COUNT; ++phase) {
+            const physics::Engine::PhaseCounters& counters = engine.getPhaseCounters((physics::Engine::Phase)phase);
+            if (!counters.runs)
+                continue;
+
+            // phases without pair interactions are given per step
+            double per = (double)(counters.interactions ? counters.interactions : counters.runs);
+            utils::print("%-20s %6.2f ipc, per %s %8.4g l1d %8.4g llc %8.4g branch misses",
+                physics::Engine::getPhaseName((physics::Engine::Phase)phase), counters.values.getIPC(),
+                counters.interactions ? "pair" : "step", counters.values.get(Counter::L1D_MISSES) / per,
+                counters.values.get(Counter::LLC_MISSES) / per, counters.values.get(Counter::BRANCH_MISSES) / per);
+        }
+        engine.setPerfCounters(nullptr);
+    }
+
+    if (trajectory)
+        fclose(trajectory);
+
+    if (tracePath)
+        utils::Profiler::writeTrace(tracePath);
+
+    if (serveAddress) {
+        utils::print("Streamed %llu bytes, %llu frames dropped", (unsigned long long)streamServer.getSentBytes(),
+            (unsigned long long)streamServer.getDroppedFrames());
+        streamServer.close();
+    }
+
+    if (recordPath) {
+        recorder.close();
+        utils::print("Recorded %llu bytes", (unsigned long long)recorder.getWrittenBytes());
+    }
+
+    if (checkpointPath && !physics::Checkpoint::save(checkpointPath, engine))
+        return 1;
+
+    physics::Scenario result;
+    result.startTime = engine.getSimTime();
+    engine.getBodies(result.bodies);
+    result.particles = scenario.particles;
+
+    return physics::saveScenario(outputPath, result) ? 0 : 1;
+}
\ No newline at end of file
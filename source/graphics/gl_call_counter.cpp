@@ -0,0 +1,237 @@
+#include "StarSystemSim/graphics/gl_call_counter.h"
+
+#include <glad/glad.h>
+
+namespace graphics {
+
+	static const char* ENTRY_NAMES[] = {
+#define STARSIM_GL_NAME(name, kind) #name,
+		STARSIM_GL_CALLS(STARSIM_GL_NAME)
+#undef STARSIM_GL_NAME
+	};
+
+	static const GLCallCounter::Kind ENTRY_KINDS[] = {
+#define STARSIM_GL_KIND(name, kind) GLCallCounter::Kind::kind,
+		STARSIM_GL_CALLS(STARSIM_GL_KIND)
+#undef STARSIM_GL_KIND
+	};
+
+	static GLCallCounter::Frame s_Current = {}, s_Last = {};
+	static bool s_Installed = false;
+
+#if STARSIM_GL_DEBUG
+	// what the counted binds left bound, starting from a fresh context
+	static const uint32_t TEXTURE_UNITS = 32;
+	static const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_MULTISAMPLE };
+	static const uint32_t TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+
+	static struct {
+		GLuint program, vertexArray, arrayBuffer, readFramebuffer, drawFramebuffer;
+		uint32_t textureUnit;
+		GLuint textures[TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+	} s_Bound = {};
+
+	// each returns whether the call left everything as it was
+	static bool bindProgram(GLuint program) {
+		bool same = s_Bound.program == program;
+		s_Bound.program = program;
+		return same;
+	}
+
+	static bool bindVertexArray(GLuint vertexArray) {
+		bool same = s_Bound.vertexArray == vertexArray;
+		s_Bound.vertexArray = vertexArray;
+		return same;
+	}
+
+	// the element array binding belongs to the vertex array, only the array buffer is global
+	static bool bindBuffer(GLenum target, GLuint buffer) {
+		if (target != GL_ARRAY_BUFFER)
+			return false;
+
+		bool same = s_Bound.arrayBuffer == buffer;
+		s_Bound.arrayBuffer = buffer;
+		return same;
+	}
+
+	static bool bindFramebuffer(GLenum target, GLuint framebuffer) {
+		bool same = false;
+		switch (target) {
+			case GL_FRAMEBUFFER:
+				same = s_Bound.readFramebuffer == framebuffer && s_Bound.drawFramebuffer == framebuffer;
+				s_Bound.readFramebuffer = s_Bound.drawFramebuffer = framebuffer;
+				break;
+			case GL_READ_FRAMEBUFFER:
+				same = s_Bound.readFramebuffer == framebuffer;
+				s_Bound.readFramebuffer = framebuffer;
+				break;
+			case GL_DRAW_FRAMEBUFFER:
+				same = s_Bound.drawFramebuffer == framebuffer;
+				s_Bound.drawFramebuffer = framebuffer;
+				break;
+		}
+		return same;
+	}
+
+	static bool activeTexture(GLenum unit) {
+		bool same = s_Bound.textureUnit == unit - GL_TEXTURE0;
+		s_Bound.textureUnit = unit - GL_TEXTURE0;
+		return same;
+	}
+
+	static bool bindTexture(GLenum target, GLuint texture) {
+		if (s_Bound.textureUnit >= TEXTURE_UNITS)
+			return false;
+
+		for (uint32_t slot = 0; slot < TEXTURE_TARGET_COUNT; ++slot) {
+			if (TEXTURE_TARGETS[slot] == target) {
+				GLuint& bound = s_Bound.textures[s_Bound.textureUnit][slot];
+				bool same = bound == texture;
+				bound = texture;
+				return same;
+			}
+		}
+		return false;
+	}
+
+	// deleting a bound object reverts its binding to 0
+	static void forget(GLuint& bound, GLsizei count, const GLuint* names) {
+		for (GLsizei i = 0; i < count; ++i) {
+			if (bound == names[i])
+				bound = 0;
+		}
+	}
+
+	static bool deleteTextures(GLsizei count, const GLuint* textures) {
+		for (uint32_t unit = 0; unit < TEXTURE_UNITS; ++unit) {
+			for (uint32_t slot = 0; slot < TEXTURE_TARGET_COUNT; ++slot)
+				forget(s_Bound.textures[unit][slot], count, textures);
+		}
+		return false;
+	}
+
+	static bool deleteBuffers(GLsizei count, const GLuint* buffers) {
+		forget(s_Bound.arrayBuffer, count, buffers);
+		return false;
+	}
+
+	static bool deleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+		forget(s_Bound.vertexArray, count, vertexArrays);
+		return false;
+	}
+
+	static bool deleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+		forget(s_Bound.readFramebuffer, count, framebuffers);
+		forget(s_Bound.drawFramebuffer, count, framebuffers);
+		return false;
+	}
+
+	template <uint32_t Entry, typename... Args>
+	static bool isRedundant(Args... args) {
+		if constexpr (Entry == GLCallCounter::ENTRY_glUseProgram)
+			return bindProgram(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glBindVertexArray)
+			return bindVertexArray(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glBindBuffer)
+			return bindBuffer(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glBindFramebuffer)
+			return bindFramebuffer(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glActiveTexture)
+			return activeTexture(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glBindTexture)
+			return bindTexture(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glDeleteTextures)
+			return deleteTextures(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glDeleteBuffers)
+			return deleteBuffers(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glDeleteVertexArrays)
+			return deleteVertexArrays(args...);
+		else if constexpr (Entry == GLCallCounter::ENTRY_glDeleteFramebuffers)
+			return deleteFramebuffers(args...);
+		else
+			return false;
+	}
+
+	// stands in for one of glad's pointers and calls the one it replaced
+	template <uint32_t Entry, typename Function>
+	struct CountedCall;
+
+	template <uint32_t Entry, typename Result, typename... Args>
+	struct CountedCall<Entry, Result (APIENTRYP)(Args...)> {
+		inline static Result (APIENTRYP original)(Args...) = nullptr;
+
+		static Result APIENTRY call(Args... args) {
+			s_Current.calls[Entry] += 1;
+			if (isRedundant<Entry>(args...))
+				s_Current.redundant[Entry] += 1;
+			return original(args...);
+		}
+	};
+
+	template <uint32_t Entry, typename Function>
+	static void wrap(Function& pointer) {
+		if (!pointer)
+			return;
+
+		CountedCall<Entry, Function>::original = pointer;
+		pointer = &CountedCall<Entry, Function>::call;
+	}
+#endif
+
+	uint32_t GLCallCounter::Frame::getCalls() const {
+		uint32_t total = 0;
+		for (uint32_t entry = 0; entry < ENTRY_COUNT; ++entry)
+			total += calls[entry];
+		return total;
+	}
+
+	uint32_t GLCallCounter::Frame::getRedundant() const {
+		uint32_t total = 0;
+		for (uint32_t entry = 0; entry < ENTRY_COUNT; ++entry)
+			total += redundant[entry];
+		return total;
+	}
+
+	uint32_t GLCallCounter::Frame::getQueries() const {
+		uint32_t total = 0;
+		for (uint32_t entry = 0; entry < ENTRY_COUNT; ++entry) {
+			if (ENTRY_KINDS[entry] == Kind::QUERY || ENTRY_KINDS[entry] == Kind::LOOKUP)
+				total += calls[entry];
+		}
+		return total;
+	}
+
+	bool GLCallCounter::install() {
+#if STARSIM_GL_DEBUG
+		if (!s_Installed) {
+#define STARSIM_GL_WRAP(name, kind) wrap<ENTRY_##name>(glad_##name);
+			STARSIM_GL_CALLS(STARSIM_GL_WRAP)
+#undef STARSIM_GL_WRAP
+			s_Installed = true;
+		}
+#endif
+		return s_Installed;
+	}
+
+	bool GLCallCounter::isInstalled() {
+		return s_Installed;
+	}
+
+	void GLCallCounter::endFrame() {
+		s_Last = s_Current;
+		s_Current = {};
+	}
+
+	const GLCallCounter::Frame& GLCallCounter::getLastFrame() {
+		return s_Last;
+	}
+
+	const char* GLCallCounter::getEntryName(uint32_t entry) {
+		return entry < ENTRY_COUNT ? ENTRY_NAMES[entry] : "unknown";
+	}
+
+	GLCallCounter::Kind GLCallCounter::getEntryKind(uint32_t entry) {
+		return entry < ENTRY_COUNT ? ENTRY_KINDS[entry] : Kind::CALL;
+	}
+
+}
\ No newline at end of file
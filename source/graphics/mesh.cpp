@@ -1,4 +1,5 @@
 #include "StarSystemSim/graphics/mesh.h"
+#include "StarSystemSim/graphics/renderer.h"
 #include "StarSystemSim/utilities/error.h"
 
 #include <glad/glad.h>
@@ -70,6 +71,7 @@ namespace graphics {
 
 		glBindVertexArray(m_VAO);
 		glDrawElements(renderMode, m_Indices.size(), GL_UNSIGNED_INT, 0);
+		Renderer::drawCalls += 1;
 		glBindVertexArray(0);
 
 		shader.unuse();
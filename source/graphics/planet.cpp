@@ -4,6 +4,7 @@
 #include <glad/glad.h>
 #include <glm/vec3.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <map>
@@ -23,8 +24,10 @@ namespace graphics {
 
 
 	Planet::Planet(const char* name, uint32_t subdivLevel)
-		: Object(Type::PLANET), m_MainMesh(nullptr)
+		: Object(Type::PLANET), m_MainMesh(nullptr), m_Radius(1.0f)
 	{
+		this->body.radius = m_Radius;
+
 		init();
 
 		subdivide(subdivLevel);
@@ -41,6 +44,13 @@ namespace graphics {
 	}
 
 	void Planet::draw(Shader& shader, uint32_t renderMode) {
+		if (this->body.radius != m_Radius && m_Radius > 0.0f) {
+			glm::vec3 factor(this->body.radius / m_Radius);
+			((Object*)this)->scale(factor);
+			m_MainMesh->scale(factor);
+			m_Radius = this->body.radius;
+		}
+
 		setPos(this->body.pos);
 		m_MainMesh->draw(shader, renderMode);
 	}
@@ -71,6 +81,9 @@ namespace graphics {
 	void Planet::scale(const glm::vec3& sc) {
 		((Object*)this)->scale(sc);
 		m_MainMesh->scale(sc);
+
+		m_Radius *= std::max(sc.x, std::max(sc.y, sc.z));
+		this->body.radius = m_Radius;
 	}
 
 	void Planet::subdivide(uint32_t depth) {
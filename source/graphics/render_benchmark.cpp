@@ -0,0 +1,207 @@
+#include "StarSystemSim/graphics/render_benchmark.h"
+
+#include "StarSystemSim/utilities/error.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace graphics {
+
+	RenderBenchmark::RenderBenchmark()
+		: m_FrameCount(0), m_WarmUp(0), m_Frame(0)
+	{
+		std::fill(m_Queries, m_Queries + QUERY_RING, 0u);
+		std::fill(m_QueryPending, m_QueryPending + QUERY_RING, false);
+		std::fill(m_QueryFrame, m_QueryFrame + QUERY_RING, 0u);
+		std::fill(m_EntryCalls, m_EntryCalls + GLCallCounter::ENTRY_COUNT, 0u);
+		std::fill(m_EntryRedundant, m_EntryRedundant + GLCallCounter::ENTRY_COUNT, 0u);
+	}
+
+	RenderBenchmark::~RenderBenchmark() {
+		if (m_Queries[0])
+			glDeleteQueries(QUERY_RING, m_Queries);
+	}
+
+	void RenderBenchmark::start(uint32_t frames, uint32_t warmUp) {
+		if (!m_Queries[0])
+			glGenQueries(QUERY_RING, m_Queries);
+
+		m_FrameCount = frames;
+		m_WarmUp = warmUp;
+		m_Frame = 0;
+		std::fill(m_QueryPending, m_QueryPending + QUERY_RING, false);
+
+		m_CpuTimes.assign(frames, 0.0);
+		m_GpuTimes.assign(frames, 0.0);
+		m_FrameTimes.assign(frames, 0.0);
+		m_GlCalls.assign(frames, 0u);
+		m_GlRedundant.assign(frames, 0u);
+		std::fill(m_EntryCalls, m_EntryCalls + GLCallCounter::ENTRY_COUNT, 0u);
+		std::fill(m_EntryRedundant, m_EntryRedundant + GLCallCounter::ENTRY_COUNT, 0u);
+		m_LastFrameEnd = std::chrono::steady_clock::now();
+	}
+
+	void RenderBenchmark::applyCamera(Camera& camera, Object* target) const {
+		const uint32_t total = m_WarmUp + m_FrameCount;
+		const float t = total > 1 ? std::min((float)m_Frame / (total - 1), 1.0f) : 0.0f;
+
+		camera.mode = Camera::Mode::LOOK_AT;
+		camera.target = target;
+
+		// a third each: one full orbit, a pass that dives under the target and a zoom out
+		if (t < 1.0f / 3.0f) {
+			float s = 3.0f * t;
+			camera.yaw = 360.0f * s;
+			camera.pitch = 15.0f;
+			camera.radius = 5.0f;
+		}
+		else if (t < 2.0f / 3.0f) {
+			float s = 3.0f * t - 1.0f;
+			camera.yaw = 90.0f * s;
+			camera.pitch = 40.0f - 80.0f * s;
+			camera.radius = 1.5f + 12.0f * std::abs(2.0f * s - 1.0f);
+		}
+		else {
+			float s = 3.0f * t - 2.0f;
+			camera.yaw = 90.0f;
+			camera.pitch = 25.0f;
+			camera.radius = 3.0f * std::pow(30.0f, s);
+		}
+	}
+
+	void RenderBenchmark::beginFrame() {
+		uint32_t slot = m_Frame % QUERY_RING;
+		if (m_QueryPending[slot])
+			collectQuery(slot);
+
+		m_DrawStart = std::chrono::steady_clock::now();
+		glBeginQuery(GL_TIME_ELAPSED, m_Queries[slot]);
+	}
+
+	void RenderBenchmark::endDraw() {
+		uint32_t slot = m_Frame % QUERY_RING;
+		glEndQuery(GL_TIME_ELAPSED);
+		m_QueryPending[slot] = true;
+		m_QueryFrame[slot] = m_Frame;
+
+		if (m_Frame >= m_WarmUp)
+			m_CpuTimes[m_Frame - m_WarmUp] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_DrawStart).count();
+	}
+
+	void RenderBenchmark::endFrame() {
+		auto now = std::chrono::steady_clock::now();
+		if (m_Frame >= m_WarmUp) {
+			m_FrameTimes[m_Frame - m_WarmUp] = std::chrono::duration<double, std::milli>(now - m_LastFrameEnd).count();
+
+			const GLCallCounter::Frame& calls = GLCallCounter::getLastFrame();
+			m_GlCalls[m_Frame - m_WarmUp] = calls.getCalls();
+			m_GlRedundant[m_Frame - m_WarmUp] = calls.getRedundant();
+			for (uint32_t entry = 0; entry < GLCallCounter::ENTRY_COUNT; ++entry) {
+				m_EntryCalls[entry] += calls.calls[entry];
+				m_EntryRedundant[entry] += calls.redundant[entry];
+			}
+		}
+
+		m_LastFrameEnd = now;
+		m_Frame += 1;
+	}
+
+	void RenderBenchmark::collectQuery(uint32_t slot) {
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(m_Queries[slot], GL_QUERY_RESULT, &nanoseconds);
+		m_QueryPending[slot] = false;
+
+		uint32_t frame = m_QueryFrame[slot];
+		if (frame >= m_WarmUp && frame - m_WarmUp < m_FrameCount)
+			m_GpuTimes[frame - m_WarmUp] = nanoseconds * 1e-6;
+	}
+
+	static void writeSummary(FILE* file, const char* name, std::vector<double> times, bool last) {
+		double mean = 0.0;
+		for (double time : times)
+			mean += time;
+		mean /= std::max<size_t>(times.size(), 1);
+
+		std::sort(times.begin(), times.end());
+		// nearest rank
+		auto percentile = [&times](double p) {
+			if (times.empty())
+				return 0.0;
+			size_t rank = (size_t)std::ceil(p * times.size());
+			return times[std::min(std::max<size_t>(rank, 1), times.size()) - 1];
+		};
+
+		fprintf(file, "  \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n", name, mean,
+			percentile(0.5), percentile(0.95), percentile(0.99), times.empty() ? 0.0 : times.back(), last ? "" : ",");
+	}
+
+	bool RenderBenchmark::writeResults(const char* path) {
+		for (uint32_t slot = 0; slot < QUERY_RING; ++slot) {
+			if (m_QueryPending[slot])
+				collectQuery(slot);
+		}
+
+		FILE* file = fopen(path, "w");
+		if (!file) {
+			utils::printError("Failed to open %s", path);
+			return false;
+		}
+
+		const uint32_t recorded = std::min(m_FrameCount, m_Frame > m_WarmUp ? m_Frame - m_WarmUp : 0u);
+		m_CpuTimes.resize(recorded);
+		m_GpuTimes.resize(recorded);
+		m_FrameTimes.resize(recorded);
+		m_GlCalls.resize(recorded);
+		m_GlRedundant.resize(recorded);
+
+		const char* renderer = (const char*)glGetString(GL_RENDERER);
+		fprintf(file, "{\n  \"renderer\": \"%s\",\n  \"frames\": %u,\n  \"warm_up\": %u,\n", renderer ? renderer : "unknown", recorded, m_WarmUp);
+		// times are in milliseconds, cpu covers recording the frame's GL work and the ui, frame the whole loop
+		writeSummary(file, "cpu_ms", m_CpuTimes, false);
+		writeSummary(file, "gpu_ms", m_GpuTimes, false);
+		writeSummary(file, "frame_ms", m_FrameTimes, false);
+
+		// per frame means of every entry point that was called, only with the counter installed
+		const bool countCalls = GLCallCounter::isInstalled();
+		if (countCalls) {
+			const double frames = std::max(recorded, 1u);
+			uint64_t calls = 0, redundant = 0, queries = 0;
+			for (uint32_t entry = 0; entry < GLCallCounter::ENTRY_COUNT; ++entry) {
+				calls += m_EntryCalls[entry];
+				redundant += m_EntryRedundant[entry];
+				GLCallCounter::Kind kind = GLCallCounter::getEntryKind(entry);
+				if (kind == GLCallCounter::Kind::QUERY || kind == GLCallCounter::Kind::LOOKUP)
+					queries += m_EntryCalls[entry];
+			}
+
+			fprintf(file, "  \"gl_calls\": {\"calls\": %.2f, \"redundant\": %.2f, \"queries\": %.2f, \"entries\": {", calls / frames,
+				redundant / frames, queries / frames);
+			bool first = true;
+			for (uint32_t entry = 0; entry < GLCallCounter::ENTRY_COUNT; ++entry) {
+				if (!m_EntryCalls[entry])
+					continue;
+				fprintf(file, "%s\n    \"%s\": {\"calls\": %.2f, \"redundant\": %.2f}", first ? "" : ",", GLCallCounter::getEntryName(entry),
+					m_EntryCalls[entry] / frames, m_EntryRedundant[entry] / frames);
+				first = false;
+			}
+			fprintf(file, "\n  }},\n");
+		}
+
+		fprintf(file, "  \"per_frame\": [\n");
+		for (uint32_t i = 0; i < recorded; ++i) {
+			fprintf(file, "    {\"cpu_ms\": %.4f, \"gpu_ms\": %.4f, \"frame_ms\": %.4f", m_CpuTimes[i], m_GpuTimes[i], m_FrameTimes[i]);
+			if (countCalls)
+				fprintf(file, ", \"gl_calls\": %u, \"gl_redundant\": %u", m_GlCalls[i], m_GlRedundant[i]);
+			fprintf(file, "}%s\n", i + 1 < recorded ? "," : "");
+		}
+		fprintf(file, "  ]\n}\n");
+
+		fclose(file);
+		utils::print("Rendered %u frames on %s, results in %s", recorded, renderer ? renderer : "unknown", path);
+		return true;
+	}
+
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "StarSystemSim/app/app.h"
 #include "StarSystemSim/graphics/render_mode.h"
 #include "StarSystemSim/utilities/error.h"
+#include "StarSystemSim/utilities/profiler.h"
 
 #include <glad/glad.h>
 #include <glm/vec2.hpp>
@@ -10,14 +11,17 @@
 namespace graphics {
 
 	float Renderer::tessLevel = 1.0f;
+	uint32_t Renderer::drawCalls = 0;
 
 	Renderer::Renderer()
-		: m_VAO(0), m_VBO(0), m_EBO(0),
-		MSAA_samples(8), blurStr(5),
+		: MSAA_samples(8), blurStr(5),
+		lines(nullptr), particles(nullptr),
+		bloomEnabled(false),
 		m_CurrentScene(nullptr),
-		m_MSFramebuffer(0), m_HDRFramebuffer(0), m_IntermediateMSFramebuffer(0), m_BloomFramebuffers(nullptr),
+		m_MSFramebuffer(0), m_IntermediateMSFramebuffer(0), m_HDRFramebuffer(0), m_BloomFramebuffers(nullptr),
 		m_MainTexture(0), m_HDRTexture(0), m_BloomTextures(nullptr),
-		bloomEnabled(false)
+		m_VAO(0), m_VBO(0), m_EBO(0),
+		m_ParticleVAO(0), m_ParticleVBO(0)
 	{
 		this->currentBloomTexture = 1;
 
@@ -35,6 +39,7 @@ namespace graphics {
 		glEnable(GL_MULTISAMPLE);
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glEnable(GL_PROGRAM_POINT_SIZE);
 
 
 		// tessellation patch vertices
@@ -48,6 +53,10 @@ namespace graphics {
 			glDeleteBuffers(1, &m_VBO);
 		if (m_EBO)
 			glDeleteBuffers(1, &m_EBO);
+		if (m_ParticleVAO)
+			glDeleteVertexArrays(1, &m_ParticleVAO);
+		if (m_ParticleVBO)
+			glDeleteBuffers(1, &m_ParticleVBO);
 		if (m_MSFramebuffer)
 			glDeleteFramebuffers(1, &m_MSFramebuffer);
 		if (m_IntermediateMSFramebuffer)
@@ -71,6 +80,8 @@ namespace graphics {
 	}
 
 	void Renderer::drawFrame(uint32_t renderMode) {
+		PROFILE_ZONE("draw frame");
+		drawCalls = 0;
 
 		// rendering scene's objects
 		if(m_CurrentScene != nullptr) {
@@ -82,6 +93,7 @@ namespace graphics {
 
 			// drawing skybox
 			{
+				PROFILE_ZONE("skybox");
 				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 				m_SkyboxShader.use();
@@ -108,6 +120,7 @@ namespace graphics {
 
 			// drawing stars
 			{
+				PROFILE_ZONE("stars");
 				m_StarShader.use();
 				m_StarShader.setUniformMat4("_projMat", App::s_Instance->mainCamera.projMatrix);
 				m_StarShader.setUniformMat4("_viewMat", App::s_Instance->mainCamera.viewMatrix);
@@ -123,6 +136,7 @@ namespace graphics {
 
 			// drawing planets
 			{
+				PROFILE_ZONE("planets");
 				m_CelestialShader.use();
 				m_CelestialShader.setUniformMat4("_projMat", App::s_Instance->mainCamera.projMatrix);
 				m_CelestialShader.setUniformMat4("_viewMat", App::s_Instance->mainCamera.viewMatrix);
@@ -146,6 +160,7 @@ namespace graphics {
 
 			// drawing lines
 			{
+				PROFILE_ZONE("lines");
 				GLuint vao, vbo;
 				glGenVertexArrays(1, &vao);
 				glBindVertexArray(vao);
@@ -161,6 +176,7 @@ namespace graphics {
 				m_LineShader.setUniformMat4("_viewMat", App::s_Instance->mainCamera.viewMatrix);
 			
 				glDrawArrays(GL_LINES, 0, lines->size() / 2);
+				drawCalls += 1;
 			
 				m_LineShader.unuse();
 			
@@ -169,10 +185,40 @@ namespace graphics {
 				glDeleteBuffers(1, &vbo);
 				glDeleteVertexArrays(1, &vao);
 			}
+
+			// drawing test particles
+			if (particles != nullptr && !particles->empty()) {
+				PROFILE_ZONE("particles");
+				if (!m_ParticleVAO) {
+					glGenVertexArrays(1, &m_ParticleVAO);
+					glGenBuffers(1, &m_ParticleVBO);
+
+					glBindVertexArray(m_ParticleVAO);
+					glBindBuffer(GL_ARRAY_BUFFER, m_ParticleVBO);
+					glEnableVertexAttribArray(0);
+					glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)nullptr);
+				}
+
+				glBindVertexArray(m_ParticleVAO);
+				glBindBuffer(GL_ARRAY_BUFFER, m_ParticleVBO);
+				glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * particles->size(), (void*)particles->data(), GL_STREAM_DRAW);
+
+				m_ParticleShader.use();
+				m_ParticleShader.setUniformMat4("_projMat", App::s_Instance->mainCamera.projMatrix);
+				m_ParticleShader.setUniformMat4("_viewMat", App::s_Instance->mainCamera.viewMatrix);
+
+				glDrawArrays(GL_POINTS, 0, particles->size());
+				drawCalls += 1;
+
+				m_ParticleShader.unuse();
+
+				glBindVertexArray(0);
+			}
 		}
 		
 		// blitting from a multisampled frame buffer
 		{
+			PROFILE_ZONE("msaa blit");
 			glDisable(GL_DEPTH_TEST);
 			int32_t width = App::getWindowWidth(), height = App::getWindowHeight();
 
@@ -195,6 +241,7 @@ namespace graphics {
 		// calculating bloom effect
 		if(bloomEnabled)
 		{
+			PROFILE_ZONE("bloom");
 			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
 			// downscaling
@@ -222,6 +269,7 @@ namespace graphics {
 				horizontal = !horizontal;
 
 				glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+				drawCalls += 1;
 			}
 
 			m_BlurShader.unuse();
@@ -248,6 +296,7 @@ namespace graphics {
 			glBindTexture(GL_TEXTURE_2D, m_BloomTextures[m_BloomTextureCount - 3]);
 
 			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+			drawCalls += 1;
 
 			for (int texIter = m_BloomTextureCount-4; texIter >= 2; texIter -= 2) {
 				glBindFramebuffer(GL_FRAMEBUFFER, m_BloomFramebuffers[texIter - 2]);
@@ -263,6 +312,7 @@ namespace graphics {
 				glBindTexture(GL_TEXTURE_2D, m_BloomTextures[texIter - 1]);
 
 				glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+				drawCalls += 1;
 			}
 			m_MixShader.unuse();
 		}
@@ -270,6 +320,7 @@ namespace graphics {
 
 		// drawing to screen
 		{
+			PROFILE_ZONE("post");
 			glViewport(0, 0, App::getWindowWidth(), App::getWindowHeight());
 			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 			
@@ -290,6 +341,7 @@ namespace graphics {
 
 			glBindVertexArray(m_VAO);
 			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL);
+			drawCalls += 1;
 			glBindVertexArray(0);
 			m_PostprocessingShader.unuse();
 		}
@@ -532,5 +584,6 @@ namespace graphics {
 		m_CelestialShader.buildShaders("shaders/celestial.shader", true);
 		m_StarShader.buildShaders("shaders/star.shader", true);
 		m_LineShader.buildShaders("shaders/line.shader", true);
+		m_ParticleShader.buildShaders("shaders/particle.shader", true);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "StarSystemSim/graphics/scalar_field_texture.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+namespace graphics {
+
+	// dark blue -> teal -> yellow, low values are the interesting ones
+	static const float COLORMAP[][3] = {
+		{ 0.05f, 0.03f, 0.35f },
+		{ 0.15f, 0.35f, 0.60f },
+		{ 0.15f, 0.65f, 0.55f },
+		{ 0.55f, 0.85f, 0.30f },
+		{ 1.00f, 0.95f, 0.20f }
+	};
+	static const int COLORMAP_STOPS = sizeof(COLORMAP) / sizeof(COLORMAP[0]);
+
+	ScalarFieldTexture::ScalarFieldTexture()
+		: m_Texture(0), m_Width(0), m_Height(0),
+		m_Min(0.0f), m_Max(0.0f), m_Contours(0)
+	{}
+
+	ScalarFieldTexture::~ScalarFieldTexture() {
+		if (m_Texture)
+			glDeleteTextures(1, &m_Texture);
+	}
+
+	void ScalarFieldTexture::upload(const float* values, uint32_t width, uint32_t height,
+		float min, float max, bool logScale)
+	{
+		const size_t count = (size_t)width * height;
+
+		if (min >= max) {
+			min = INFINITY;
+			max = -INFINITY;
+			for (size_t i = 0; i < count; ++i) {
+				if (std::isfinite(values[i])) {
+					min = std::min(min, values[i]);
+					max = std::max(max, values[i]);
+				}
+			}
+			if (min > max)
+				min = max = 0.0f;
+		}
+		m_Min = min;
+		m_Max = max;
+
+		auto transform = [logScale](float value) {
+			return logScale ? std::log(std::max(value, 1e-12f)) : value;
+		};
+		const float low = transform(min);
+		const float range = std::max(transform(max) - low, 1e-12f);
+
+		m_Pixels.resize(count * 4);
+		for (uint32_t y = 0; y < height; ++y) {
+			uint8_t* row = m_Pixels.data() + (size_t)y * width * 4;
+
+			for (uint32_t x = 0; x < width; ++x) {
+				float value = values[(size_t)y * width + x];
+				uint8_t* pixel = row + x * 4;
+
+				if (!std::isfinite(value)) {
+					pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+					continue;
+				}
+
+				float t = std::clamp((transform(value) - low) / range, 0.0f, 1.0f) * (COLORMAP_STOPS - 1);
+				int stop = std::min((int)t, COLORMAP_STOPS - 2);
+				float frac = t - stop;
+
+				for (int c = 0; c < 3; ++c) {
+					float color = COLORMAP[stop][c] + (COLORMAP[stop + 1][c] - COLORMAP[stop][c]) * frac;
+					pixel[c] = (uint8_t)(color * 255.0f + 0.5f);
+				}
+				pixel[3] = 255;
+			}
+		}
+
+		// a texel whose band differs from the next one across or down lies on a line
+		if (m_Contours) {
+			m_Bands.resize(count);
+			for (size_t i = 0; i < count; ++i) {
+				float value = values[i];
+				m_Bands[i] = std::isfinite(value) ? (int32_t)(std::clamp((transform(value) - low) / range, 0.0f, 1.0f) * m_Contours) : INT32_MIN;
+			}
+
+			for (uint32_t y = 0; y < height; ++y) {
+				for (uint32_t x = 0; x < width; ++x) {
+					size_t i = (size_t)y * width + x;
+					bool line = (x + 1 < width && m_Bands[i + 1] != m_Bands[i]) || (y + 1 < height && m_Bands[i + width] != m_Bands[i]);
+					if (line && m_Bands[i] != INT32_MIN) {
+						for (int c = 0; c < 3; ++c)
+							m_Pixels[i * 4 + c] /= 3;
+					}
+				}
+			}
+		}
+
+		if (!m_Texture) {
+			glGenTextures(1, &m_Texture);
+			glBindTexture(GL_TEXTURE_2D, m_Texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+		else
+			glBindTexture(GL_TEXTURE_2D, m_Texture);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		if (width == m_Width && height == m_Height)
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, m_Pixels.data());
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_Pixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		m_Width = width;
+		m_Height = height;
+	}
+
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "StarSystemSim/graphics/skybox.h"
+#include "StarSystemSim/graphics/renderer.h"
 #include "StarSystemSim/utilities/error.h"
 
 #include <glad/glad.h>
@@ -33,6 +34,7 @@ namespace graphics {
 		glDepthMask(GL_FALSE);
 		glBindVertexArray(m_VAO);
 		glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+		Renderer::drawCalls += 1;
 		glBindVertexArray(0);
 		glDepthMask(GL_TRUE);
 		shader.unuse();
@@ -1,5 +1,6 @@
 #include "StarSystemSim/app/app.h"
 #include "StarSystemSim/app/event_manager.h"
+#include "StarSystemSim/app/performance_hud.h"
 
 #include "StarSystemSim/graphics/shader.h"
 #include "StarSystemSim/graphics/renderer.h"
@@ -10,12 +11,30 @@
 #include "StarSystemSim/graphics/planet.h"
 #include "StarSystemSim/graphics/star.h"
 #include "StarSystemSim/graphics/skybox.h"
+#include "StarSystemSim/graphics/scalar_field_texture.h"
+#include "StarSystemSim/graphics/render_benchmark.h"
+#include "StarSystemSim/graphics/gl_call_counter.h"
 
 #include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/physics/ephemeris.h"
+#include "StarSystemSim/physics/particle_system.h"
+#include "StarSystemSim/physics/event_detector.h"
+#include "StarSystemSim/physics/porkchop.h"
+#include "StarSystemSim/physics/checkpoint.h"
+#include "StarSystemSim/physics/trajectory.h"
+#include "StarSystemSim/physics/timeline.h"
+#include "StarSystemSim/physics/scenario.h"
+#include "StarSystemSim/physics/state_export.h"
+#include "StarSystemSim/physics/stream_server.h"
+#include "StarSystemSim/physics/potential_field.h"
 
 #include "StarSystemSim/utilities/timer.h"
 #include "StarSystemSim/utilities/load_text_file.h"
 #include "StarSystemSim/utilities/error.h"
+#include "StarSystemSim/utilities/thread_pool.h"
+#include "StarSystemSim/utilities/profiler.h"
+#include "StarSystemSim/utilities/alloc_tracker.h"
+#include "StarSystemSim/utilities/perf_counters.h"
 
 
 #include <GLFW/glfw3.h>
@@ -33,10 +52,38 @@
 
 #include <iostream>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <thread>
 #include <algorithm>
+#include <deque>
+#include <future>
+#include <memory>
+
+int main(int argc, char** argv) {
+    // [scenario] [--render-bench <frames>] [--render-bench-output <path>] [--trace <path>] [--assert-no-alloc] [--perf-counters]
+    const char* scenarioPath = nullptr;
+    uint32_t benchFrames = 0;
+    const char* benchOutputPath = "render_bench.json";
+    const char* tracePath = nullptr;
+    bool perfCountersRequested = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--render-bench") && i + 1 < argc)
+            benchFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--render-bench-output") && i + 1 < argc)
+            benchOutputPath = argv[++i];
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (!strcmp(argv[i], "--assert-no-alloc"))
+            utils::AllocTracker::setAssertions(true);
+        else if (!strcmp(argv[i], "--perf-counters"))
+            perfCountersRequested = true;
+        else if (!scenarioPath)
+            scenarioPath = argv[i];
+    }
 
-int main() {
+    utils::Profiler::setThreadName("main");
     App::start();
     graphics::Camera& camera = App::s_Instance->mainCamera;
     glm::mat4x4* viewMat4 = &camera.viewMatrix;
@@ -48,8 +95,45 @@ int main() {
     graphics::Object* camTarget = nullptr;
     
     graphics::Planet* earth = nullptr;
+    graphics::Planet* mars = nullptr;
+    physics::ParticleSystem asteroidBelt;
+    physics::EventDetector eventDetector;
+
+    // bodies of a scenario given on the command line, only those with a model get a mesh,
+    // a scenario without any is a catalog added on top of the default scene
+    physics::Scenario scenario;
+    bool drawBodiesAsPoints = false;
+    if (scenarioPath && physics::loadScenario(scenarioPath, scenario)) {
+        std::vector<physics::Body> physicsOnly;
+        for (size_t i = 0; i < scenario.bodies.size(); ++i) {
+            const std::string& model = scenario.models[i];
+            if (model.empty()) {
+                physicsOnly.push_back(scenario.bodies[i]);
+            }
+            else if (model == "sun") {
+                graphics::Star s(model.c_str());
+                s.body = scenario.bodies[i];
+                camTarget = App::addToScene(s);
+                App::s_Instance->camTargets.push_back(camTarget);
+            }
+            else {
+                graphics::Planet p(model.c_str(), 3);
+                p.body = scenario.bodies[i];
+                camTarget = App::addToScene(p);
+                App::s_Instance->camTargets.push_back(camTarget);
+            }
+        }
 
-    {
+        App::s_Instance->physicsEngine.addBodies(physicsOnly);
+        App::s_Instance->physicsEngine.addParticleSystem(&scenario.particles);
+        App::s_Instance->physicsEngine.setSimTime(scenario.startTime);
+        drawBodiesAsPoints = !physicsOnly.empty();
+
+        utils::print("Loaded %zu bodies and %zu particles from \"%s\"", scenario.bodies.size(),
+            scenario.particles.getCount(), scenarioPath);
+    }
+
+    if (!camTarget) {
         graphics::Planet e("earth", 3);
         e.translate(glm::vec3(-5.0f, 0.0f, 0.0f));
         e.scale(glm::vec3(0.2f));
@@ -58,6 +142,16 @@ int main() {
         camTarget = App::addToScene(e);
         earth = (graphics::Planet*)camTarget;
         App::s_Instance->camTargets.push_back(camTarget);
+
+        // placeholder: the repository has no mars textures, so the porkchop target borrows the earth's
+        // until a models/mars folder laid out like models/earth is added
+        graphics::Planet m("earth", 3);
+        m.translate(glm::vec3(-15.0f, 0.0f, 0.0f));
+        m.scale(glm::vec3(0.15f));
+        m.body.mass = 0.1f;
+        m.body.vel = { 0.0f, 0.0f, -1.581f };
+        mars = (graphics::Planet*)App::addToScene(m);
+        App::s_Instance->camTargets.push_back(mars);
     
         graphics::Star sun("sun");
         sun.translate(glm::vec3(5.0f, 0.0f, 0.0f));
@@ -65,11 +159,17 @@ int main() {
         sun.body.vel = { 0.0f, 0.0f, 0.063245f };
         camTarget = App::addToScene(sun);
         App::s_Instance->camTargets.push_back(camTarget);
+
+        asteroidBelt.addRing(sun.body, 13.0f, 16.0f, 20000, 0.3f);
+        App::s_Instance->physicsEngine.addParticleSystem(&asteroidBelt);
+
+        eventDetector.watchApsides(&earth->body, &((graphics::Star*)camTarget)->body);
+        App::s_Instance->physicsEngine.setEventDetector(&eventDetector);
     }
 
     camera.mode = graphics::Camera::Mode::LOOK_AT;
     camera.radius = 3.14f;
-    camera.target = earth;
+    camera.target = earth ? earth : (App::s_Instance->camTargets.empty() ? nullptr : App::s_Instance->camTargets.front());
 
 
     bool show_demo_window = false;
@@ -84,23 +184,132 @@ int main() {
     std::vector<glm::vec3> lines;
     renderer.lines = &lines;
 
+    std::vector<glm::vec3> particles;
+    renderer.particles = &particles;
+    std::vector<glm::vec3> scenarioPoints;
+    std::vector<physics::Body> bodyStates;
+
+    std::deque<physics::EventDetector::Event> recentEvents;
+
+    physics::Ephemeris ephemeris;
+    const char* ephemerisPath = "ephemeris.bin";
+    const char* checkpointPath = "checkpoint.bin";
+
+    physics::TrajectoryRecorder recorder;
+    const char* trajectoryPath = "trajectory.sst";
+
+    physics::StateExport stateExport;
+    const char* stateExportName = "/starsim_state";
+
+    physics::StreamServer streamServer;
+    const char* streamAddress = "/tmp/starsim.sock";
+
+    physics::Timeline timeline;
+    physicsEngine.setTimeline(&timeline);
+    // shown on the slider until the replay catches up
+    double timelineTarget = 0.0;
+
+    // transfer windows relative to the simulation time when computed
+    float porkchopDeparture[2] = { 0.0f, 45.0f };
+    float porkchopArrival[2] = { 10.0f, 80.0f };
+    int porkchopSize = 1000;
+    std::unique_ptr<physics::Porkchop> porkchop;
+    std::future<std::unique_ptr<physics::Porkchop>> porkchopJob;
+    graphics::ScalarFieldTexture porkchopTexture;
+
+    // ecliptic slice around the sun, bodies are only summed again once they moved a tenth of a cell
+    bool showPotential = false, potentialRotating = true;
+    int potentialSize = 256;
+    float potentialExtent = 48.0f;
+    physics::PotentialField potential;
+    graphics::ScalarFieldTexture potentialTexture;
+    std::vector<physics::Body> potentialBodies;
+    std::vector<float> potentialSorted;
+
+    // frame times and the zones behind them, collected even while the window is closed
+    app::PerformanceHud performanceHud;
+    bool showPerformance = false;
+    uint32_t frameDrawCalls = 0;
+    // the engine updates on this thread, so the counters are opened here
+    utils::PerfCounters perfCounters;
+    if (perfCountersRequested && perfCounters.open())
+        physicsEngine.setPerfCounters(&perfCounters);
+
+    // the benchmark steps the camera and physics by a fixed time per frame and draws without vsync or the frame cap
+    graphics::RenderBenchmark renderBenchmark;
+    graphics::Object* benchTarget = camera.target;
+
+    // merges delete the absorbed planet, the camera has already moved on to another target
+    App::s_Instance->onRemove = [&earth, &mars, &benchTarget, &camera](graphics::Object* object) {
+        if (object == earth)
+            earth = nullptr;
+        if (object == mars)
+            mars = nullptr;
+        if (object == benchTarget)
+            benchTarget = camera.target;
+    };
+
+    utils::VirtualClock benchClock(glfwGetTime());
+    if (benchFrames) {
+        glfwSwapInterval(0);
+        App::mainTimer.setClock(std::ref(benchClock));
+        physicsEngine.setClock(std::ref(benchClock));
+        physicsEngine.paused = false;
+        renderBenchmark.start(benchFrames);
+    }
+
     while (!glfwWindowShouldClose(App::s_Window)) {
+        if (renderBenchmark.isRunning())
+            benchClock.advance(1.0 / 60.0);
+
+        performanceHud.collect(physicsEngine, frameDrawCalls);
+        utils::ProfileZone frameZone("frame");
+
         App::mainTimer.measureTime();
         physicsEngine.update();
-        app::EventManager::processInput(App::s_Window);
-
-        camera.dir = camera.target->getPos() - camera.pos;
-        camera.update();
+        timeline.poll(physicsEngine);
+        {
+            PROFILE_ZONE("publish");
+            stateExport.publish(physicsEngine);
+            streamServer.publish(physicsEngine);
+        }
+        if (renderBenchmark.isRunning())
+            renderBenchmark.applyCamera(camera, benchTarget);
+        else
+            app::EventManager::processInput(App::s_Window);
+
+        // once every meshed body has merged away there is nothing to look at, the view stays put
+        if (camera.target) {
+            camera.dir = camera.target->getPos() - camera.pos;
+            camera.update();
+        }
 
         // ImGui preparing for a new frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        utils::ProfileZone gatherZone("gather points");
         physicsEngine.getPredictedPos(lines);
+        asteroidBelt.getPositions(particles);
+        if (scenario.particles.getCount()) {
+            scenario.particles.getPositions(scenarioPoints);
+            particles.insert(particles.end(), scenarioPoints.begin(), scenarioPoints.end());
+        }
+        if (drawBodiesAsPoints) {
+            // bodies with a mesh hide their own point
+            physicsEngine.getBodies(bodyStates);
+            for (const physics::Body& body : bodyStates)
+                particles.push_back(body.pos);
+        }
+        gatherZone.end();
 
+        if (renderBenchmark.isRunning())
+            renderBenchmark.beginFrame();
         renderer.drawFrame((uint32_t)App::s_Instance->renderMode);
 
+        utils::ProfileZone imguiZone("imgui");
+
         /////////////////////
         // ImGui rendering //
         /////////////////////
@@ -113,23 +322,286 @@ int main() {
             ImGui::SliderFloat("Time Speed", &physicsEngine.timeMultiplier, 0.0f, 10.0f);
 
             ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+            ImGui::SameLine();
+            ImGui::Checkbox("Performance", &showPerformance);
 
             ImGui::Checkbox("Bloom", &renderer.bloomEnabled);
 
+            ImGui::Text("Ephemeris Cache\n");
+            // the porkchop worker may be reading the cache
+            if (ImGui::Button("Build")) {
+                if (porkchopJob.valid())
+                    porkchopJob.wait();
+                physicsEngine.setEphemeris(nullptr);
+                std::vector<physics::Body> bodies;
+                physicsEngine.getBodies(bodies);
+                ephemeris.build(bodies, physicsEngine.getSimTime(), 600.0);
+                ephemeris.save(ephemerisPath);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Load")) {
+                if (porkchopJob.valid())
+                    porkchopJob.wait();
+                physicsEngine.setEphemeris(nullptr);
+                ephemeris.load(ephemerisPath);
+            }
+
+            if (!ephemeris.isEmpty()) {
+                bool playback = physicsEngine.getEphemeris() != nullptr;
+                if (ImGui::Checkbox("Playback From Cache", &playback))
+                    physicsEngine.setEphemeris(playback ? &ephemeris : nullptr);
+
+                if (playback) {
+                    double simTime = physicsEngine.getSimTime();
+                    double startTime = ephemeris.getStartTime(), endTime = ephemeris.getEndTime();
+                    if (ImGui::SliderScalar("Date", ImGuiDataType_Double, &simTime, &startTime, &endTime, "%.2f"))
+                        physicsEngine.setSimTime(simTime);
+                }
+            }
+
+            ImGui::Text("Timeline\n");
+            if (!timeline.isEmpty()) {
+                double startTime = timeline.getStartTime(), endTime = timeline.getEndTime();
+                double simTime = timeline.isSeeking() ? timelineTarget : timeline.getCurrentTime();
+                if (ImGui::SliderScalar("Time", ImGuiDataType_Double, &simTime, &startTime, &endTime, "%.2f")) {
+                    physicsEngine.paused = true;
+                    timelineTarget = simTime;
+                    timeline.seekAsync(simTime);
+                }
+                ImGui::Text("%zu keyframes, %.1f MB%s", timeline.getKeyframeCount(),
+                    timeline.getMemoryUsage() / (1024.0 * 1024.0), timeline.isSeeking() ? ", seeking..." : "");
+            }
+
+            ImGui::Text("Checkpoint\n");
+            if (ImGui::Button("Save"))
+                physics::Checkpoint::save(checkpointPath, physicsEngine);
+            ImGui::SameLine();
+            if (ImGui::Button("Restore")) {
+                physics::Checkpoint checkpoint;
+                if (checkpoint.load(checkpointPath))
+                    checkpoint.restore(physicsEngine);
+            }
+
+            bool recording = recorder.isOpen();
+            if (ImGui::Checkbox("Record Trajectory", &recording)) {
+                if (recording && recorder.open(trajectoryPath, physicsEngine.getBodyCount()))
+                    physicsEngine.setRecorder(&recorder);
+                else {
+                    physicsEngine.setRecorder(nullptr);
+                    recorder.finish();
+                }
+            }
+            if (recorder.isOpen())
+                ImGui::Text("%.1f MB written", recorder.getWrittenBytes() / (1024.0 * 1024.0));
+
+            bool exporting = stateExport.isOpen();
+            if (ImGui::Checkbox("Export State", &exporting)) {
+                if (exporting) {
+                    size_t particleCount = 0;
+                    for (const physics::ParticleSystem* system : physicsEngine.getParticleSystems())
+                        particleCount += system->getCount();
+                    stateExport.open(stateExportName, physicsEngine.getBodyCount(), particleCount);
+                }
+                else
+                    stateExport.close();
+            }
+            if (stateExport.isOpen())
+                ImGui::Text("%s, frame %llu", stateExportName, (unsigned long long)stateExport.getFrame());
+
+            bool streaming = streamServer.isOpen();
+            if (ImGui::Checkbox("Stream", &streaming)) {
+                if (streaming)
+                    streamServer.open(streamAddress, physics::StreamServer::Settings());
+                else
+                    streamServer.close();
+            }
+            if (streamServer.isOpen()) {
+                ImGui::Text("%s, %u subscribers\n%.1f MB sent, %llu frames dropped", streamAddress, streamServer.getSubscriberCount(),
+                    streamServer.getSentBytes() / (1024.0 * 1024.0), (unsigned long long)streamServer.getDroppedFrames());
+            }
+
             ImGui::Text("Camera\n");
             ImGui::Text("Yaw: %.1f\nPitch: %.1f", camera.yaw, camera.pitch);
 
             ImGui::End();
         }
 
+        // Porkchop Plot Window
+        {
+            ImGui::Begin("Porkchop", (bool*)0, ImGuiWindowFlags_NoFocusOnAppearing);
+
+            ImGui::DragFloat2("Departure", porkchopDeparture, 0.5f, 0.0f, 1000.0f, "%.1f");
+            ImGui::DragFloat2("Arrival", porkchopArrival, 0.5f, 0.0f, 1000.0f, "%.1f");
+            ImGui::SliderInt("Grid", &porkchopSize, 16, 2000);
+
+            bool computing = porkchopJob.valid();
+            if (computing && porkchopJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                porkchop = porkchopJob.get();
+                porkchopTexture.upload(porkchop->getDeltaV().data(), porkchop->getWidth(), porkchop->getHeight(), 0.0f, 0.0f, true);
+                computing = false;
+            }
+
+            if (computing)
+                ImGui::Text("Computing...");
+            else if (earth && mars && ImGui::Button("Compute Earth -> Mars")) {
+                double now = physicsEngine.getSimTime();
+                physics::Porkchop::Settings settings;
+                settings.departureBody = physicsEngine.getBodyIndex(&earth->body);
+                settings.arrivalBody = physicsEngine.getBodyIndex(&mars->body);
+                settings.departureStart = now + porkchopDeparture[0];
+                settings.departureEnd = now + std::max(porkchopDeparture[0], porkchopDeparture[1]);
+                settings.arrivalStart = now + porkchopArrival[0];
+                settings.arrivalEnd = now + std::max(porkchopArrival[0], porkchopArrival[1]);
+                settings.width = settings.height = (uint32_t)porkchopSize;
+
+                // an attached cache is used when it spans both windows, otherwise the
+                // current state is integrated into a temporary one on the worker
+                const physics::Ephemeris* cache = physicsEngine.getEphemeris();
+                if (cache && !(cache->covers(settings.departureStart) && cache->covers(settings.arrivalEnd)))
+                    cache = nullptr;
+                if (cache) {
+                    settings.departureBody = physicsEngine.getEphemerisBody(settings.departureBody);
+                    settings.arrivalBody = physicsEngine.getEphemerisBody(settings.arrivalBody);
+                }
+
+                std::vector<physics::Body> bodies;
+                physicsEngine.getBodies(bodies);
+
+                porkchopJob = std::async(std::launch::async, [settings, cache, bodies, now]() {
+                    std::unique_ptr<physics::Porkchop> result = std::make_unique<physics::Porkchop>();
+                    physics::Ephemeris temporary;
+                    if (!cache)
+                        temporary.build(bodies, now, settings.arrivalEnd - now);
+                    result->compute(cache ? *cache : temporary, settings, utils::ThreadPool::getShared());
+                    return result;
+                });
+            }
+
+            if (porkchop && porkchopTexture.getID()) {
+                const physics::Porkchop::Settings& settings = porkchop->getSettings();
+
+                // arrival dates grow upwards
+                ImVec2 origin = ImGui::GetCursorScreenPos();
+                ImVec2 size(256.0f, 256.0f);
+                ImGui::Image((ImTextureID)(intptr_t)porkchopTexture.getID(), size, ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f));
+
+                if (ImGui::IsItemHovered()) {
+                    ImVec2 mouse = ImGui::GetIO().MousePos;
+                    uint32_t x = (uint32_t)std::clamp((mouse.x - origin.x) / size.x * porkchop->getWidth(), 0.0f, porkchop->getWidth() - 1.0f);
+                    uint32_t y = (uint32_t)std::clamp((1.0f - (mouse.y - origin.y) / size.y) * porkchop->getHeight(), 0.0f, porkchop->getHeight() - 1.0f);
+                    size_t cell = (size_t)y * porkchop->getWidth() + x;
+
+                    double departure = settings.departureStart + (settings.departureEnd - settings.departureStart) * x / std::max(1u, porkchop->getWidth() - 1);
+                    double arrival = settings.arrivalStart + (settings.arrivalEnd - settings.arrivalStart) * y / std::max(1u, porkchop->getHeight() - 1);
+                    ImGui::SetTooltip("Departure: %.2f\nArrival: %.2f\nDelta-v: %.3f\nC3: %.3f",
+                        departure, arrival, porkchop->getDeltaV()[cell], porkchop->getC3()[cell]);
+                }
+
+                ImGui::Text("Delta-v: %.3f - %.3f (log scale)", porkchopTexture.getMin(), porkchopTexture.getMax());
+                ImGui::Text("Best: %.3f, departing %.2f arriving %.2f",
+                    porkchop->getBestDeltaV(), porkchop->getBestDeparture(), porkchop->getBestArrival());
+            }
+
+            ImGui::End();
+        }
+
+        // Potential Field Window
+        {
+            ImGui::Begin("Potential", (bool*)0, ImGuiWindowFlags_NoFocusOnAppearing);
+
+            bool changed = ImGui::Checkbox("Show", &showPotential);
+            changed |= ImGui::Checkbox("Rotating Frame", &potentialRotating);
+            changed |= ImGui::SliderInt("Resolution", &potentialSize, 64, 1024);
+            changed |= ImGui::SliderFloat("Extent", &potentialExtent, 4.0f, 200.0f);
+
+            if (showPotential) {
+                physicsEngine.getBodies(potentialBodies);
+
+                // the frame turns with the earth around the heaviest body
+                physics::Body center;
+                center.mass = 0.0f;
+                for (const physics::Body& body : potentialBodies)
+                    if (body.mass > center.mass)
+                        center = body;
+
+                float cellSize = potentialExtent / potentialSize;
+
+                physics::PotentialField::Settings settings;
+                settings.origin = center.pos - glm::vec3(potentialExtent * 0.5f, 0.0f, potentialExtent * 0.5f);
+                settings.axisU = glm::vec3(potentialExtent, 0.0f, 0.0f);
+                settings.axisV = glm::vec3(0.0f, 0.0f, potentialExtent);
+                settings.axisW = glm::vec3(0.0f, 1.0f, 0.0f);
+                settings.width = settings.height = (uint32_t)potentialSize;
+                settings.depth = 1;
+                settings.softening = cellSize;
+                settings.rotating = potentialRotating && earth;
+                settings.rotationCenter = center.pos;
+                settings.rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+                settings.angularVelocity = 0.0f;
+                if (settings.rotating) {
+                    glm::vec3 offset = earth->body.pos - center.pos, relVel = earth->body.vel - center.vel;
+                    glm::vec3 momentum = glm::cross(offset, relVel);
+                    settings.rotationAxis = momentum;
+                    settings.angularVelocity = glm::length(momentum) / glm::dot(offset, offset);
+                }
+
+                // the grid only follows the central body and the earth's angular velocity once they drift noticeably
+                const physics::PotentialField::Settings& current = potential.getSettings();
+                bool rebuilt = changed || current.width != settings.width || current.rotating != settings.rotating
+                    || glm::length(current.rotationCenter - settings.rotationCenter) > cellSize
+                    || std::abs(current.angularVelocity - settings.angularVelocity) > 0.01f * settings.angularVelocity;
+                if (rebuilt)
+                    potential.setSettings(settings);
+
+                if (potential.update(potentialBodies, utils::ThreadPool::getShared(), 0.1f * cellSize) || rebuilt) {
+                    // the wells would take up the whole scale, so the lowest tenth is clipped
+                    const std::vector<float>& values = potential.getValues();
+                    potentialSorted = values;
+                    size_t low = potentialSorted.size() / 10;
+                    std::nth_element(potentialSorted.begin(), potentialSorted.begin() + low, potentialSorted.end());
+                    float minValue = potentialSorted[low];
+                    float maxValue = *std::max_element(values.begin(), values.end());
+
+                    potentialTexture.setContours(24);
+                    potentialTexture.upload(values.data(), potential.getWidth(), potential.getHeight(), minValue, maxValue);
+                }
+
+                ImGui::Text("%zu bodies summed again", potential.getUpdatedBodies());
+                float side = std::min(ImGui::GetContentRegionAvail().x, 512.0f);
+                ImGui::Image((ImTextureID)(intptr_t)potentialTexture.getID(), ImVec2(side, side));
+            }
+
+            ImGui::End();
+        }
+
+        // Detected Events Window
+        {
+            physics::EventDetector::Event event;
+            while (eventDetector.pollEvent(event)) {
+                recentEvents.push_front(event);
+                if (recentEvents.size() > 16)
+                    recentEvents.pop_back();
+            }
+
+            ImGui::Begin("Events", (bool*)0, ImGuiWindowFlags_NoFocusOnAppearing);
+            for (const physics::EventDetector::Event& recent : recentEvents) {
+                ImGui::Text("%8.2f  %s", recent.time, physics::EventDetector::getEventName(recent.type));
+            }
+            ImGui::End();
+        }
+
         // Selected Celestial Body
         {
             ImGui::Begin("Celestial Body", (bool*)0, ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoBringToFrontOnFocus);
             
-            ImGui::DragFloat3("Position", (float*)&((graphics::Planet*)(camera.target))->body.pos);
-            ImGui::DragFloat3("Velocity", (float*)&((graphics::Planet*)(camera.target))->body.vel);
+            if (!camera.target)
+                ImGui::Text("No body selected");
+            else {
+                ImGui::DragFloat3("Position", (float*)&((graphics::Planet*)(camera.target))->body.pos);
+                ImGui::DragFloat3("Velocity", (float*)&((graphics::Planet*)(camera.target))->body.vel);
+            }
             
-            if (camera.target->type == graphics::Object::Type::STAR) {
+            if (camera.target && camera.target->type == graphics::Object::Type::STAR) {
                 graphics::Star& target = *(graphics::Star*)camera.target;
                 ImGui::ColorPicker3("Light Color", (float*)(&target.light.diffuseColor));
                 target.light.specularColor = target.light.diffuseColor;
@@ -138,24 +610,64 @@ int main() {
             ImGui::End();
         }
 
+        if (showPerformance)
+            performanceHud.draw(&showPerformance);
+
         ImGui::Render();
         ImDrawData* drawData = ImGui::GetDrawData();
+        frameDrawCalls = graphics::Renderer::drawCalls;
         if (drawData) {
             ImGui_ImplOpenGL3_RenderDrawData(drawData);
+            for (int i = 0; i < drawData->CmdListsCount; ++i)
+                frameDrawCalls += drawData->CmdLists[i]->CmdBuffer.Size;
+        }
+        imguiZone.end();
+        graphics::GLCallCounter::endFrame();
+
+        if (renderBenchmark.isRunning()) {
+            renderBenchmark.endDraw();
+            {
+                PROFILE_ZONE("swap");
+                glfwSwapBuffers(App::s_Window);
+            }
+            glfwPollEvents();
+            renderBenchmark.endFrame();
+
+            if (renderBenchmark.isDone()) {
+                renderBenchmark.writeResults(benchOutputPath);
+                glfwSetWindowShouldClose(App::s_Window, GLFW_TRUE);
+            }
+            continue;
         }
 
-        glfwSwapBuffers(App::s_Window);
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(App::s_Window);
+        }
         glfwPollEvents();
 
         App::frameClock.measureTime();
         std::chrono::microseconds sleepTime;
         double maxTime = 1000000.0f / 144.0f;
         sleepTime = std::chrono::microseconds((uint64_t)std::max(0.0f, (float)std::min(maxTime, maxTime - (double)App::frameClock.deltaTime * 1000000.0f)));
-        std::this_thread::sleep_for(sleepTime);
+        {
+            PROFILE_ZONE("frame cap");
+            std::this_thread::sleep_for(sleepTime);
+        }
     }
 
+    if (porkchopJob.valid())
+        porkchopJob.wait();
+
+    physicsEngine.setRecorder(nullptr);
+    recorder.close();
+    physicsEngine.setTimeline(nullptr);
+    physicsEngine.setPerfCounters(nullptr);
+
+    if (tracePath)
+        utils::Profiler::writeTrace(tracePath);
+
     App::clear();
 
     return 0;
-}
-
+}
\ No newline at end of file
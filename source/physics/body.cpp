@@ -4,7 +4,7 @@
 namespace physics {
 
 	Body::Body()
-		: pos(0.0f, 0.0f, 0.0f), vel(0.0f, 0.0f, 0.0f), mass(1.0f),
+		: pos(0.0f, 0.0f, 0.0f), vel(0.0f, 0.0f, 0.0f), mass(1.0f), radius(0.0f),
 		type(Type::DYNAMIC)
 	{
 	}
@@ -13,6 +13,7 @@ namespace physics {
 		this->pos = pos;
 		this->vel = { 0.0f, 0.0f, 0.0f };
 		this->mass = mass;
+		this->radius = 0.0f;
 		this->type = Type::DYNAMIC;
 	}
 
@@ -20,6 +21,7 @@ namespace physics {
 		this->pos = otherBody.pos;
 		this->vel = otherBody.vel;
 		this->mass = otherBody.mass;
+		this->radius = otherBody.radius;
 		this->type = otherBody.type;
 
 		return *this;
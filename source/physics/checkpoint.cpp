@@ -0,0 +1,412 @@
+#include "StarSystemSim/physics/checkpoint.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/physics/event_detector.h"
+#include "StarSystemSim/physics/particle_system.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHECKPOINT_MMAP 1
+#else
+#define CHECKPOINT_MMAP 0
+#endif
+
+namespace physics {
+
+	static const char CHECKPOINT_MAGIC[8] = { 'S', 'S', 'S', 'C', 'H', 'K', 'P', '\0' };
+	static const uint32_t CHECKPOINT_VERSION = 1;
+
+	static size_t alignTo64(size_t size) {
+		return (size + 63) & ~(size_t)63;
+	}
+
+	Checkpoint::Checkpoint()
+		: m_Data(nullptr), m_ParticleCounts(nullptr), m_Types(nullptr),
+		m_Mapping(nullptr), m_MappingSize(0)
+	{
+		static_assert(sizeof(Header) == 64, "checkpoint header has to fill one cache line");
+		clear();
+	}
+
+	Checkpoint::~Checkpoint() {
+		clear();
+	}
+
+	void Checkpoint::clear() {
+#if CHECKPOINT_MMAP
+		if (m_Mapping)
+			munmap(m_Mapping, m_MappingSize);
+#endif
+		m_Mapping = nullptr;
+		m_MappingSize = 0;
+
+		m_Data = nullptr;
+		m_Owned.clear();
+		m_ParticleCounts = nullptr;
+		m_Types = nullptr;
+		std::memset(m_BodyColumns, 0, sizeof(m_BodyColumns));
+		std::memset(m_Prediction, 0, sizeof(m_Prediction));
+		m_ParticleColumns.clear();
+		std::memset(&m_Header, 0, sizeof(Header));
+	}
+
+	void Checkpoint::calcLayout(const Header& header, const uint64_t* particleCounts, Layout& layout) {
+		size_t offset = sizeof(Header);
+
+		layout.particleCounts = offset;
+		offset += alignTo64(header.particleSystemCount * sizeof(uint64_t));
+
+		layout.types = offset;
+		offset += alignTo64(header.bodyCount);
+
+		for (size_t column = 0; column < BODY_COLUMN_COUNT; ++column) {
+			layout.bodyColumns[column] = offset;
+			offset += alignTo64(header.bodyCount * sizeof(float));
+		}
+
+		for (size_t column = 0; column < PREDICTION_COLUMN_COUNT; ++column) {
+			layout.prediction[column] = offset;
+			offset += alignTo64((size_t)header.bodyCount * header.predictionSteps * sizeof(float));
+		}
+
+		layout.particleColumns.clear();
+		for (uint32_t system = 0; system < header.particleSystemCount; ++system) {
+			for (size_t column = 0; column < PARTICLE_COLUMN_COUNT; ++column) {
+				layout.particleColumns.push_back(offset);
+				offset += alignTo64(particleCounts[system] * sizeof(float));
+			}
+		}
+
+		layout.size = offset;
+	}
+
+	bool Checkpoint::save(const char* path, const Engine& engine) {
+		Header header;
+		std::memset(&header, 0, sizeof(Header));
+		std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+		header.version = CHECKPOINT_VERSION;
+		header.bodyCount = (uint32_t)engine.m_Bodies.size();
+		header.particleSystemCount = (uint32_t)engine.m_ParticleSystems.size();
+		header.timeMultiplier = engine.timeMultiplier;
+		header.deltaTime = engine.m_Timer.deltaTime;
+		header.simTime = engine.m_SimTime;
+
+		// a preview from before a merge no longer lines up with the bodies
+		const std::vector<std::vector<Body>>& prediction = engine.m_PosPrediction;
+		if (prediction.size() == engine.m_Bodies.size() && !prediction.empty())
+			header.predictionSteps = (uint32_t)prediction[0].size();
+
+		header.flags = 0;
+		if (engine.paused)
+			header.flags |= PAUSED;
+		if (engine.predCalculated && header.predictionSteps)
+			header.flags |= PRED_CALCULATED;
+		if (engine.predictionEnabled)
+			header.flags |= PREDICTION_ENABLED;
+		if (engine.collisionsEnabled)
+			header.flags |= COLLISIONS_ENABLED;
+
+		std::vector<uint64_t> particleCounts;
+		for (const ParticleSystem* particles : engine.m_ParticleSystems)
+			particleCounts.push_back(particles->getCount());
+
+		Layout layout;
+		calcLayout(header, particleCounts.data(), layout);
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (file.fail()) {
+			utils::printError("Failed to open checkpoint file (\"%s\") for writing", path);
+			return false;
+		}
+
+		const char zeros[64] = {};
+		auto writeColumn = [&](const void* data, size_t size) {
+			file.write((const char*)data, size);
+			file.write(zeros, alignTo64(size) - size);
+		};
+
+		file.write((const char*)&header, sizeof(Header));
+		writeColumn(particleCounts.data(), particleCounts.size() * sizeof(uint64_t));
+
+		std::vector<uint8_t> types;
+		std::vector<float> columns[BODY_COLUMN_COUNT];
+		for (const Body* body : engine.m_Bodies) {
+			types.push_back((uint8_t)body->type);
+			columns[POS_X].push_back(body->pos.x);
+			columns[POS_Y].push_back(body->pos.y);
+			columns[POS_Z].push_back(body->pos.z);
+			columns[VEL_X].push_back(body->vel.x);
+			columns[VEL_Y].push_back(body->vel.y);
+			columns[VEL_Z].push_back(body->vel.z);
+			columns[MASS].push_back(body->mass);
+			columns[RADIUS].push_back(body->radius);
+		}
+
+		writeColumn(types.data(), types.size());
+		for (const std::vector<float>& column : columns)
+			writeColumn(column.data(), column.size() * sizeof(float));
+
+		// [body][step] for each of pos xyz and vel xyz
+		std::vector<float> predictionColumn;
+		const size_t predictionBodies = header.predictionSteps ? prediction.size() : 0;
+		for (size_t column = 0; column < PREDICTION_COLUMN_COUNT; ++column) {
+			predictionColumn.clear();
+			for (size_t i = 0; i < predictionBodies; ++i) {
+				for (uint32_t step = 0; step < header.predictionSteps; ++step) {
+					const Body& state = prediction[i][std::min<size_t>(step, prediction[i].size() - 1)];
+					predictionColumn.push_back(column < 3 ? state.pos[(int)column] : state.vel[(int)column - 3]);
+				}
+			}
+			writeColumn(predictionColumn.data(), predictionColumn.size() * sizeof(float));
+		}
+
+		for (const ParticleSystem* particles : engine.m_ParticleSystems) {
+			writeColumn(particles->m_PosX.data(), particles->getCount() * sizeof(float));
+			writeColumn(particles->m_PosY.data(), particles->getCount() * sizeof(float));
+			writeColumn(particles->m_PosZ.data(), particles->getCount() * sizeof(float));
+			writeColumn(particles->m_VelX.data(), particles->getCount() * sizeof(float));
+			writeColumn(particles->m_VelY.data(), particles->getCount() * sizeof(float));
+			writeColumn(particles->m_VelZ.data(), particles->getCount() * sizeof(float));
+		}
+
+		if (file.fail()) {
+			utils::printError("Failed to write checkpoint file (\"%s\")", path);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Checkpoint::load(const char* path) {
+		clear();
+
+#if CHECKPOINT_MMAP
+		int fd = open(path, O_RDONLY);
+		struct stat fileStat;
+		if (fd < 0 || fstat(fd, &fileStat) != 0 || (size_t)fileStat.st_size < sizeof(Header)) {
+			if (fd >= 0)
+				close(fd);
+			utils::printError("Failed to read checkpoint file (\"%s\")", path);
+			return false;
+		}
+
+		size_t fileSize = (size_t)fileStat.st_size;
+		void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapping == MAP_FAILED) {
+			utils::printError("Failed to map checkpoint file (\"%s\")", path);
+			return false;
+		}
+
+		m_Mapping = mapping;
+		m_MappingSize = fileSize;
+		const uint8_t* data = (const uint8_t*)mapping;
+#else
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (file.fail()) {
+			utils::printError("Failed to read checkpoint file (\"%s\")", path);
+			return false;
+		}
+
+		size_t fileSize = (size_t)file.tellg();
+		m_Owned.resize(fileSize);
+		file.seekg(0);
+		if (fileSize < sizeof(Header) || !file.read((char*)m_Owned.data(), fileSize)) {
+			utils::printError("Failed to read checkpoint file (\"%s\")", path);
+			clear();
+			return false;
+		}
+		const uint8_t* data = m_Owned.data();
+#endif
+
+		Header header;
+		std::memcpy(&header, data, sizeof(Header));
+		if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || header.version != CHECKPOINT_VERSION) {
+			utils::printError("\"%s\" is not a supported checkpoint file", path);
+			clear();
+			return false;
+		}
+
+		const size_t countsEnd = sizeof(Header) + header.particleSystemCount * sizeof(uint64_t);
+		if (fileSize < countsEnd) {
+			utils::printError("Checkpoint file (\"%s\") is truncated", path);
+			clear();
+			return false;
+		}
+
+		Layout layout;
+		const uint64_t* particleCounts = (const uint64_t*)(data + sizeof(Header));
+		calcLayout(header, particleCounts, layout);
+		if (fileSize < layout.size) {
+			utils::printError("Checkpoint file (\"%s\") is truncated", path);
+			clear();
+			return false;
+		}
+
+		// fixing up the column pointers is all a restore has to parse
+		m_Header = header;
+		m_Data = data;
+		m_ParticleCounts = particleCounts;
+		m_Types = data + layout.types;
+		for (size_t column = 0; column < BODY_COLUMN_COUNT; ++column)
+			m_BodyColumns[column] = (const float*)(data + layout.bodyColumns[column]);
+		for (size_t column = 0; column < PREDICTION_COLUMN_COUNT; ++column)
+			m_Prediction[column] = (const float*)(data + layout.prediction[column]);
+		for (size_t offset : layout.particleColumns)
+			m_ParticleColumns.push_back((const float*)(data + offset));
+
+		return true;
+	}
+
+	void Checkpoint::getBodies(std::vector<Body>& bodies) const {
+		bodies.resize(m_Header.bodyCount);
+
+		for (size_t i = 0; i < bodies.size(); ++i) {
+			Body& body = bodies[i];
+			body.pos = { m_BodyColumns[POS_X][i], m_BodyColumns[POS_Y][i], m_BodyColumns[POS_Z][i] };
+			body.vel = { m_BodyColumns[VEL_X][i], m_BodyColumns[VEL_Y][i], m_BodyColumns[VEL_Z][i] };
+			body.mass = m_BodyColumns[MASS][i];
+			body.radius = m_BodyColumns[RADIUS][i];
+			body.type = (Body::Type)m_Types[i];
+		}
+	}
+
+	void Checkpoint::getParticles(ParticleSystem& particles) const {
+		size_t total = 0;
+		for (size_t system = 0; system < m_Header.particleSystemCount; ++system)
+			total += (size_t)m_ParticleCounts[system];
+
+		particles.clear();
+		particles.reserve(total);
+		for (size_t system = 0; system < m_Header.particleSystemCount; ++system) {
+			const float* const* columns = &m_ParticleColumns[system * PARTICLE_COLUMN_COUNT];
+			particles.m_PosX.insert(particles.m_PosX.end(), columns[0], columns[0] + m_ParticleCounts[system]);
+			particles.m_PosY.insert(particles.m_PosY.end(), columns[1], columns[1] + m_ParticleCounts[system]);
+			particles.m_PosZ.insert(particles.m_PosZ.end(), columns[2], columns[2] + m_ParticleCounts[system]);
+			particles.m_VelX.insert(particles.m_VelX.end(), columns[3], columns[3] + m_ParticleCounts[system]);
+			particles.m_VelY.insert(particles.m_VelY.end(), columns[4], columns[4] + m_ParticleCounts[system]);
+			particles.m_VelZ.insert(particles.m_VelZ.end(), columns[5], columns[5] + m_ParticleCounts[system]);
+		}
+	}
+
+	bool Checkpoint::matchBodies(const Engine& engine, std::vector<Body*>& targets) const {
+		targets.assign(engine.m_Bodies.begin(), engine.m_Bodies.end());
+
+		auto sameBody = [this](const Body* body, size_t i) {
+			return body->mass == m_BodyColumns[MASS][i] && body->radius == m_BodyColumns[RADIUS][i];
+		};
+
+		// bodies are saved in address order, which usually survives within a session
+		std::vector<size_t> saved;
+		std::vector<Body*> unmatched;
+		for (size_t i = 0; i < targets.size(); ++i) {
+			if (!sameBody(targets[i], i)) {
+				saved.push_back(i);
+				unmatched.push_back(targets[i]);
+			}
+		}
+		if (saved.empty())
+			return true;
+
+		// the rest is paired by mass and radius, equal bodies are interchangeable
+		auto savedLess = [this](size_t a, size_t b) {
+			return m_BodyColumns[MASS][a] < m_BodyColumns[MASS][b]
+				|| (m_BodyColumns[MASS][a] == m_BodyColumns[MASS][b] && m_BodyColumns[RADIUS][a] < m_BodyColumns[RADIUS][b]);
+		};
+		auto bodyLess = [](const Body* a, const Body* b) {
+			return a->mass < b->mass || (a->mass == b->mass && a->radius < b->radius);
+		};
+		std::stable_sort(saved.begin(), saved.end(), savedLess);
+		std::stable_sort(unmatched.begin(), unmatched.end(), bodyLess);
+
+		for (size_t j = 0; j < saved.size(); ++j) {
+			if (!sameBody(unmatched[j], saved[j])) {
+				utils::printError("Checkpoint body %zu (mass %g, radius %g) has no counterpart in the engine",
+					saved[j], m_BodyColumns[MASS][saved[j]], m_BodyColumns[RADIUS][saved[j]]);
+				return false;
+			}
+			targets[saved[j]] = unmatched[j];
+		}
+
+		return true;
+	}
+
+	bool Checkpoint::restore(Engine& engine) const {
+		if (isEmpty())
+			return false;
+
+		if (engine.m_Bodies.size() != m_Header.bodyCount || engine.m_ParticleSystems.size() != m_Header.particleSystemCount) {
+			utils::printError("Checkpoint holds %u bodies and %u particle systems but the engine has %zu and %zu",
+				m_Header.bodyCount, m_Header.particleSystemCount, engine.m_Bodies.size(), engine.m_ParticleSystems.size());
+			return false;
+		}
+
+		std::vector<Body*> targets;
+		if (!matchBodies(engine, targets))
+			return false;
+
+		for (size_t i = 0; i < targets.size(); ++i) {
+			Body* body = targets[i];
+			body->pos = { m_BodyColumns[POS_X][i], m_BodyColumns[POS_Y][i], m_BodyColumns[POS_Z][i] };
+			body->vel = { m_BodyColumns[VEL_X][i], m_BodyColumns[VEL_Y][i], m_BodyColumns[VEL_Z][i] };
+			body->type = (Body::Type)m_Types[i];
+		}
+
+		// the preview is kept in engine iteration order
+		const uint32_t steps = m_Header.predictionSteps;
+		engine.m_PosPrediction.assign(steps ? m_Header.bodyCount : 0, std::vector<Body>());
+		if (steps) {
+			std::map<const Body*, size_t> slots;
+			for (Body* body : engine.m_Bodies)
+				slots.emplace(body, slots.size());
+
+			for (size_t i = 0; i < targets.size(); ++i) {
+				std::vector<Body>& path = engine.m_PosPrediction[slots[targets[i]]];
+				path.assign(steps, *targets[i]);
+				for (uint32_t step = 0; step < steps; ++step) {
+					size_t index = i * steps + step;
+					path[step].pos = { m_Prediction[0][index], m_Prediction[1][index], m_Prediction[2][index] };
+					path[step].vel = { m_Prediction[3][index], m_Prediction[4][index], m_Prediction[5][index] };
+				}
+			}
+		}
+
+		for (size_t system = 0; system < m_Header.particleSystemCount; ++system) {
+			ParticleSystem& particles = *engine.m_ParticleSystems[system];
+			const size_t count = (size_t)m_ParticleCounts[system];
+			const float* const* columns = &m_ParticleColumns[system * PARTICLE_COLUMN_COUNT];
+
+			particles.m_PosX.assign(columns[0], columns[0] + count);
+			particles.m_PosY.assign(columns[1], columns[1] + count);
+			particles.m_PosZ.assign(columns[2], columns[2] + count);
+			particles.m_VelX.assign(columns[3], columns[3] + count);
+			particles.m_VelY.assign(columns[4], columns[4] + count);
+			particles.m_VelZ.assign(columns[5], columns[5] + count);
+		}
+
+		engine.m_SimTime = m_Header.simTime;
+		engine.timeMultiplier = m_Header.timeMultiplier;
+		engine.m_Timer.deltaTime = m_Header.deltaTime;
+		engine.paused = (m_Header.flags & PAUSED) != 0;
+		engine.predCalculated = (m_Header.flags & PRED_CALCULATED) != 0;
+		engine.predictionEnabled = (m_Header.flags & PREDICTION_ENABLED) != 0;
+		engine.collisionsEnabled = (m_Header.flags & COLLISIONS_ENABLED) != 0;
+
+		// the saved wall clock means nothing now, the next update only resyncs the timer
+		engine.m_SkipIteration = true;
+		if (engine.m_EventDetector)
+			engine.m_EventDetector->invalidate();
+
+		return true;
+	}
+
+}
\ No newline at end of file
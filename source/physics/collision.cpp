@@ -0,0 +1,253 @@
+#include "StarSystemSim/physics/collision.h"
+
+#include "StarSystemSim/physics/particle_system.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace physics {
+
+	static const float MIN_CELL_SIZE = 1e-4f;
+	// boxes spanning more cells than this per axis are paired against everything instead of hashed
+	static const int32_t MAX_BOX_CELLS = 4;
+
+	glm::ivec3 SpatialHash::getCell(const glm::vec3& pos) const {
+		return glm::ivec3(glm::floor(pos / m_CellSize));
+	}
+
+	uint64_t SpatialHash::getKey(const glm::ivec3& cell) {
+		// 21 bits per axis, distant cells may alias which only adds false candidates
+		const uint64_t mask = (1ull << 21) - 1;
+		return (((uint64_t)cell.x & mask) << 42) | (((uint64_t)cell.y & mask) << 21) | ((uint64_t)cell.z & mask);
+	}
+
+	void SpatialHash::build(const std::vector<glm::vec3>& boxMin, const std::vector<glm::vec3>& boxMax, float cellSize) {
+		m_Min = &boxMin;
+		m_Max = &boxMax;
+		m_CellSize = std::max(cellSize, MIN_CELL_SIZE);
+		m_Entries.clear();
+		m_Large.clear();
+
+		for (uint32_t i = 0; i < boxMin.size(); ++i) {
+			glm::ivec3 lo = getCell(boxMin[i]);
+			glm::ivec3 hi = getCell(boxMax[i]);
+
+			if (glm::any(glm::greaterThanEqual(hi - lo, glm::ivec3(MAX_BOX_CELLS)))) {
+				m_Large.push_back(i);
+				continue;
+			}
+
+			for (int32_t x = lo.x; x <= hi.x; ++x)
+				for (int32_t y = lo.y; y <= hi.y; ++y)
+					for (int32_t z = lo.z; z <= hi.z; ++z)
+						m_Entries.push_back({ getKey(glm::ivec3(x, y, z)), i });
+		}
+
+		std::sort(m_Entries.begin(), m_Entries.end(), [](const Entry& a, const Entry& b) {
+			return a.key < b.key || (a.key == b.key && a.index < b.index);
+		});
+	}
+
+	void SpatialHash::findPairs(std::vector<std::pair<uint32_t, uint32_t>>& pairs) const {
+		pairs.clear();
+
+		size_t runStart = 0;
+		while (runStart < m_Entries.size()) {
+			size_t runEnd = runStart + 1;
+			while (runEnd < m_Entries.size() && m_Entries[runEnd].key == m_Entries[runStart].key)
+				++runEnd;
+
+			for (size_t i = runStart; i < runEnd; ++i) {
+				for (size_t j = i + 1; j < runEnd; ++j) {
+					uint32_t a = m_Entries[i].index, b = m_Entries[j].index;
+					glm::vec3 overlapMin = glm::max((*m_Min)[a], (*m_Min)[b]);
+					glm::vec3 overlapMax = glm::min((*m_Max)[a], (*m_Max)[b]);
+
+					if (glm::any(glm::greaterThan(overlapMin, overlapMax)))
+						continue;
+
+					// a pair sharing several cells is only reported by the cell holding its overlap's corner
+					if (getKey(getCell(overlapMin)) != m_Entries[runStart].key)
+						continue;
+
+					pairs.push_back({ a, b });
+				}
+			}
+
+			runStart = runEnd;
+		}
+
+		// a large box against every other box, a pair of large ones only once
+		for (size_t l = 0; l < m_Large.size(); ++l) {
+			uint32_t a = m_Large[l];
+			for (uint32_t b = 0; b < m_Min->size(); ++b) {
+				if (b == a || (isLarge(b) && b < a))
+					continue;
+				if (glm::all(glm::lessThanEqual((*m_Min)[a], (*m_Max)[b])) && glm::all(glm::lessThanEqual((*m_Min)[b], (*m_Max)[a])))
+					pairs.push_back({ std::min(a, b), std::max(a, b) });
+			}
+		}
+	}
+
+	bool SpatialHash::isLarge(uint32_t index) const {
+		return std::binary_search(m_Large.begin(), m_Large.end(), index);
+	}
+
+	void SpatialHash::query(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<uint32_t>& result) const {
+		result.clear();
+
+		for (uint32_t index : m_Large) {
+			if (glm::all(glm::lessThanEqual((*m_Min)[index], boxMax)) && glm::all(glm::lessThanEqual(boxMin, (*m_Max)[index])))
+				result.push_back(index);
+		}
+
+		glm::ivec3 lo = getCell(boxMin);
+		glm::ivec3 hi = getCell(boxMax);
+
+		for (int32_t x = lo.x; x <= hi.x; ++x) {
+			for (int32_t y = lo.y; y <= hi.y; ++y) {
+				for (int32_t z = lo.z; z <= hi.z; ++z) {
+					uint64_t key = getKey(glm::ivec3(x, y, z));
+					auto iter = std::lower_bound(m_Entries.begin(), m_Entries.end(), key, [](const Entry& entry, uint64_t key) {
+						return entry.key < key;
+					});
+
+					for (; iter != m_Entries.end() && iter->key == key; ++iter) {
+						uint32_t index = iter->index;
+						if (glm::all(glm::lessThanEqual((*m_Min)[index], boxMax)) && glm::all(glm::lessThanEqual(boxMin, (*m_Max)[index])))
+							result.push_back(index);
+					}
+				}
+			}
+		}
+	}
+
+	float calcContactTime(const glm::vec3& posA, const glm::vec3& velA, float radiusA,
+		const glm::vec3& posB, const glm::vec3& velB, float radiusB, float deltaTime)
+	{
+		// |p + v t| = r solved for the smallest t in [0, deltaTime]
+		glm::vec3 p = posB - posA;
+		glm::vec3 v = velB - velA;
+		float r = radiusA + radiusB;
+		// point masses never touch
+		if (r <= 0.0f)
+			return -1.0f;
+
+		float c = glm::dot(p, p) - r * r;
+		if (c <= 0.0f)
+			return 0.0f;
+
+		float a = glm::dot(v, v);
+		float b = glm::dot(p, v);
+		if (a <= 0.0f || b >= 0.0f)
+			return -1.0f;
+
+		// b * b and a * c are nearly equal for grazing paths, a difference within their rounding is a miss
+		float discriminant = b * b - a * c;
+		if (discriminant <= 4.0f * FLT_EPSILON * a * c)
+			return -1.0f;
+
+		float t = (-b - std::sqrt(discriminant)) / a;
+		return t <= deltaTime ? t : -1.0f;
+	}
+
+	void CollisionDetector::findContacts(const std::vector<glm::vec3>& pos, const std::vector<glm::vec3>& vel,
+		const std::vector<float>& radius, float deltaTime, std::vector<Contact>& contacts)
+	{
+		contacts.clear();
+
+		m_BoxMin.resize(pos.size());
+		m_BoxMax.resize(pos.size());
+
+		m_Sizes.resize(pos.size());
+		for (size_t i = 0; i < pos.size(); ++i) {
+			glm::vec3 end = pos[i] + vel[i] * deltaTime;
+			m_BoxMin[i] = glm::min(pos[i], end) - radius[i];
+			m_BoxMax[i] = glm::max(pos[i], end) + radius[i];
+			glm::vec3 size = m_BoxMax[i] - m_BoxMin[i];
+			m_Sizes[i] = std::max(size.x, std::max(size.y, size.z));
+		}
+
+		// cells fit the typical box, the few much larger ones are kept out of the grid
+		float cellSize = 0.0f;
+		if (!m_Sizes.empty()) {
+			auto median = m_Sizes.begin() + m_Sizes.size() / 2;
+			std::nth_element(m_Sizes.begin(), median, m_Sizes.end());
+			cellSize = *median;
+		}
+
+		m_Hash.build(m_BoxMin, m_BoxMax, cellSize);
+		m_Hash.findPairs(m_Pairs);
+
+		for (const auto& pair : m_Pairs) {
+			float time = calcContactTime(pos[pair.first], vel[pair.first], radius[pair.first],
+				pos[pair.second], vel[pair.second], radius[pair.second], deltaTime);
+
+			if (time >= 0.0f)
+				contacts.push_back({ pair.first, pair.second, time });
+		}
+
+		std::sort(contacts.begin(), contacts.end(), [](const Contact& a, const Contact& b) {
+			return a.time < b.time;
+		});
+	}
+
+	void CollisionDetector::findParticleHits(const ParticleSystem& particles, const std::vector<glm::vec3>& pos,
+		const std::vector<glm::vec3>& vel, const std::vector<float>& radius, float deltaTime,
+		std::vector<uint32_t>& hits)
+	{
+		hits.clear();
+
+		const size_t count = particles.getCount();
+		if (count == 0 || pos.empty())
+			return;
+
+		// bodies without a radius are never hit, there is no need to hash the particles
+		if (std::none_of(radius.begin(), radius.end(), [](float r) { return r > 0.0f; }))
+			return;
+
+		m_BoxMin.resize(count);
+		m_BoxMax.resize(count);
+
+		float maxTravel = 0.0f;
+		for (size_t i = 0; i < count; ++i) {
+			glm::vec3 start = particles.getPos(i);
+			glm::vec3 end = start + particles.getVel(i) * deltaTime;
+			m_BoxMin[i] = glm::min(start, end);
+			m_BoxMax[i] = glm::max(start, end);
+			maxTravel = std::max(maxTravel, glm::length(m_BoxMax[i] - m_BoxMin[i]));
+		}
+
+		float maxRadius = 0.0f;
+		for (size_t b = 0; b < pos.size(); ++b) {
+			maxRadius = std::max(maxRadius, radius[b] + glm::length(vel[b]) * deltaTime);
+		}
+
+		// cells about the size of the largest body keep queries to a handful of cells
+		m_Hash.build(m_BoxMin, m_BoxMax, std::max(2.0f * maxRadius, maxTravel));
+
+		for (size_t b = 0; b < pos.size(); ++b) {
+			if (radius[b] <= 0.0f)
+				continue;
+
+			glm::vec3 end = pos[b] + vel[b] * deltaTime;
+			m_Hash.query(glm::min(pos[b], end) - radius[b], glm::max(pos[b], end) + radius[b], m_Candidates);
+
+			for (uint32_t particle : m_Candidates) {
+				float time = calcContactTime(pos[b], vel[b], radius[b],
+					particles.getPos(particle), particles.getVel(particle), 0.0f, deltaTime);
+
+				if (time >= 0.0f)
+					hits.push_back(particle);
+			}
+		}
+
+		std::sort(hits.begin(), hits.end());
+		hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "StarSystemSim/physics/diagnostics.h"
+
+#include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/engine.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace physics {
+
+	void Invariants::addMotion(const Body& body, const glm::dvec3& origin) {
+		if (body.type != Body::Type::DYNAMIC)
+			return;
+
+		const glm::dvec3 vel(body.vel);
+		kinetic += 0.5 * body.mass * glm::dot(vel, vel);
+		momentum += vel * (double)body.mass;
+		angularMomentum += glm::cross(glm::dvec3(body.pos) - origin, vel) * (double)body.mass;
+	}
+
+	Invariants measureInvariants(const std::vector<Body>& bodies) {
+		Invariants invariants = { 0.0, 0.0, glm::dvec3(0.0), glm::dvec3(0.0) };
+
+		glm::dvec3 origin(0.0);
+		double staticMass = 0.0;
+		for (const Body& body : bodies) {
+			if (body.type == Body::Type::STATIC) {
+				origin += glm::dvec3(body.pos) * (double)body.mass;
+				staticMass += body.mass;
+			}
+		}
+		if (staticMass > 0.0)
+			origin /= staticMass;
+
+		for (size_t a = 0; a < bodies.size(); ++a) {
+			const Body& bodyA = bodies[a];
+			const glm::dvec3 posA(bodyA.pos);
+			invariants.addMotion(bodyA, origin);
+
+			for (size_t b = a + 1; b < bodies.size(); ++b) {
+				double dist = glm::length(glm::dvec3(bodies[b].pos) - posA);
+				if (dist > 0.0)
+					invariants.potential -= (double)GRAVITATIONAL_CONSTANT * bodyA.mass * bodies[b].mass / dist;
+			}
+		}
+
+		return invariants;
+	}
+
+	Drift getDrift(const Invariants& invariants, const Invariants& reference) {
+		return {
+			getRelativeError(invariants.getEnergy(), reference.getEnergy()),
+			getRelativeError(invariants.momentum, reference.momentum),
+			getRelativeError(invariants.angularMomentum, reference.angularMomentum)
+		};
+	}
+
+	double getRelativeError(double value, double reference) {
+		double error = std::abs(value - reference);
+		return reference != 0.0 ? error / std::abs(reference) : error;
+	}
+
+	double getRelativeError(const glm::dvec3& value, const glm::dvec3& reference) {
+		double error = glm::length(value - reference);
+		double size = glm::length(reference);
+		return size > 0.0 ? error / size : error;
+	}
+
+	double getPositionError(const std::vector<Body>& bodies, const std::vector<Body>& reference) {
+		double error = 0.0;
+		for (size_t i = 0; i < std::min(bodies.size(), reference.size()); ++i)
+			error = std::max(error, glm::length(glm::dvec3(bodies[i].pos) - glm::dvec3(reference[i].pos)));
+		return error;
+	}
+
+}
\ No newline at end of file
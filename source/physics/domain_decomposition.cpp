@@ -0,0 +1,216 @@
+#include "StarSystemSim/physics/domain_decomposition.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace physics {
+
+	DomainDecomposition::DomainDecomposition(Transport& transport)
+		: DomainDecomposition(transport, Settings())
+	{}
+
+	DomainDecomposition::DomainDecomposition(Transport& transport, const Settings& settings)
+		: m_Transport(transport), m_Settings(settings),
+		m_BodyCount(0), m_Steps(0), m_Time(0.0)
+	{
+		m_Settings.cellsPerAxis = std::max(m_Settings.cellsPerAxis, 1u);
+		m_Settings.rebalanceEvery = std::max(m_Settings.rebalanceEvery, 1u);
+	}
+
+	size_t DomainDecomposition::getMaxMessageSize(size_t bodyCount) {
+		return std::max(bodyCount * sizeof(Record), bodyCount * sizeof(Source));
+	}
+
+	void DomainDecomposition::init(const std::vector<Body>& bodies, double startTime) {
+		m_BodyCount = bodies.size();
+		m_Steps = 0;
+		m_Time = startTime;
+
+		std::vector<Record> records(bodies.size());
+		for (size_t i = 0; i < bodies.size(); ++i) {
+			records[i] = { bodies[i].pos, bodies[i].vel, bodies[i].mass, bodies[i].radius, (uint32_t)i,
+				bodies[i].type == Body::Type::DYNAMIC ? 1u : 0u };
+		}
+
+		// every rank sees the same input and so draws the same domains
+		partition(records, 0, records.size(), 0, m_Transport.getRankCount());
+
+		exchangeSources();
+		calcAccelerations();
+	}
+
+	void DomainDecomposition::partition(std::vector<Record>& records, size_t begin, size_t end,
+		uint32_t rankBegin, uint32_t rankEnd)
+	{
+		if (rankEnd - rankBegin == 1) {
+			if (rankBegin == m_Transport.getRank())
+				m_Local.assign(records.begin() + begin, records.begin() + end);
+			return;
+		}
+
+		glm::vec3 low(INFINITY), high(-INFINITY);
+		for (size_t i = begin; i < end; ++i) {
+			low = glm::min(low, records[i].pos);
+			high = glm::max(high, records[i].pos);
+		}
+
+		glm::vec3 extent = high - low;
+		int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+		// bodies are split in proportion to the ranks on either side
+		uint32_t rankMid = rankBegin + (rankEnd - rankBegin) / 2;
+		size_t mid = begin + (end - begin) * (rankMid - rankBegin) / (rankEnd - rankBegin);
+
+		std::nth_element(records.begin() + begin, records.begin() + mid, records.begin() + end,
+			[axis](const Record& a, const Record& b) {
+				return a.pos[axis] < b.pos[axis] || (a.pos[axis] == b.pos[axis] && a.id < b.id);
+			});
+
+		partition(records, begin, mid, rankBegin, rankMid);
+		partition(records, mid, end, rankMid, rankEnd);
+	}
+
+	void DomainDecomposition::rebalance() {
+		m_Transport.allGather(m_Local.data(), m_Local.size() * sizeof(Record), m_Received);
+
+		std::vector<Record> records;
+		records.reserve(m_BodyCount);
+		for (const std::vector<uint8_t>& message : m_Received) {
+			size_t count = message.size() / sizeof(Record);
+			size_t offset = records.size();
+			records.resize(offset + count);
+			std::memcpy(records.data() + offset, message.data(), count * sizeof(Record));
+		}
+
+		std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return a.id < b.id; });
+		partition(records, 0, records.size(), 0, m_Transport.getRankCount());
+	}
+
+	void DomainDecomposition::exchangeSources() {
+		m_Outgoing.clear();
+
+		if (!m_Local.empty()) {
+			glm::vec3 low(INFINITY), high(-INFINITY);
+			for (const Record& record : m_Local) {
+				low = glm::min(low, record.pos);
+				high = glm::max(high, record.pos);
+			}
+
+			const uint32_t cells = m_Settings.cellsPerAxis;
+			glm::vec3 cellSize = glm::max(high - low, glm::vec3(1e-6f)) / (float)cells;
+			std::vector<Source> grid((size_t)cells * cells * cells, Source{ glm::vec3(0.0f), 0.0f });
+
+			for (const Record& record : m_Local) {
+				glm::vec3 toSurface = glm::min(record.pos - low, high - record.pos);
+				float depth = std::min(toSurface.x, std::min(toSurface.y, toSurface.z));
+
+				if (depth < m_Settings.boundaryWidth) {
+					m_Outgoing.push_back({ record.pos, record.mass });
+					continue;
+				}
+
+				glm::ivec3 cell = glm::clamp(glm::ivec3((record.pos - low) / cellSize), glm::ivec3(0), glm::ivec3(cells - 1));
+				Source& source = grid[((size_t)cell.z * cells + cell.y) * cells + cell.x];
+				source.pos += record.pos * record.mass;
+				source.mass += record.mass;
+			}
+
+			for (Source& source : grid) {
+				if (source.mass > 0.0f)
+					m_Outgoing.push_back({ source.pos / source.mass, source.mass });
+			}
+		}
+
+		m_Transport.allGather(m_Outgoing.data(), m_Outgoing.size() * sizeof(Source), m_Received);
+
+		m_Remote.clear();
+		for (uint32_t rank = 0; rank < m_Received.size(); ++rank) {
+			if (rank == m_Transport.getRank())
+				continue;
+
+			size_t count = m_Received[rank].size() / sizeof(Source);
+			size_t offset = m_Remote.size();
+			m_Remote.resize(offset + count);
+			std::memcpy(m_Remote.data() + offset, m_Received[rank].data(), count * sizeof(Source));
+		}
+	}
+
+	void DomainDecomposition::calcAccelerations() {
+		m_Acc.assign(m_Local.size(), glm::vec3(0.0f));
+
+		// same law as Engine
+		for (size_t a = 0; a < m_Local.size(); ++a) {
+			for (size_t b = a + 1; b < m_Local.size(); ++b) {
+				glm::vec3 AtoB = m_Local[b].pos - m_Local[a].pos;
+				float distSq = AtoB.x * AtoB.x + AtoB.y * AtoB.y + AtoB.z * AtoB.z;
+				if (distSq <= 0.0f)
+					continue;
+
+				float invDist = 1.0f / std::sqrt(distSq);
+				glm::vec3 scaled = AtoB * (GRAVITATIONAL_CONSTANT * invDist * invDist * invDist);
+				m_Acc[a] += scaled * m_Local[b].mass;
+				m_Acc[b] -= scaled * m_Local[a].mass;
+			}
+
+			for (const Source& source : m_Remote) {
+				glm::vec3 AtoB = source.pos - m_Local[a].pos;
+				float distSq = AtoB.x * AtoB.x + AtoB.y * AtoB.y + AtoB.z * AtoB.z;
+				if (distSq <= 0.0f)
+					continue;
+
+				float invDist = 1.0f / std::sqrt(distSq);
+				m_Acc[a] += AtoB * (GRAVITATIONAL_CONSTANT * source.mass * invDist * invDist * invDist);
+			}
+		}
+	}
+
+	void DomainDecomposition::step(float deltaTime) {
+		for (size_t i = 0; i < m_Local.size(); ++i) {
+			Record& record = m_Local[i];
+			record.vel += m_Acc[i] * (0.5f * deltaTime);
+			if (record.dynamic)
+				record.pos += record.vel * deltaTime;
+		}
+
+		if (++m_Steps % m_Settings.rebalanceEvery == 0)
+			rebalance();
+
+		exchangeSources();
+		calcAccelerations();
+
+		for (size_t i = 0; i < m_Local.size(); ++i) {
+			m_Local[i].vel += m_Acc[i] * (0.5f * deltaTime);
+		}
+
+		m_Time += deltaTime;
+	}
+
+	void DomainDecomposition::gather(std::vector<Body>& bodies) {
+		m_Transport.allGather(m_Local.data(), m_Local.size() * sizeof(Record), m_Received);
+
+		bodies.resize(m_BodyCount);
+		for (const std::vector<uint8_t>& message : m_Received) {
+			size_t count = message.size() / sizeof(Record);
+			for (size_t i = 0; i < count; ++i) {
+				Record record;
+				std::memcpy(&record, message.data() + i * sizeof(Record), sizeof(Record));
+				if (record.id >= m_BodyCount)
+					continue;
+
+				Body& body = bodies[record.id];
+				body.pos = record.pos;
+				body.vel = record.vel;
+				body.mass = record.mass;
+				body.radius = record.radius;
+				body.type = record.dynamic ? Body::Type::DYNAMIC : Body::Type::STATIC;
+			}
+		}
+	}
+
+}
\ No newline at end of file
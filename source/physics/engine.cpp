@@ -1,15 +1,28 @@
 #include "StarSystemSim/physics/engine.h"
 
 #include "StarSystemSim/physics/body.h"
+#include "StarSystemSim/physics/ephemeris.h"
+#include "StarSystemSim/physics/particle_system.h"
+#include "StarSystemSim/physics/event_detector.h"
+#include "StarSystemSim/physics/trajectory.h"
+#include "StarSystemSim/physics/timeline.h"
+#include "StarSystemSim/utilities/error.h"
+#include "StarSystemSim/utilities/profiler.h"
+#include "StarSystemSim/utilities/alloc_tracker.h"
 
 #include <glm/geometric.hpp>
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 
 namespace physics {
 
 	Engine::Engine()
-		: paused(true), predCalculated(false),
-		m_SkipIteration(true)
+		: paused(true), predCalculated(false), predictionEnabled(true), collisionsEnabled(true),
+		m_SkipIteration(true), m_SimTime(0.0), m_Interactions(0),
+		m_Invariants(), m_InitialInvariants(), m_HasInitialInvariants(false),
+		m_Ephemeris(nullptr), m_EventDetector(nullptr), m_Recorder(nullptr),
+		m_Timeline(nullptr), m_PerfCounters(nullptr), m_PhaseCounters()
 	{
 		this->timeMultiplier = 1.0f;
 	}
@@ -20,34 +33,296 @@ namespace physics {
 
 	void Engine::addBody(Body* body) {
 		m_Bodies.insert(body);
+		m_HasInitialInvariants = false;
+	}
+
+	Body* Engine::addBodies(const std::vector<Body>& bodies) {
+		if (bodies.empty())
+			return nullptr;
+
+		m_OwnedBodies.emplace_back(new Body[bodies.size()]);
+		Body* block = m_OwnedBodies.back().get();
+		std::copy(bodies.begin(), bodies.end(), block);
+
+		// consecutive addresses, so the hint is right unless an older block lies higher
+		for (size_t i = 0; i < bodies.size(); ++i)
+			m_Bodies.insert(m_Bodies.end(), block + i);
+		m_HasInitialInvariants = false;
+
+		return block;
 	}
 
 	void Engine::remBody(Body* body) {
 		m_Bodies.erase(body);
+		m_HasInitialInvariants = false;
+
+		if (m_EventDetector)
+			m_EventDetector->forget(body);
+	}
+
+	void Engine::addParticleSystem(ParticleSystem* particles) {
+		if (std::find(m_ParticleSystems.begin(), m_ParticleSystems.end(), particles) == m_ParticleSystems.end())
+			m_ParticleSystems.push_back(particles);
+	}
+
+	void Engine::remParticleSystem(ParticleSystem* particles) {
+		m_ParticleSystems.erase(std::remove(m_ParticleSystems.begin(), m_ParticleSystems.end(), particles), m_ParticleSystems.end());
 	}
 
 	void Engine::update() {
+		PROFILE_ZONE("engine update");
 		m_Timer.measureTime();
 		m_Timer.deltaTime *= this->paused ? 0.0f : this->timeMultiplier;
 
 		m_Timer.deltaTime = std::min(m_Timer.deltaTime, MAX_DELTA_TIME);
 
+		bool playback = m_Ephemeris && m_Ephemeris->covers(m_SimTime + m_Timer.deltaTime);
+
 		if (m_SkipIteration) {
 			m_SkipIteration = false;
 		}
+		else if (playback) {
+			PROFILE_ZONE("ephemeris playback");
+			if (m_EventDetector)
+				m_EventDetector->beginStep();
+
+			{
+				PhaseCounterScope counters(*this, Phase::PARTICLES);
+				advanceParticles();
+			}
+			evalEphemeris(m_SimTime + m_Timer.deltaTime);
+
+			if (m_EventDetector)
+				m_EventDetector->endStep(m_SimTime, m_Timer.deltaTime);
+			m_SimTime += m_Timer.deltaTime;
+
+			if (m_Recorder) {
+				PhaseCounterScope counters(*this, Phase::RECORDING);
+				m_Recorder->record(*this);
+			}
+		}
 		else {
+			if (m_EventDetector)
+				m_EventDetector->beginStep();
+
+			double startTime = m_SimTime;
+			simulateStep(m_Timer.deltaTime);
+
+			if (m_EventDetector)
+				m_EventDetector->endStep(startTime, m_Timer.deltaTime);
+
+			if (m_Recorder) {
+				PhaseCounterScope counters(*this, Phase::RECORDING);
+				m_Recorder->record(*this);
+			}
+			if (m_Timeline)
+				m_Timeline->onStep(*this, m_Timer.deltaTime);
+		}
+
+		if (predictionEnabled && (!paused || !predCalculated)) {
+			PROFILE_ZONE("prediction");
+			PhaseCounterScope counters(*this, playback ? Phase::EPHEMERIS_PREDICTION : Phase::PREDICTION);
+			if (playback)
+				evalFuturePos(PREDICTION_STEPS, PREDICTION_STEP);
+			else
+				calcFuturePos(PREDICTION_STEPS, PREDICTION_STEP);
+		}
+	}
+
+	void Engine::simulateStep(float deltaTime) {
+		m_Timer.deltaTime = deltaTime;
+
+		{
+			PROFILE_ZONE("gravity");
+			NO_ALLOC_SCOPE("gravity");
+			PhaseCounterScope counters(*this, Phase::GRAVITY);
 			applyGravityForce();
+		}
+		if (collisionsEnabled) {
+			PROFILE_ZONE("collisions");
+			PhaseCounterScope counters(*this, Phase::COLLISIONS);
+			resolveCollisions();
+		}
+		{
+			PROFILE_ZONE("particles");
+			PhaseCounterScope counters(*this, Phase::PARTICLES);
+			advanceParticles();
+		}
+		{
+			PROFILE_ZONE("advance");
+			NO_ALLOC_SCOPE("advance");
+			PhaseCounterScope counters(*this, Phase::ADVANCE);
 			advanceBodies();
 		}
 
-		if (!paused || !predCalculated)
-			calcFuturePos(300, 0.04f);
+		m_SimTime += deltaTime;
+	}
+
+	void Engine::runPhase(Phase phase, float deltaTime) {
+		m_Timer.deltaTime = deltaTime;
+
+		switch (phase) {
+			case Phase::GRAVITY: applyGravityForce(); break;
+			case Phase::COLLISIONS: resolveCollisions(); break;
+			case Phase::PARTICLES: advanceParticles(); break;
+			case Phase::ADVANCE: advanceBodies(); break;
+			case Phase::PREDICTION: calcFuturePos(PREDICTION_STEPS, PREDICTION_STEP); break;
+			case Phase::EPHEMERIS_PREDICTION:
+				if (m_Ephemeris)
+					evalFuturePos(PREDICTION_STEPS, PREDICTION_STEP);
+				else
+					utils::printError("No ephemeris to predict from");
+				break;
+			case Phase::RECORDING:
+				if (m_Recorder)
+					m_Recorder->record(*this);
+				else
+					utils::printError("No recorder to record into");
+				break;
+		}
+	}
+
+	const char* Engine::getPhaseName(Phase phase) {
+		switch (phase) {
+			case Phase::GRAVITY: return "gravity";
+			case Phase::COLLISIONS: return "collisions";
+			case Phase::PARTICLES: return "particles";
+			case Phase::ADVANCE: return "advance";
+			case Phase::PREDICTION: return "prediction";
+			case Phase::EPHEMERIS_PREDICTION: return "ephemeris_prediction";
+			case Phase::RECORDING: return "recording";
+		}
+		return "unknown";
+	}
+
+	Engine::PhaseCounterScope::PhaseCounterScope(Engine& engine, Phase phase)
+		: m_Engine(engine), m_Phase(phase), m_Start(), m_Interactions(engine.m_Interactions)
+	{
+		if (m_Engine.m_PerfCounters)
+			m_Start = m_Engine.m_PerfCounters->read();
+	}
+
+	Engine::PhaseCounterScope::~PhaseCounterScope() {
+		if (!m_Engine.m_PerfCounters)
+			return;
+
+		PhaseCounters& counters = m_Engine.m_PhaseCounters[(uint32_t)m_Phase];
+		counters.values += m_Engine.m_PerfCounters->read() - m_Start;
+		counters.interactions += m_Engine.m_Interactions - m_Interactions;
+		counters.runs += 1;
 	}
 
 	void Engine::skipIteration() {
 		m_SkipIteration = true;
 	}
 
+	void Engine::getBodies(std::vector<Body>& bodies) const {
+		bodies.clear();
+		bodies.reserve(m_Bodies.size());
+
+		for (Body* body : m_Bodies) {
+			bodies.push_back(*body);
+		}
+	}
+
+	void Engine::setBodies(const std::vector<Body>& bodies) {
+		if (bodies.size() != m_Bodies.size()) {
+			utils::printError("Got %zu bodies for an engine with %zu", bodies.size(), m_Bodies.size());
+			return;
+		}
+
+		size_t i = 0;
+		for (Body* body : m_Bodies) {
+			*body = bodies[i++];
+		}
+		predCalculated = false;
+
+		if (m_EventDetector)
+			m_EventDetector->invalidate();
+	}
+
+	size_t Engine::getBodyIndex(const Body* body) const {
+		auto it = m_Bodies.find(const_cast<Body*>(body));
+		return it == m_Bodies.end() ? m_Bodies.size() : (size_t)std::distance(m_Bodies.begin(), it);
+	}
+
+	size_t Engine::getParticleCount() const {
+		size_t count = 0;
+		for (const ParticleSystem* particles : m_ParticleSystems)
+			count += particles->getCount();
+		return count;
+	}
+
+	void Engine::setEphemeris(const Ephemeris* ephemeris) {
+		if (ephemeris && ephemeris->getBodyCount() != m_Bodies.size()) {
+			utils::printError("Ephemeris holds %zu bodies but the engine has %zu", ephemeris->getBodyCount(), m_Bodies.size());
+			return;
+		}
+		if (ephemeris && !matchEphemeris(*ephemeris))
+			return;
+
+		m_Ephemeris = ephemeris;
+		predCalculated = false;
+	}
+
+	bool Engine::matchEphemeris(const Ephemeris& ephemeris) {
+		std::vector<const Body*> bodies(m_Bodies.begin(), m_Bodies.end());
+		m_EphemerisBodies.resize(bodies.size());
+
+		auto sameBody = [&ephemeris](const Body* body, size_t i) {
+			return body->mass == ephemeris.getMass(i) && body->radius == ephemeris.getRadius(i) && body->type == ephemeris.getType(i);
+		};
+
+		// the order is that of heap addresses, which usually only holds within a session
+		std::vector<uint32_t> slots, unmatched;
+		for (size_t i = 0; i < bodies.size(); ++i) {
+			m_EphemerisBodies[i] = (uint32_t)i;
+			if (!sameBody(bodies[i], i)) {
+				slots.push_back((uint32_t)i);
+				unmatched.push_back((uint32_t)i);
+			}
+		}
+		if (slots.empty())
+			return true;
+
+		// the rest is paired by type, mass and radius, equal bodies are interchangeable
+		auto bodyLess = [&bodies](uint32_t a, uint32_t b) {
+			const Body* x = bodies[a];
+			const Body* y = bodies[b];
+			return x->type != y->type ? x->type < y->type
+				: (x->mass != y->mass ? x->mass < y->mass : x->radius < y->radius);
+		};
+		auto ephemerisLess = [&ephemeris](uint32_t a, uint32_t b) {
+			return ephemeris.getType(a) != ephemeris.getType(b) ? ephemeris.getType(a) < ephemeris.getType(b)
+				: (ephemeris.getMass(a) != ephemeris.getMass(b) ? ephemeris.getMass(a) < ephemeris.getMass(b)
+				: ephemeris.getRadius(a) < ephemeris.getRadius(b));
+		};
+		std::stable_sort(slots.begin(), slots.end(), bodyLess);
+		std::stable_sort(unmatched.begin(), unmatched.end(), ephemerisLess);
+
+		for (size_t j = 0; j < slots.size(); ++j) {
+			if (!sameBody(bodies[slots[j]], unmatched[j])) {
+				utils::printError("Ephemeris body %u (mass %g, radius %g) has no counterpart in the engine",
+					unmatched[j], ephemeris.getMass(unmatched[j]), ephemeris.getRadius(unmatched[j]));
+				m_EphemerisBodies.clear();
+				return false;
+			}
+			m_EphemerisBodies[slots[j]] = unmatched[j];
+		}
+
+		return true;
+	}
+
+	void Engine::setSimTime(double time) {
+		m_SimTime = time;
+		predCalculated = false;
+
+		if (m_Ephemeris && m_Ephemeris->covers(time))
+			evalEphemeris(time);
+		if (m_EventDetector)
+			m_EventDetector->invalidate();
+	}
+
 	void Engine::getPredictedPos(std::vector<glm::vec3>& positions) {
 		positions.clear();
 		
@@ -63,22 +338,51 @@ namespace physics {
 	}
 
 	void Engine::applyGravityForce() {
+		m_Interactions += (uint64_t)m_Bodies.size() * (m_Bodies.size() - std::min<size_t>(m_Bodies.size(), 1)) / 2;
+
+		// the velocities are still those of the step's start, so the motion is
+		// taken here and the pairs add the potential energy as they go
+		glm::dvec3 origin(0.0);
+		double staticMass = 0.0;
+		for (const Body* body : m_Bodies) {
+			if (body->type == Body::Type::STATIC) {
+				origin += glm::dvec3(body->pos) * (double)body->mass;
+				staticMass += body->mass;
+			}
+		}
+		if (staticMass > 0.0)
+			origin /= staticMass;
+
+		m_Invariants = Invariants();
+		for (const Body* body : m_Bodies)
+			m_Invariants.addMotion(*body, origin);
+
+		double potential = 0.0;
 		for (auto iterA = m_Bodies.begin(); iterA != m_Bodies.end(); ++iterA) {
 			for (auto iterB = iterA; iterB != m_Bodies.end(); ++iterB) {
 				if (iterA == iterB)
 					continue;
 
-				calcGravityVelChange(**iterA, **iterB, m_Timer.deltaTime);
+				potential += calcGravityVelChange(**iterA, **iterB, m_Timer.deltaTime);
 			}
 		}
+		m_Invariants.potential = potential;
+
+		if (!m_HasInitialInvariants) {
+			m_InitialInvariants = m_Invariants;
+			m_HasInitialInvariants = true;
+		}
 	}
 
-	void Engine::calcGravityVelChange(Body& bodyA, Body& bodyB, float deltaTime) {
+	float Engine::calcGravityVelChange(Body& bodyA, Body& bodyB, float deltaTime) {
 		// calculating the gravity force
 		// F = m * a = G * (M1 * M2) / (R^2)
 		glm::vec3 AtoB = bodyB.pos - bodyA.pos;
 		glm::vec3 AtoBsq = AtoB * AtoB;
 		float dist = sqrt(AtoBsq.x + AtoBsq.y + AtoBsq.z);
+		if (dist <= 0.0f)
+			return 0.0f;
+
 		float forceMag = GRAVITATIONAL_CONSTANT * (bodyA.mass * bodyB.mass) / (dist*dist);
 
 		glm::vec3 accA = glm::normalize(AtoB) * (forceMag / bodyA.mass);
@@ -86,6 +390,8 @@ namespace physics {
 
 		bodyA.vel += accA * deltaTime;
 		bodyB.vel += accB * deltaTime;
+
+		return -forceMag * dist;
 	}
 
 	void Engine::advanceBodies() {
@@ -96,6 +402,120 @@ namespace physics {
 		}
 	}
 
+	void Engine::advanceParticles() {
+		if (m_ParticleSystems.empty())
+			return;
+
+		m_AttrX.clear();
+		m_AttrY.clear();
+		m_AttrZ.clear();
+		m_AttrGM.clear();
+
+		for (Body* body : m_Bodies) {
+			m_AttrX.push_back(body->pos.x);
+			m_AttrY.push_back(body->pos.y);
+			m_AttrZ.push_back(body->pos.z);
+			m_AttrGM.push_back(GRAVITATIONAL_CONSTANT * body->mass);
+		}
+
+		for (ParticleSystem* particles : m_ParticleSystems) {
+			m_Interactions += (uint64_t)particles->getCount() * m_AttrGM.size();
+			particles->accelerate(m_AttrX.data(), m_AttrY.data(), m_AttrZ.data(), m_AttrGM.data(), m_AttrGM.size(), m_Timer.deltaTime);
+			particles->advance(m_Timer.deltaTime);
+		}
+	}
+
+	void Engine::resolveCollisions() {
+		const float deltaTime = m_Timer.deltaTime;
+		if (deltaTime <= 0.0f)
+			return;
+
+		m_BodyList.assign(m_Bodies.begin(), m_Bodies.end());
+		m_CollPos.resize(m_BodyList.size());
+		m_CollVel.resize(m_BodyList.size());
+		m_CollRadius.resize(m_BodyList.size());
+
+		float maxRadius = 0.0f;
+		for (size_t i = 0; i < m_BodyList.size(); ++i) {
+			m_CollPos[i] = m_BodyList[i]->pos;
+			m_CollVel[i] = m_BodyList[i]->type == Body::Type::DYNAMIC ? m_BodyList[i]->vel : glm::vec3(0.0f);
+			m_CollRadius[i] = m_BodyList[i]->radius;
+			maxRadius = std::max(maxRadius, m_CollRadius[i]);
+		}
+
+		// point masses neither touch each other nor absorb particles
+		if (maxRadius <= 0.0f)
+			return;
+
+		// particles hitting a body are absorbed, the body is too heavy for them to matter
+		for (ParticleSystem* particles : m_ParticleSystems) {
+			m_CollisionDetector.findParticleHits(*particles, m_CollPos, m_CollVel, m_CollRadius, deltaTime, m_ParticleHits);
+			particles->removeParticles(m_ParticleHits);
+		}
+
+		m_CollisionDetector.findContacts(m_CollPos, m_CollVel, m_CollRadius, deltaTime, m_Contacts);
+		if (m_Contacts.empty())
+			return;
+
+		// a step only has a handful of contacts, so the absorbed bodies are looked up linearly
+		m_Merges.clear();
+		m_Absorbed.clear();
+		auto isAbsorbed = [this](Body* body) {
+			return std::find(m_Absorbed.begin(), m_Absorbed.end(), body) != m_Absorbed.end();
+		};
+
+		for (const CollisionDetector::Contact& contact : m_Contacts) {
+			Body* survivor = m_BodyList[contact.a];
+			Body* victim = m_BodyList[contact.b];
+			if (isAbsorbed(survivor) || isAbsorbed(victim))
+				continue;
+
+			// static bodies stay, otherwise the heavier body survives
+			bool swap = victim->type == Body::Type::STATIC && survivor->type != Body::Type::STATIC;
+			if (survivor->type == victim->type && victim->mass > survivor->mass)
+				swap = true;
+			if (swap)
+				std::swap(survivor, victim);
+
+			float mass = survivor->mass + victim->mass;
+			glm::vec3 vel = (survivor->mass * survivor->vel + victim->mass * victim->vel) / mass;
+
+			if (survivor->type == Body::Type::DYNAMIC) {
+				// merging at the contact point, then moving back so this step's advance lands there again
+				glm::vec3 posA = survivor->pos + survivor->vel * contact.time;
+				glm::vec3 posB = victim->pos + victim->vel * contact.time;
+				glm::vec3 pos = (survivor->mass * posA + victim->mass * posB) / mass;
+				survivor->pos = pos - vel * contact.time;
+			}
+
+			survivor->vel = vel;
+			survivor->mass = mass;
+			survivor->radius = std::cbrt(survivor->radius * survivor->radius * survivor->radius
+				+ victim->radius * victim->radius * victim->radius);
+
+			m_Absorbed.push_back(victim);
+			m_Merges.push_back({ survivor, victim });
+		}
+
+		for (Body* body : m_Absorbed) {
+			m_Bodies.erase(body);
+
+			if (m_EventDetector)
+				m_EventDetector->forget(body);
+		}
+
+		predCalculated = false;
+		m_HasInitialInvariants = false;
+		// a cache recorded before the merge no longer matches the bodies
+		m_Ephemeris = nullptr;
+
+		if (onMerge) {
+			for (const auto& merge : m_Merges) {
+				onMerge(merge.first, merge.second);
+			}
+		}
+	}
+
 	void Engine::calcFuturePos(uint16_t steps, float timeOffset) {
 		if (steps < 1)
 			return;
@@ -109,6 +529,9 @@ namespace physics {
 			i += 1;
 		}
 
+		const size_t count = m_PosPrediction.size();
+		m_Interactions += (uint64_t)(steps - 1) * count * (count - std::min<size_t>(count, 1)) / 2;
+
 		for (uint16_t step = 1; step < steps; ++step) {
 
 			for (size_t iter1 = 0; iter1 < m_PosPrediction.size(); ++iter1) {
@@ -130,4 +553,31 @@ namespace physics {
 		}
 	}
 
+	void Engine::evalEphemeris(double time) {
+		size_t i = 0;
+		for (auto iter = m_Bodies.begin(); iter != m_Bodies.end(); ++iter, ++i) {
+			(*iter)->pos = m_Ephemeris->getPos(m_EphemerisBodies[i], time);
+			(*iter)->vel = m_Ephemeris->getVel(m_EphemerisBodies[i], time);
+		}
+	}
+
+	void Engine::evalFuturePos(uint16_t steps, float timeOffset) {
+		if (steps < 1)
+			return;
+
+		m_PosPrediction.resize(m_Bodies.size());
+
+		size_t i = 0;
+		for (auto iter = m_Bodies.begin(); iter != m_Bodies.end(); ++iter, ++i) {
+			m_PosPrediction[i].assign(steps, **iter);
+
+			for (uint16_t step = 1; step < steps; ++step) {
+				double time = std::min(m_SimTime + (double)step * timeOffset, m_Ephemeris->getEndTime());
+				m_PosPrediction[i][step].pos = m_Ephemeris->getPos(m_EphemerisBodies[i], time);
+			}
+		}
+
+		predCalculated = true;
+	}
+
 }
\ No newline at end of file
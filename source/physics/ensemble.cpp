@@ -0,0 +1,333 @@
+#include "StarSystemSim/physics/ensemble.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENSEMBLE_SSE 1
+#else
+#define ENSEMBLE_SSE 0
+#endif
+
+namespace physics {
+
+	Ensemble::Ensemble()
+		: m_MemberCount(0), m_BodyCount(0), m_BlockCount(0), m_Time(0.0)
+	{}
+
+	void Ensemble::init(const std::vector<Body>& base, size_t memberCount, const Perturbation& perturb) {
+		m_MemberCount = memberCount;
+		m_BodyCount = base.size();
+		m_BlockCount = (memberCount + ENSEMBLE_LANES - 1) / ENSEMBLE_LANES;
+		m_Time = 0.0;
+
+		m_Data.assign(m_BlockCount * COLUMN_COUNT * m_BodyCount * ENSEMBLE_LANES, 0.0f);
+
+		std::vector<Body> bodies;
+		for (size_t member = 0; member < m_BlockCount * ENSEMBLE_LANES; ++member) {
+			// padding lanes repeat the last member and are never reported
+			if (member < memberCount) {
+				bodies = base;
+				if (perturb)
+					perturb(member, bodies);
+			}
+			setMember(member, bodies);
+		}
+
+		for (Statistic& statistic : m_Statistics)
+			statistic.memberValues.assign(m_MemberCount, 0.0f);
+	}
+
+	void Ensemble::clear() {
+		m_MemberCount = m_BodyCount = m_BlockCount = 0;
+		m_Time = 0.0;
+		m_Data.clear();
+		m_Statistics.clear();
+	}
+
+	void Ensemble::setMember(size_t member, const std::vector<Body>& bodies) {
+		if (bodies.size() != m_BodyCount || member >= m_BlockCount * ENSEMBLE_LANES) {
+			utils::printError("Ensemble member %zu does not exist or has the wrong number of bodies", member);
+			return;
+		}
+
+		const size_t block = member / ENSEMBLE_LANES, lane = member % ENSEMBLE_LANES;
+		for (size_t i = 0; i < m_BodyCount; ++i) {
+			const Body& body = bodies[i];
+			const size_t index = i * ENSEMBLE_LANES + lane;
+
+			getColumn(block, POS_X)[index] = body.pos.x;
+			getColumn(block, POS_Y)[index] = body.pos.y;
+			getColumn(block, POS_Z)[index] = body.pos.z;
+			getColumn(block, VEL_X)[index] = body.vel.x;
+			getColumn(block, VEL_Y)[index] = body.vel.y;
+			getColumn(block, VEL_Z)[index] = body.vel.z;
+			getColumn(block, MASS)[index] = body.mass;
+			getColumn(block, DYNAMIC)[index] = body.type == Body::Type::DYNAMIC ? 1.0f : 0.0f;
+		}
+	}
+
+	void Ensemble::getMember(size_t member, std::vector<Body>& bodies) const {
+		bodies.resize(m_BodyCount);
+		if (member >= m_MemberCount)
+			return;
+
+		const size_t block = member / ENSEMBLE_LANES, lane = member % ENSEMBLE_LANES;
+		for (size_t i = 0; i < m_BodyCount; ++i) {
+			Body& body = bodies[i];
+			const size_t index = i * ENSEMBLE_LANES + lane;
+
+			body.pos = { getColumn(block, POS_X)[index], getColumn(block, POS_Y)[index], getColumn(block, POS_Z)[index] };
+			body.vel = { getColumn(block, VEL_X)[index], getColumn(block, VEL_Y)[index], getColumn(block, VEL_Z)[index] };
+			body.mass = getColumn(block, MASS)[index];
+			body.type = getColumn(block, DYNAMIC)[index] != 0.0f ? Body::Type::DYNAMIC : Body::Type::STATIC;
+		}
+	}
+
+	size_t Ensemble::addStatistic(Quantity quantity, Reduction reduction, size_t body, size_t reference,
+		float histogramMin, float histogramMax, uint32_t bins)
+	{
+		if (body >= m_BodyCount || reference >= m_BodyCount) {
+			utils::printError("Ensemble statistic refers to a body that does not exist");
+			return m_Statistics.size();
+		}
+
+		Statistic statistic;
+		statistic.quantity = quantity;
+		statistic.reduction = reduction;
+		statistic.body = body;
+		statistic.reference = reference;
+		statistic.histogramMin = histogramMin;
+		statistic.histogramMax = histogramMax;
+		statistic.histogram.assign(std::max(bins, 1u), 0);
+		statistic.min = statistic.max = statistic.mean = 0.0f;
+		statistic.memberValues.assign(m_MemberCount, 0.0f);
+
+		m_Statistics.push_back(std::move(statistic));
+		return m_Statistics.size() - 1;
+	}
+
+	void Ensemble::advance(double duration, float maxStep, utils::ThreadPool& pool, uint32_t sampleEvery) {
+		if (duration <= 0.0 || maxStep <= 0.0f || m_MemberCount == 0)
+			return;
+
+		uint64_t steps = (uint64_t)std::ceil(duration / maxStep);
+		float deltaTime = (float)(duration / (double)steps);
+		sampleEvery = std::max(sampleEvery, 1u);
+
+		pool.parallelFor(0, m_BlockCount, [&](size_t begin, size_t end) {
+			for (size_t block = begin; block < end; ++block)
+				advanceBlock(block, steps, deltaTime, sampleEvery);
+		});
+
+		m_Time += duration;
+		summarize();
+	}
+
+	void Ensemble::advanceBlock(size_t block, uint64_t steps, float deltaTime, uint32_t sampleEvery) {
+		const size_t L = ENSEMBLE_LANES;
+		const size_t n = m_BodyCount;
+
+		float* posX = getColumn(block, POS_X);
+		float* posY = getColumn(block, POS_Y);
+		float* posZ = getColumn(block, POS_Z);
+		float* velX = getColumn(block, VEL_X);
+		float* velY = getColumn(block, VEL_Y);
+		float* velZ = getColumn(block, VEL_Z);
+		const float* mass = getColumn(block, MASS);
+		const float* dynamic = getColumn(block, DYNAMIC);
+
+		static thread_local std::vector<float> acc;
+		acc.resize(3 * n * L);
+		float* accX = acc.data();
+		float* accY = accX + n * L;
+		float* accZ = accY + n * L;
+
+		// same law as Engine, four lanes of a block at a time
+#if ENSEMBLE_SSE
+		static_assert(ENSEMBLE_LANES % 4 == 0, "blocks are handled in SSE registers");
+
+		auto calcAccelerations = [&]() {
+			std::fill(acc.begin(), acc.end(), 0.0f);
+
+			const __m128 g = _mm_set1_ps(GRAVITATIONAL_CONSTANT);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+
+			for (size_t a = 0; a < n; ++a) {
+				for (size_t l = 0; l < L; l += 4) {
+					const size_t ia = a * L + l;
+					const __m128 ax = _mm_loadu_ps(posX + ia), ay = _mm_loadu_ps(posY + ia), az = _mm_loadu_ps(posZ + ia);
+					const __m128 massA = _mm_loadu_ps(mass + ia);
+					__m128 sumX = zero, sumY = zero, sumZ = zero;
+
+					for (size_t b = a + 1; b < n; ++b) {
+						const size_t ib = b * L + l;
+						__m128 dx = _mm_sub_ps(_mm_loadu_ps(posX + ib), ax);
+						__m128 dy = _mm_sub_ps(_mm_loadu_ps(posY + ib), ay);
+						__m128 dz = _mm_sub_ps(_mm_loadu_ps(posZ + ib), az);
+
+						__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+						__m128 valid = _mm_cmpgt_ps(distSq, zero);
+						__m128 invDist = _mm_div_ps(one, _mm_sqrt_ps(distSq));
+						__m128 scale = _mm_and_ps(valid, _mm_mul_ps(g, _mm_mul_ps(invDist, _mm_mul_ps(invDist, invDist))));
+
+						__m128 scaleA = _mm_mul_ps(scale, _mm_loadu_ps(mass + ib));
+						sumX = _mm_add_ps(sumX, _mm_mul_ps(dx, scaleA));
+						sumY = _mm_add_ps(sumY, _mm_mul_ps(dy, scaleA));
+						sumZ = _mm_add_ps(sumZ, _mm_mul_ps(dz, scaleA));
+
+						__m128 scaleB = _mm_mul_ps(scale, massA);
+						_mm_storeu_ps(accX + ib, _mm_sub_ps(_mm_loadu_ps(accX + ib), _mm_mul_ps(dx, scaleB)));
+						_mm_storeu_ps(accY + ib, _mm_sub_ps(_mm_loadu_ps(accY + ib), _mm_mul_ps(dy, scaleB)));
+						_mm_storeu_ps(accZ + ib, _mm_sub_ps(_mm_loadu_ps(accZ + ib), _mm_mul_ps(dz, scaleB)));
+					}
+
+					_mm_storeu_ps(accX + ia, _mm_add_ps(_mm_loadu_ps(accX + ia), sumX));
+					_mm_storeu_ps(accY + ia, _mm_add_ps(_mm_loadu_ps(accY + ia), sumY));
+					_mm_storeu_ps(accZ + ia, _mm_add_ps(_mm_loadu_ps(accZ + ia), sumZ));
+				}
+			}
+		};
+#else
+		auto calcAccelerations = [&]() {
+			std::fill(acc.begin(), acc.end(), 0.0f);
+
+			for (size_t a = 0; a < n; ++a) {
+				for (size_t b = a + 1; b < n; ++b) {
+					const size_t ia = a * L, ib = b * L;
+
+					for (size_t l = 0; l < L; ++l) {
+						float dx = posX[ib + l] - posX[ia + l];
+						float dy = posY[ib + l] - posY[ia + l];
+						float dz = posZ[ib + l] - posZ[ia + l];
+						float distSq = dx * dx + dy * dy + dz * dz;
+						if (distSq <= 0.0f)
+							continue;
+
+						float invDist = 1.0f / std::sqrt(distSq);
+						float scale = GRAVITATIONAL_CONSTANT * invDist * invDist * invDist;
+
+						float scaleA = scale * mass[ib + l];
+						float scaleB = scale * mass[ia + l];
+						accX[ia + l] += dx * scaleA;
+						accY[ia + l] += dy * scaleA;
+						accZ[ia + l] += dz * scaleA;
+						accX[ib + l] -= dx * scaleB;
+						accY[ib + l] -= dy * scaleB;
+						accZ[ib + l] -= dz * scaleB;
+					}
+				}
+			}
+		};
+#endif
+
+		auto kick = [&](float deltaTime) {
+#if ENSEMBLE_SSE
+			const __m128 dt = _mm_set1_ps(deltaTime);
+			for (size_t i = 0; i < n * L; i += 4) {
+				_mm_storeu_ps(velX + i, _mm_add_ps(_mm_loadu_ps(velX + i), _mm_mul_ps(_mm_loadu_ps(accX + i), dt)));
+				_mm_storeu_ps(velY + i, _mm_add_ps(_mm_loadu_ps(velY + i), _mm_mul_ps(_mm_loadu_ps(accY + i), dt)));
+				_mm_storeu_ps(velZ + i, _mm_add_ps(_mm_loadu_ps(velZ + i), _mm_mul_ps(_mm_loadu_ps(accZ + i), dt)));
+			}
+#else
+			for (size_t i = 0; i < n * L; ++i) {
+				velX[i] += accX[i] * deltaTime;
+				velY[i] += accY[i] * deltaTime;
+				velZ[i] += accZ[i] * deltaTime;
+			}
+#endif
+		};
+
+		auto drift = [&](float deltaTime) {
+#if ENSEMBLE_SSE
+			const __m128 dt = _mm_set1_ps(deltaTime);
+			for (size_t i = 0; i < n * L; i += 4) {
+				__m128 step = _mm_mul_ps(dt, _mm_loadu_ps(dynamic + i));
+				_mm_storeu_ps(posX + i, _mm_add_ps(_mm_loadu_ps(posX + i), _mm_mul_ps(_mm_loadu_ps(velX + i), step)));
+				_mm_storeu_ps(posY + i, _mm_add_ps(_mm_loadu_ps(posY + i), _mm_mul_ps(_mm_loadu_ps(velY + i), step)));
+				_mm_storeu_ps(posZ + i, _mm_add_ps(_mm_loadu_ps(posZ + i), _mm_mul_ps(_mm_loadu_ps(velZ + i), step)));
+			}
+#else
+			for (size_t i = 0; i < n * L; ++i) {
+				float step = deltaTime * dynamic[i];
+				posX[i] += velX[i] * step;
+				posY[i] += velY[i] * step;
+				posZ[i] += velZ[i] * step;
+			}
+#endif
+		};
+
+		sampleBlock(block, true);
+		calcAccelerations();
+
+		// kick-drift-kick, the closing kick's accelerations open the next step
+		for (uint64_t step = 1; step <= steps; ++step) {
+			kick(0.5f * deltaTime);
+			drift(deltaTime);
+			calcAccelerations();
+			kick(0.5f * deltaTime);
+
+			if (step % sampleEvery == 0 || step == steps)
+				sampleBlock(block, false);
+		}
+	}
+
+	void Ensemble::sampleBlock(size_t block, bool first) {
+		const size_t L = ENSEMBLE_LANES;
+		const size_t lanes = std::min(L, m_MemberCount - block * L);
+
+		for (Statistic& statistic : m_Statistics) {
+			Column x = statistic.quantity == Quantity::DISTANCE ? POS_X : VEL_X;
+			Column y = statistic.quantity == Quantity::DISTANCE ? POS_Y : VEL_Y;
+			Column z = statistic.quantity == Quantity::DISTANCE ? POS_Z : VEL_Z;
+
+			const size_t ib = statistic.body * L, ir = statistic.reference * L;
+			float* values = statistic.memberValues.data() + block * L;
+
+			for (size_t l = 0; l < lanes; ++l) {
+				float dx = getColumn(block, x)[ib + l] - getColumn(block, x)[ir + l];
+				float dy = getColumn(block, y)[ib + l] - getColumn(block, y)[ir + l];
+				float dz = getColumn(block, z)[ib + l] - getColumn(block, z)[ir + l];
+				float value = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+				if (first || statistic.reduction == Reduction::FINAL)
+					values[l] = value;
+				else if (statistic.reduction == Reduction::MIN)
+					values[l] = std::min(values[l], value);
+				else
+					values[l] = std::max(values[l], value);
+			}
+		}
+	}
+
+	void Ensemble::summarize() {
+		for (Statistic& statistic : m_Statistics) {
+			std::fill(statistic.histogram.begin(), statistic.histogram.end(), 0);
+			statistic.min = statistic.max = statistic.mean = 0.0f;
+			if (statistic.memberValues.empty())
+				continue;
+
+			const uint32_t bins = (uint32_t)statistic.histogram.size();
+			const float range = statistic.histogramMax - statistic.histogramMin;
+
+			double sum = 0.0;
+			statistic.min = statistic.max = statistic.memberValues[0];
+			for (float value : statistic.memberValues) {
+				statistic.min = std::min(statistic.min, value);
+				statistic.max = std::max(statistic.max, value);
+				sum += value;
+
+				float t = range > 0.0f ? (value - statistic.histogramMin) / range : 0.0f;
+				int bin = (int)std::floor(t * bins);
+				statistic.histogram[std::clamp(bin, 0, (int)bins - 1)] += 1;
+			}
+			statistic.mean = (float)(sum / statistic.memberValues.size());
+		}
+	}
+
+}
\ No newline at end of file
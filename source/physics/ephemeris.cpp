@@ -0,0 +1,323 @@
+#include "StarSystemSim/physics/ephemeris.h"
+
+#include "StarSystemSim/physics/integrator.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define EPHEMERIS_MMAP 1
+#else
+#define EPHEMERIS_MMAP 0
+#endif
+
+namespace physics {
+
+	static const char EPHEMERIS_MAGIC[8] = { 'S', 'S', 'S', 'E', 'P', 'H', 'M', '\0' };
+	static const uint32_t EPHEMERIS_VERSION = 2;
+
+	static size_t alignTo64(size_t size) {
+		return (size + 63) & ~(size_t)63;
+	}
+
+	Ephemeris::Ephemeris()
+		: m_Coeffs(nullptr), m_Mapping(nullptr), m_MappingSize(0)
+	{
+		std::memset(&m_Header, 0, sizeof(Header));
+	}
+
+	Ephemeris::~Ephemeris() {
+		clear();
+	}
+
+	void Ephemeris::clear() {
+#if EPHEMERIS_MMAP
+		if (m_Mapping)
+			munmap(m_Mapping, m_MappingSize);
+#endif
+		m_Mapping = nullptr;
+		m_MappingSize = 0;
+
+		m_Coeffs = nullptr;
+		m_OwnedCoeffs.clear();
+		m_Types.clear();
+		m_Masses.clear();
+		m_Radii.clear();
+		std::memset(&m_Header, 0, sizeof(Header));
+	}
+
+	void Ephemeris::build(const std::vector<Body>& bodies, double startTime, double duration,
+		float segmentLength, uint16_t degree, float maxStep)
+	{
+		clear();
+
+		if (bodies.empty() || duration <= 0.0 || segmentLength <= 0.0f)
+			return;
+
+		const uint32_t nodes = degree + 1;
+		const uint32_t segments = (uint32_t)std::ceil(duration / segmentLength);
+
+		std::memcpy(m_Header.magic, EPHEMERIS_MAGIC, sizeof(EPHEMERIS_MAGIC));
+		m_Header.version = EPHEMERIS_VERSION;
+		m_Header.bodyCount = (uint32_t)bodies.size();
+		m_Header.segmentCount = segments;
+		m_Header.degree = degree;
+		m_Header.startTime = startTime;
+		m_Header.segmentLength = segmentLength;
+
+		m_Types.resize(bodies.size());
+		m_Masses.resize(bodies.size());
+		m_Radii.resize(bodies.size());
+		for (size_t i = 0; i < bodies.size(); ++i) {
+			m_Types[i] = (uint8_t)bodies[i].type;
+			m_Masses[i] = bodies[i].mass;
+			m_Radii[i] = bodies[i].radius;
+		}
+
+		m_OwnedCoeffs.assign((size_t)segments * bodies.size() * 3 * nodes, 0.0);
+
+		std::vector<Body> state = bodies;
+		std::vector<std::vector<glm::vec3>> samples(nodes, std::vector<glm::vec3>(bodies.size()));
+		double time = 0.0;
+
+		for (uint32_t segment = 0; segment < segments; ++segment) {
+			double segStart = (double)segment * segmentLength;
+
+			// Chebyshev nodes x_k = cos(pi * (k + 0.5) / n) are descending in k,
+			// so the integration walks them from the last one to the first
+			for (int32_t k = nodes - 1; k >= 0; --k) {
+				double x = std::cos(glm::pi<double>() * (k + 0.5) / nodes);
+				double nodeTime = segStart + 0.5 * (x + 1.0) * segmentLength;
+
+				integrateFor(state, nodeTime - time, maxStep);
+				time = nodeTime;
+
+				for (size_t i = 0; i < state.size(); ++i) {
+					samples[k][i] = state[i].pos;
+				}
+			}
+
+			for (size_t i = 0; i < bodies.size(); ++i) {
+				double* coeffs = &m_OwnedCoeffs[(((size_t)segment * bodies.size()) + i) * 3 * nodes];
+
+				for (uint32_t axis = 0; axis < 3; ++axis) {
+					for (uint32_t j = 0; j < nodes; ++j) {
+						double sum = 0.0;
+						for (uint32_t k = 0; k < nodes; ++k) {
+							sum += samples[k][i][axis] * std::cos(glm::pi<double>() * j * (k + 0.5) / nodes);
+						}
+						coeffs[axis * nodes + j] = (j == 0 ? 1.0 : 2.0) * sum / nodes;
+					}
+				}
+			}
+		}
+
+		m_Coeffs = m_OwnedCoeffs.data();
+	}
+
+	bool Ephemeris::save(const char* path) const {
+		if (isEmpty()) {
+			utils::printError("Ephemeris is empty, nothing to save to \"%s\"", path);
+			return false;
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (file.fail()) {
+			utils::printError("Failed to open ephemeris file (\"%s\") for writing", path);
+			return false;
+		}
+
+		const char zeros[64] = {};
+		size_t typesSize = alignTo64(m_Types.size());
+		size_t columnSize = alignTo64(m_Masses.size() * sizeof(float));
+
+		file.write((const char*)&m_Header, sizeof(Header));
+		file.write((const char*)m_Types.data(), m_Types.size());
+		file.write(zeros, typesSize - m_Types.size());
+		file.write((const char*)m_Masses.data(), m_Masses.size() * sizeof(float));
+		file.write(zeros, columnSize - m_Masses.size() * sizeof(float));
+		file.write((const char*)m_Radii.data(), m_Radii.size() * sizeof(float));
+		file.write(zeros, columnSize - m_Radii.size() * sizeof(float));
+
+		size_t coeffCount = (size_t)m_Header.segmentCount * m_Header.bodyCount * 3 * (m_Header.degree + 1);
+		file.write((const char*)m_Coeffs, coeffCount * sizeof(double));
+
+		return !file.fail();
+	}
+
+	bool Ephemeris::load(const char* path) {
+		clear();
+
+		Header header;
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (file.fail() || !file.read((char*)&header, sizeof(Header))) {
+				utils::printError("Failed to read ephemeris file (\"%s\")", path);
+				return false;
+			}
+		}
+
+		if (std::memcmp(header.magic, EPHEMERIS_MAGIC, sizeof(EPHEMERIS_MAGIC)) != 0 || header.version != EPHEMERIS_VERSION) {
+			utils::printError("\"%s\" is not a supported ephemeris file", path);
+			return false;
+		}
+
+		size_t typesOffset = sizeof(Header);
+		size_t massesOffset = typesOffset + alignTo64(header.bodyCount);
+		size_t radiiOffset = massesOffset + alignTo64(header.bodyCount * sizeof(float));
+		size_t coeffsOffset = radiiOffset + alignTo64(header.bodyCount * sizeof(float));
+		size_t coeffCount = (size_t)header.segmentCount * header.bodyCount * 3 * (header.degree + 1);
+		size_t fileSize = coeffsOffset + coeffCount * sizeof(double);
+
+#if EPHEMERIS_MMAP
+		int fd = open(path, O_RDONLY);
+		struct stat fileStat;
+		if (fd < 0 || fstat(fd, &fileStat) != 0 || (size_t)fileStat.st_size < fileSize) {
+			if (fd >= 0)
+				close(fd);
+			utils::printError("Ephemeris file (\"%s\") is truncated", path);
+			return false;
+		}
+
+		void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapping == MAP_FAILED) {
+			utils::printError("Failed to map ephemeris file (\"%s\")", path);
+			return false;
+		}
+
+		m_Mapping = mapping;
+		m_MappingSize = fileSize;
+
+		const uint8_t* bytes = (const uint8_t*)mapping;
+		m_Types.assign(bytes + typesOffset, bytes + typesOffset + header.bodyCount);
+		m_Masses.resize(header.bodyCount);
+		std::memcpy(m_Masses.data(), bytes + massesOffset, header.bodyCount * sizeof(float));
+		m_Radii.resize(header.bodyCount);
+		std::memcpy(m_Radii.data(), bytes + radiiOffset, header.bodyCount * sizeof(float));
+		m_Coeffs = (const double*)(bytes + coeffsOffset);
+#else
+		std::ifstream file(path, std::ios::binary);
+		m_Types.resize(header.bodyCount);
+		m_Masses.resize(header.bodyCount);
+		m_Radii.resize(header.bodyCount);
+		m_OwnedCoeffs.resize(coeffCount);
+
+		file.seekg(typesOffset);
+		file.read((char*)m_Types.data(), header.bodyCount);
+		file.seekg(massesOffset);
+		file.read((char*)m_Masses.data(), header.bodyCount * sizeof(float));
+		file.seekg(radiiOffset);
+		file.read((char*)m_Radii.data(), header.bodyCount * sizeof(float));
+		file.seekg(coeffsOffset);
+		file.read((char*)m_OwnedCoeffs.data(), coeffCount * sizeof(double));
+		if (file.fail()) {
+			utils::printError("Ephemeris file (\"%s\") is truncated", path);
+			m_Types.clear();
+			m_Masses.clear();
+			m_Radii.clear();
+			m_OwnedCoeffs.clear();
+			return false;
+		}
+
+		m_Coeffs = m_OwnedCoeffs.data();
+#endif
+
+		m_Header = header;
+		return true;
+	}
+
+	bool Ephemeris::covers(double time) const {
+		return !isEmpty() && time >= getStartTime() && time <= getEndTime();
+	}
+
+	const double* Ephemeris::locate(size_t body, double time, double& x) const {
+		double local = (time - m_Header.startTime) / m_Header.segmentLength;
+		int64_t segment = (int64_t)std::floor(local);
+		if (segment < 0)
+			segment = 0;
+		if (segment >= (int64_t)m_Header.segmentCount)
+			segment = m_Header.segmentCount - 1;
+
+		x = 2.0 * (local - (double)segment) - 1.0;
+		x = std::fmax(-1.0, std::fmin(1.0, x));
+
+		return m_Coeffs + (((size_t)segment * m_Header.bodyCount) + body) * 3 * (m_Header.degree + 1);
+	}
+
+	glm::vec3 Ephemeris::getPos(size_t body, double time) const {
+		if (isEmpty() || body >= m_Header.bodyCount)
+			return glm::vec3(0.0f);
+
+		double x;
+		const double* coeffs = locate(body, time, x);
+		const uint32_t nodes = m_Header.degree + 1;
+
+		glm::vec3 pos;
+		for (uint32_t axis = 0; axis < 3; ++axis) {
+			// Clenshaw recurrence
+			const double* c = coeffs + axis * nodes;
+			double b1 = 0.0, b2 = 0.0;
+			for (int32_t j = nodes - 1; j >= 1; --j) {
+				double b0 = 2.0 * x * b1 - b2 + c[j];
+				b2 = b1;
+				b1 = b0;
+			}
+			pos[axis] = (float)(x * b1 - b2 + c[0]);
+		}
+
+		return pos;
+	}
+
+	glm::vec3 Ephemeris::getVel(size_t body, double time) const {
+		if (isEmpty() || body >= m_Header.bodyCount)
+			return glm::vec3(0.0f);
+
+		double x;
+		const double* coeffs = locate(body, time, x);
+		const uint32_t nodes = m_Header.degree + 1;
+		const double scale = 2.0 / m_Header.segmentLength;
+
+		glm::vec3 vel;
+		for (uint32_t axis = 0; axis < 3; ++axis) {
+			const double* c = coeffs + axis * nodes;
+
+			// T'_(j+1) = 2 T_j + 2x T'_j - T'_(j-1)
+			double tPrev = 1.0, tCurr = x;
+			double dPrev = 0.0, dCurr = 1.0;
+			double sum = nodes > 1 ? c[1] : 0.0;
+			for (uint32_t j = 2; j < nodes; ++j) {
+				double tNext = 2.0 * x * tCurr - tPrev;
+				double dNext = 2.0 * tCurr + 2.0 * x * dCurr - dPrev;
+				sum += c[j] * dNext;
+
+				tPrev = tCurr; tCurr = tNext;
+				dPrev = dCurr; dCurr = dNext;
+			}
+			vel[axis] = (float)(sum * scale);
+		}
+
+		return vel;
+	}
+
+	void Ephemeris::getState(double time, std::vector<Body>& bodies) const {
+		bodies.resize(m_Header.bodyCount);
+
+		for (size_t i = 0; i < m_Header.bodyCount; ++i) {
+			bodies[i].pos = getPos(i, time);
+			bodies[i].vel = getVel(i, time);
+			bodies[i].mass = m_Masses[i];
+			bodies[i].radius = m_Radii[i];
+			bodies[i].type = (Body::Type)m_Types[i];
+		}
+	}
+
+}
\ No newline at end of file
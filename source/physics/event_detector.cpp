@@ -0,0 +1,331 @@
+#include "StarSystemSim/physics/event_detector.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace physics {
+
+	static const int ROOT_ITERATIONS = 40;
+	static const size_t WATCH_BLOCK = 64;
+
+	EventDetector::EventDetector() {
+	}
+
+	EventDetector::~EventDetector() {
+	}
+
+	uint32_t EventDetector::track(Body* body) {
+		auto iter = std::find(m_Tracked.begin(), m_Tracked.end(), body);
+		if (iter != m_Tracked.end())
+			return (uint32_t)(iter - m_Tracked.begin());
+
+		m_Tracked.push_back(body);
+		return (uint32_t)(m_Tracked.size() - 1);
+	}
+
+	void EventDetector::addWatch(WatchType type, uint32_t a, uint32_t b, uint32_t c, float param) {
+		m_WatchTypes.push_back(type);
+		m_WatchA.push_back(a);
+		m_WatchB.push_back(b);
+		m_WatchC.push_back(c);
+		m_WatchParam.push_back(param);
+		m_PrevValue.push_back(0.0f);
+		m_CurrValue.push_back(0.0f);
+		m_PrevValid.push_back(0);
+	}
+
+	void EventDetector::watchApsides(Body* body, Body* primary) {
+		uint32_t a = track(primary), b = track(body);
+		addWatch(WatchType::APSIS, a, b, b, 0.0f);
+	}
+
+	void EventDetector::watchProximity(Body* a, Body* b, float distance) {
+		uint32_t ia = track(a), ib = track(b);
+		addWatch(WatchType::PROXIMITY, ia, ib, ib, distance);
+	}
+
+	void EventDetector::watchOcclusion(Body* observer, Body* target, Body* occluder) {
+		uint32_t a = track(observer), b = track(target), c = track(occluder);
+		addWatch(WatchType::OCCLUSION, a, b, c, 0.0f);
+	}
+
+	void EventDetector::forget(Body* body) {
+		auto iter = std::find(m_Tracked.begin(), m_Tracked.end(), body);
+		if (iter == m_Tracked.end())
+			return;
+
+		uint32_t index = (uint32_t)(iter - m_Tracked.begin());
+
+		size_t write = 0;
+		for (size_t read = 0; read < m_WatchTypes.size(); ++read) {
+			if (m_WatchA[read] == index || m_WatchB[read] == index || m_WatchC[read] == index)
+				continue;
+
+			m_WatchTypes[write] = m_WatchTypes[read];
+			m_WatchA[write] = m_WatchA[read];
+			m_WatchB[write] = m_WatchB[read];
+			m_WatchC[write] = m_WatchC[read];
+			m_WatchParam[write] = m_WatchParam[read];
+			m_PrevValue[write] = m_PrevValue[read];
+			m_CurrValue[write] = m_CurrValue[read];
+			m_PrevValid[write] = m_PrevValid[read];
+			++write;
+		}
+
+		m_WatchTypes.resize(write);
+		m_WatchA.resize(write);
+		m_WatchB.resize(write);
+		m_WatchC.resize(write);
+		m_WatchParam.resize(write);
+		m_PrevValue.resize(write);
+		m_CurrValue.resize(write);
+		m_PrevValid.resize(write);
+
+		// the slot is left in place so the remaining indices stay valid
+		*iter = nullptr;
+	}
+
+	void EventDetector::invalidate() {
+		std::fill(m_PrevValue.begin(), m_PrevValue.end(), 0.0f);
+		std::fill(m_PrevValid.begin(), m_PrevValid.end(), (uint8_t)0);
+	}
+
+	void EventDetector::clear() {
+		m_WatchTypes.clear();
+		m_WatchA.clear();
+		m_WatchB.clear();
+		m_WatchC.clear();
+		m_WatchParam.clear();
+		m_PrevValue.clear();
+		m_CurrValue.clear();
+		m_PrevValid.clear();
+		m_Tracked.clear();
+		m_Queue.clear();
+	}
+
+	bool EventDetector::pollEvent(Event& event) {
+		if (m_Queue.empty())
+			return false;
+
+		event = m_Queue.front();
+		m_Queue.pop_front();
+		return true;
+	}
+
+	const char* EventDetector::getEventName(EventType type) {
+		switch (type) {
+			case EventType::PERIAPSIS: return "periapsis";
+			case EventType::APOAPSIS: return "apoapsis";
+			case EventType::APPROACH_BEGIN: return "approach begin";
+			case EventType::APPROACH_END: return "approach end";
+			case EventType::OCCLUSION_BEGIN: return "occlusion begin";
+			case EventType::OCCLUSION_END: return "occlusion end";
+		}
+		return "unknown";
+	}
+
+	void EventDetector::beginStep() {
+		m_StartPos.resize(m_Tracked.size());
+		m_StartVel.resize(m_Tracked.size());
+
+		for (size_t i = 0; i < m_Tracked.size(); ++i) {
+			Body* body = m_Tracked[i];
+			if (!body)
+				continue;
+
+			m_StartPos[i] = body->pos;
+			m_StartVel[i] = body->type == Body::Type::DYNAMIC ? body->vel : glm::vec3(0.0f);
+		}
+	}
+
+	void EventDetector::evalWatches() {
+		const size_t bodyCount = m_Tracked.size();
+		m_PosX.resize(bodyCount); m_PosY.resize(bodyCount); m_PosZ.resize(bodyCount);
+		m_VelX.resize(bodyCount); m_VelY.resize(bodyCount); m_VelZ.resize(bodyCount);
+		m_Radius.resize(bodyCount);
+
+		for (size_t i = 0; i < bodyCount; ++i) {
+			Body* body = m_Tracked[i];
+			if (!body)
+				continue;
+
+			glm::vec3 vel = body->type == Body::Type::DYNAMIC ? body->vel : glm::vec3(0.0f);
+			m_PosX[i] = body->pos.x; m_PosY[i] = body->pos.y; m_PosZ[i] = body->pos.z;
+			m_VelX[i] = vel.x; m_VelY[i] = vel.y; m_VelZ[i] = vel.z;
+			m_Radius[i] = body->radius;
+		}
+
+		// watches are evaluated in blocks: a scalar pass gathers their bodies into
+		// local arrays, then every event function is computed for every watch and the
+		// right one is picked by weight, keeping the second loop free of branches and
+		// aliasing so the compiler vectorizes it
+		const size_t count = m_WatchTypes.size();
+		for (size_t first = 0; first < count; first += WATCH_BLOCK) {
+			const size_t n = std::min(count - first, (size_t)WATCH_BLOCK);
+
+			float dx[WATCH_BLOCK], dy[WATCH_BLOCK], dz[WATCH_BLOCK];
+			float dvx[WATCH_BLOCK], dvy[WATCH_BLOCK], dvz[WATCH_BLOCK];
+			float cx[WATCH_BLOCK], cy[WATCH_BLOCK], cz[WATCH_BLOCK];
+			float radiusSq[WATCH_BLOCK], paramSq[WATCH_BLOCK];
+			float isApsis[WATCH_BLOCK], isProximity[WATCH_BLOCK], isOcclusion[WATCH_BLOCK];
+			float values[WATCH_BLOCK];
+
+			for (size_t i = 0; i < n; ++i) {
+				const size_t w = first + i;
+				const uint32_t a = m_WatchA[w], b = m_WatchB[w], c = m_WatchC[w];
+
+				dx[i] = m_PosX[b] - m_PosX[a]; dy[i] = m_PosY[b] - m_PosY[a]; dz[i] = m_PosZ[b] - m_PosZ[a];
+				dvx[i] = m_VelX[b] - m_VelX[a]; dvy[i] = m_VelY[b] - m_VelY[a]; dvz[i] = m_VelZ[b] - m_VelZ[a];
+				cx[i] = m_PosX[c] - m_PosX[a]; cy[i] = m_PosY[c] - m_PosY[a]; cz[i] = m_PosZ[c] - m_PosZ[a];
+				radiusSq[i] = m_Radius[c] * m_Radius[c];
+				paramSq[i] = m_WatchParam[w] * m_WatchParam[w];
+
+				const WatchType type = m_WatchTypes[w];
+				isApsis[i] = type == WatchType::APSIS ? 1.0f : 0.0f;
+				isProximity[i] = type == WatchType::PROXIMITY ? 1.0f : 0.0f;
+				isOcclusion[i] = type == WatchType::OCCLUSION ? 1.0f : 0.0f;
+			}
+
+			for (size_t i = 0; i < n; ++i) {
+				float distSq = dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i];
+
+				float radial = dx[i] * dvx[i] + dy[i] * dvy[i] + dz[i] * dvz[i];
+				float proximity = distSq - paramSq[i];
+
+				// clamped to [0, 1] without comparisons, which the compiler would turn into branches
+				float s = (cx[i] * dx[i] + cy[i] * dy[i] + cz[i] * dz[i]) / (distSq + 1e-12f);
+				s = 0.5f * (std::abs(s) - std::abs(s - 1.0f) + 1.0f);
+				float ox = cx[i] - s * dx[i], oy = cy[i] - s * dy[i], oz = cz[i] - s * dz[i];
+				float occlusion = ox * ox + oy * oy + oz * oz - radiusSq[i];
+
+				values[i] = isApsis[i] * radial + isProximity[i] * proximity + isOcclusion[i] * occlusion;
+			}
+
+			std::copy(values, values + n, m_CurrValue.begin() + first);
+		}
+	}
+
+	glm::vec3 EventDetector::interpolatePos(uint32_t body, float tau, float deltaTime) const {
+		// cubic Hermite between the step's start and end states
+		float t2 = tau * tau, t3 = t2 * tau;
+		float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+		float h10 = t3 - 2.0f * t2 + tau;
+		float h01 = -2.0f * t3 + 3.0f * t2;
+		float h11 = t3 - t2;
+
+		glm::vec3 endPos(m_PosX[body], m_PosY[body], m_PosZ[body]);
+		glm::vec3 endVel(m_VelX[body], m_VelY[body], m_VelZ[body]);
+
+		return h00 * m_StartPos[body] + (h10 * deltaTime) * m_StartVel[body] + h01 * endPos + (h11 * deltaTime) * endVel;
+	}
+
+	glm::vec3 EventDetector::interpolateVel(uint32_t body, float tau, float deltaTime) const {
+		float t2 = tau * tau;
+		float d00 = 6.0f * t2 - 6.0f * tau;
+		float d10 = 3.0f * t2 - 4.0f * tau + 1.0f;
+		float d01 = -6.0f * t2 + 6.0f * tau;
+		float d11 = 3.0f * t2 - 2.0f * tau;
+
+		glm::vec3 endPos(m_PosX[body], m_PosY[body], m_PosZ[body]);
+		glm::vec3 endVel(m_VelX[body], m_VelY[body], m_VelZ[body]);
+
+		return (d00 * m_StartPos[body] + d01 * endPos) / deltaTime + d10 * m_StartVel[body] + d11 * endVel;
+	}
+
+	float EventDetector::evalAt(size_t watch, float tau, float deltaTime) const {
+		const uint32_t a = m_WatchA[watch], b = m_WatchB[watch], c = m_WatchC[watch];
+
+		glm::vec3 posA = interpolatePos(a, tau, deltaTime);
+		glm::vec3 posB = interpolatePos(b, tau, deltaTime);
+		glm::vec3 d = posB - posA;
+
+		switch (m_WatchTypes[watch]) {
+			case WatchType::APSIS:
+				return glm::dot(d, interpolateVel(b, tau, deltaTime) - interpolateVel(a, tau, deltaTime));
+			case WatchType::PROXIMITY:
+				return glm::dot(d, d) - m_WatchParam[watch] * m_WatchParam[watch];
+			case WatchType::OCCLUSION:
+			{
+				glm::vec3 toC = interpolatePos(c, tau, deltaTime) - posA;
+				float s = glm::dot(toC, d) / std::max(glm::dot(d, d), 1e-12f);
+				s = std::min(std::max(s, 0.0f), 1.0f);
+				glm::vec3 offset = toC - s * d;
+				return glm::dot(offset, offset) - m_Radius[c] * m_Radius[c];
+			}
+		}
+		return 0.0f;
+	}
+
+	void EventDetector::endStep(double startTime, float deltaTime) {
+		if (m_WatchTypes.empty() || deltaTime <= 0.0f)
+			return;
+
+		evalWatches();
+
+		for (size_t w = 0; w < m_WatchTypes.size(); ++w) {
+			float prev = m_PrevValue[w], curr = m_CurrValue[w];
+			bool crossed = m_PrevValid[w] && ((prev < 0.0f && curr >= 0.0f) || (prev >= 0.0f && curr < 0.0f));
+
+			m_PrevValue[w] = curr;
+			m_PrevValid[w] = 1;
+
+			if (!crossed)
+				continue;
+
+			// Illinois variant of regula falsi on the interpolant
+			float lo = 0.0f, hi = 1.0f;
+			float gLo = prev, gHi = curr;
+			int side = 0;
+			for (int iter = 0; iter < ROOT_ITERATIONS && hi - lo > 1e-7f; ++iter) {
+				float tau = (lo * gHi - hi * gLo) / (gHi - gLo);
+				if (!(tau > lo && tau < hi))
+					tau = 0.5f * (lo + hi);
+
+				float g = evalAt(w, tau, deltaTime);
+				if ((g < 0.0f) == (gLo < 0.0f)) {
+					lo = tau; gLo = g;
+					if (side == -1)
+						gHi *= 0.5f;
+					side = -1;
+				}
+				else {
+					hi = tau; gHi = g;
+					if (side == 1)
+						gLo *= 0.5f;
+					side = 1;
+				}
+			}
+
+			Event event;
+			event.a = m_Tracked[m_WatchA[w]];
+			event.b = m_Tracked[m_WatchB[w]];
+			event.c = m_Tracked[m_WatchC[w]];
+			event.time = startTime + (double)(0.5f * (lo + hi)) * deltaTime;
+
+			bool rising = curr >= 0.0f;
+			switch (m_WatchTypes[w]) {
+				case WatchType::APSIS:
+					event.type = rising ? EventType::PERIAPSIS : EventType::APOAPSIS;
+					break;
+				case WatchType::PROXIMITY:
+					event.type = rising ? EventType::APPROACH_END : EventType::APPROACH_BEGIN;
+					break;
+				case WatchType::OCCLUSION:
+					event.type = rising ? EventType::OCCLUSION_END : EventType::OCCLUSION_BEGIN;
+					break;
+			}
+
+			emit(event);
+		}
+	}
+
+	void EventDetector::emit(const Event& event) {
+		if (callback)
+			callback(event);
+		else
+			m_Queue.push_back(event);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "StarSystemSim/physics/integrator.h"
+
+#include "StarSystemSim/physics/engine.h"
+
+#include <cmath>
+
+namespace physics {
+
+	void calcAccelerations(const std::vector<Body>& bodies, std::vector<glm::vec3>& acc) {
+		acc.assign(bodies.size(), glm::vec3(0.0f));
+
+		for (size_t a = 0; a < bodies.size(); ++a) {
+			for (size_t b = a + 1; b < bodies.size(); ++b) {
+				glm::vec3 AtoB = bodies[b].pos - bodies[a].pos;
+				float distSq = AtoB.x * AtoB.x + AtoB.y * AtoB.y + AtoB.z * AtoB.z;
+				if (distSq <= 0.0f)
+					continue;
+
+				float invDist = 1.0f / std::sqrt(distSq);
+				glm::vec3 dir = AtoB * invDist;
+				float accMag = GRAVITATIONAL_CONSTANT / distSq;
+
+				acc[a] += dir * (accMag * bodies[b].mass);
+				acc[b] -= dir * (accMag * bodies[a].mass);
+			}
+		}
+	}
+
+	static void drift(std::vector<Body>& bodies, float deltaTime) {
+		for (Body& body : bodies) {
+			if (body.type == Body::Type::DYNAMIC)
+				body.pos += body.vel * deltaTime;
+		}
+	}
+
+	static void kick(std::vector<Body>& bodies, const std::vector<glm::vec3>& acc, float deltaTime) {
+		for (size_t i = 0; i < bodies.size(); ++i) {
+			bodies[i].vel += acc[i] * deltaTime;
+		}
+	}
+
+	void integrate(std::vector<Body>& bodies, float deltaTime, Integrator method) {
+		static thread_local std::vector<glm::vec3> acc;
+
+		switch (method) {
+			case Integrator::EULER:
+			{
+				calcAccelerations(bodies, acc);
+				kick(bodies, acc, deltaTime);
+				drift(bodies, deltaTime);
+			} break;
+			case Integrator::LEAPFROG:
+			{
+				calcAccelerations(bodies, acc);
+				kick(bodies, acc, 0.5f * deltaTime);
+				drift(bodies, deltaTime);
+				calcAccelerations(bodies, acc);
+				kick(bodies, acc, 0.5f * deltaTime);
+			} break;
+			case Integrator::RK4:
+			{
+				static thread_local std::vector<Body> start, temp;
+				static thread_local std::vector<glm::vec3> dPos, dVel, kVel, kAcc;
+
+				start = bodies;
+				temp = bodies;
+				dPos.assign(bodies.size(), glm::vec3(0.0f));
+				dVel.assign(bodies.size(), glm::vec3(0.0f));
+				kVel.assign(bodies.size(), glm::vec3(0.0f));
+				kAcc.assign(bodies.size(), glm::vec3(0.0f));
+
+				const float weights[4] = { 1.0f, 2.0f, 2.0f, 1.0f };
+				const float offsets[4] = { 0.0f, 0.5f, 0.5f, 1.0f };
+
+				for (int stage = 0; stage < 4; ++stage) {
+					if (stage > 0) {
+						for (size_t i = 0; i < bodies.size(); ++i) {
+							if (start[i].type == Body::Type::DYNAMIC)
+								temp[i].pos = start[i].pos + kVel[i] * (offsets[stage] * deltaTime);
+							temp[i].vel = start[i].vel + kAcc[i] * (offsets[stage] * deltaTime);
+						}
+					}
+
+					calcAccelerations(temp, acc);
+					for (size_t i = 0; i < bodies.size(); ++i) {
+						kVel[i] = temp[i].vel;
+						kAcc[i] = acc[i];
+						dPos[i] += weights[stage] * kVel[i];
+						dVel[i] += weights[stage] * kAcc[i];
+					}
+				}
+
+				for (size_t i = 0; i < bodies.size(); ++i) {
+					if (bodies[i].type == Body::Type::DYNAMIC)
+						bodies[i].pos = start[i].pos + dPos[i] * (deltaTime / 6.0f);
+					bodies[i].vel = start[i].vel + dVel[i] * (deltaTime / 6.0f);
+				}
+			} break;
+		}
+	}
+
+	void integrateFor(std::vector<Body>& bodies, double duration, float maxStep, Integrator method) {
+		if (duration <= 0.0 || maxStep <= 0.0f)
+			return;
+
+		uint64_t steps = (uint64_t)std::ceil(duration / maxStep);
+		float deltaTime = (float)(duration / (double)steps);
+
+		for (uint64_t step = 0; step < steps; ++step) {
+			integrate(bodies, deltaTime, method);
+		}
+	}
+
+	const char* getIntegratorName(Integrator method) {
+		switch (method) {
+			case Integrator::EULER: return "euler";
+			case Integrator::LEAPFROG: return "leapfrog";
+			case Integrator::RK4: return "rk4";
+		}
+		return "unknown";
+	}
+
+}
\ No newline at end of file
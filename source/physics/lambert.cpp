@@ -0,0 +1,103 @@
+#include "StarSystemSim/physics/lambert.h"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace physics {
+
+	static const int LAMBERT_ITERATIONS = 64;
+	static const double LAMBERT_TOLERANCE = 1e-10;
+
+	// Stumpff functions C(z) and S(z), only the branch of z's sign is evaluated
+	static void stumpff(double z, double& C, double& S) {
+		if (std::fabs(z) < 1e-6) {
+			C = 0.5 - z / 24.0;
+			S = 1.0 / 6.0 - z / 120.0;
+		}
+		else if (z > 0.0) {
+			double s = std::sqrt(z);
+			C = (1.0 - std::cos(s)) / z;
+			S = (s - std::sin(s)) / (z * s);
+		}
+		else {
+			double s = std::sqrt(-z);
+			C = (std::cosh(s) - 1.0) / -z;
+			S = (std::sinh(s) - s) / (-z * s);
+		}
+	}
+
+	// universal variable formulation (Bate, Mueller, White); time of flight grows
+	// with z, so Newton steps on z are kept inside a shrinking bracket and fall
+	// back to bisection when they leave it
+	LambertSolution solveLambert(const LambertProblem& problem, double mu, const glm::dvec3& normal) {
+		LambertSolution solution;
+		solution.v1 = solution.v2 = glm::dvec3(0.0);
+		solution.valid = false;
+
+		const double r1n = glm::length(problem.r1);
+		const double r2n = glm::length(problem.r2);
+		const double cosDNu = glm::dot(problem.r1, problem.r2) / (r1n * r2n);
+		const double direction = glm::dot(glm::cross(problem.r1, problem.r2), normal) >= 0.0 ? 1.0 : -1.0;
+
+		const double A = direction * std::sqrt(std::max(0.0, r1n * r2n * (1.0 + cosDNu)));
+		const double target = problem.timeOfFlight * std::sqrt(mu);
+		if (A == 0.0 || !(target > 0.0))
+			return solution;
+
+		double lo = -100.0, hi = 4.0 * glm::pi<double>() * glm::pi<double>();
+		double z = 0.0, y = -1.0, t = 0.0;
+
+		for (int iter = 0; iter < LAMBERT_ITERATIONS; ++iter) {
+			double C, S;
+			stumpff(z, C, S);
+
+			y = r1n + r2n + A * (z * S - 1.0) / std::sqrt(C);
+			if (y <= 0.0) {
+				// only happens for too small z
+				lo = z;
+				z = 0.5 * (lo + hi);
+				continue;
+			}
+
+			double x = std::sqrt(y / C);
+			t = x * x * x * S + A * std::sqrt(y);
+
+			double error = t - target;
+			if (std::fabs(error) <= LAMBERT_TOLERANCE * target)
+				break;
+			if (error < 0.0)
+				lo = z;
+			else
+				hi = z;
+
+			double slope;
+			if (std::fabs(z) < 1e-6) {
+				slope = std::sqrt(2.0) / 40.0 * y * std::sqrt(y)
+					+ A / 8.0 * (std::sqrt(y) + A * std::sqrt(0.5 / y));
+			}
+			else {
+				slope = x * x * x * ((C - 1.5 * S / C) / (2.0 * z) + 0.75 * S * S / C)
+					+ A / 8.0 * (3.0 * S / C * std::sqrt(y) + A * std::sqrt(C / y));
+			}
+
+			double next = z - error / slope;
+			z = next > lo && next < hi ? next : 0.5 * (lo + hi);
+		}
+
+		if (y <= 0.0 || std::fabs(t - target) > 1e-6 * target)
+			return solution;
+
+		double f = 1.0 - y / r1n;
+		double g = A * std::sqrt(y / mu);
+		double gDot = 1.0 - y / r2n;
+
+		solution.v1 = (problem.r2 - f * problem.r1) / g;
+		solution.v2 = (gDot * problem.r2 - problem.r1) / g;
+		solution.valid = true;
+		return solution;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "StarSystemSim/physics/parareal.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+
+namespace physics {
+
+	PararealResult integrateParareal(std::vector<Body>& bodies, const PararealSettings& settings, utils::ThreadPool& pool) {
+		PararealResult result = { 0, 0.0f, false };
+		if (settings.duration <= 0.0 || bodies.empty())
+			return result;
+
+		const uint32_t slices = settings.slices ? settings.slices : 4 * pool.getThreadCount();
+		const double sliceDuration = settings.duration / slices;
+
+		auto coarse = [&](std::vector<Body>& state) {
+			integrateFor(state, sliceDuration, settings.coarseStep, Integrator::LEAPFROG);
+		};
+
+		// boundaries[n] is the state at the start of slice n
+		std::vector<std::vector<Body>> boundaries(slices + 1, bodies);
+		std::vector<std::vector<Body>> coarseEnds(slices), fineEnds(slices);
+
+		for (uint32_t n = 0; n < slices; ++n) {
+			coarseEnds[n] = boundaries[n];
+			coarse(coarseEnds[n]);
+			boundaries[n + 1] = coarseEnds[n];
+		}
+
+		std::vector<Body> predicted;
+		for (uint32_t k = 0; k < std::min(settings.maxIterations, slices); ++k) {
+			// slices before k start from exact boundaries and are already final
+			pool.parallelFor(k, slices, [&](size_t begin, size_t end) {
+				for (size_t n = begin; n < end; ++n) {
+					fineEnds[n] = boundaries[n];
+					integrateFor(fineEnds[n], sliceDuration, settings.fineStep, settings.fineMethod);
+				}
+			});
+
+			// U[n + 1] = G(U[n]) + F(U_old[n]) - G(U_old[n])
+			float correction = 0.0f;
+			boundaries[k + 1] = fineEnds[k];
+			for (uint32_t n = k + 1; n < slices; ++n) {
+				predicted = boundaries[n];
+				coarse(predicted);
+
+				std::vector<Body>& next = boundaries[n + 1];
+				for (size_t i = 0; i < bodies.size(); ++i) {
+					glm::vec3 pos = predicted[i].pos + fineEnds[n][i].pos - coarseEnds[n][i].pos;
+					glm::vec3 vel = predicted[i].vel + fineEnds[n][i].vel - coarseEnds[n][i].vel;
+
+					correction = std::max(correction, glm::length(pos - next[i].pos) + glm::length(vel - next[i].vel));
+					next[i].pos = pos;
+					next[i].vel = vel;
+				}
+
+				coarseEnds[n] = predicted;
+			}
+
+			result.iterations = k + 1;
+			result.correction = correction;
+			if (correction <= settings.tolerance) {
+				result.converged = true;
+				break;
+			}
+		}
+
+		bodies = boundaries[slices];
+		return result;
+	}
+
+}
\ No newline at end of file
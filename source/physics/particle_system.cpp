@@ -0,0 +1,222 @@
+#include "StarSystemSim/physics/particle_system.h"
+
+#include "StarSystemSim/physics/engine.h"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_SSE 1
+#else
+#define PARTICLES_SSE 0
+#endif
+
+namespace physics {
+
+	ParticleSystem::ParticleSystem() {
+	}
+
+	ParticleSystem::~ParticleSystem() {
+	}
+
+	size_t ParticleSystem::addParticle(const glm::vec3& pos, const glm::vec3& vel) {
+		m_PosX.push_back(pos.x);
+		m_PosY.push_back(pos.y);
+		m_PosZ.push_back(pos.z);
+		m_VelX.push_back(vel.x);
+		m_VelY.push_back(vel.y);
+		m_VelZ.push_back(vel.z);
+
+		return m_PosX.size() - 1;
+	}
+
+	void ParticleSystem::addRing(const Body& center, float innerRadius, float outerRadius, size_t count,
+		float thickness, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> angleDist(0.0f, glm::two_pi<float>());
+		std::uniform_real_distribution<float> radiusDist(innerRadius, outerRadius);
+		std::uniform_real_distribution<float> heightDist(-0.5f * thickness, 0.5f * thickness);
+
+		// static bodies keep a velocity but never move
+		glm::vec3 centerVel = center.type == Body::Type::DYNAMIC ? center.vel : glm::vec3(0.0f);
+
+		reserve(getCount() + count);
+
+		for (size_t i = 0; i < count; ++i) {
+			float angle = angleDist(rng);
+			float radius = radiusDist(rng);
+			float speed = std::sqrt(GRAVITATIONAL_CONSTANT * center.mass / radius);
+
+			glm::vec3 offset(radius * std::cos(angle), heightDist(rng), radius * std::sin(angle));
+			glm::vec3 vel(-speed * std::sin(angle), 0.0f, speed * std::cos(angle));
+
+			addParticle(center.pos + offset, centerVel + vel);
+		}
+	}
+
+	void ParticleSystem::reserve(size_t count) {
+		m_PosX.reserve(count);
+		m_PosY.reserve(count);
+		m_PosZ.reserve(count);
+		m_VelX.reserve(count);
+		m_VelY.reserve(count);
+		m_VelZ.reserve(count);
+	}
+
+	void ParticleSystem::clear() {
+		m_PosX.clear();
+		m_PosY.clear();
+		m_PosZ.clear();
+		m_VelX.clear();
+		m_VelY.clear();
+		m_VelZ.clear();
+	}
+
+	void ParticleSystem::assign(const float* const columns[6], size_t count) {
+		m_PosX.assign(columns[0], columns[0] + count);
+		m_PosY.assign(columns[1], columns[1] + count);
+		m_PosZ.assign(columns[2], columns[2] + count);
+		m_VelX.assign(columns[3], columns[3] + count);
+		m_VelY.assign(columns[4], columns[4] + count);
+		m_VelZ.assign(columns[5], columns[5] + count);
+	}
+
+	void ParticleSystem::removeParticles(const std::vector<uint32_t>& indices) {
+		if (indices.empty())
+			return;
+
+		size_t write = indices[0];
+		size_t next = 0;
+		for (size_t read = indices[0]; read < getCount(); ++read) {
+			if (next < indices.size() && indices[next] == read) {
+				++next;
+				continue;
+			}
+
+			m_PosX[write] = m_PosX[read];
+			m_PosY[write] = m_PosY[read];
+			m_PosZ[write] = m_PosZ[read];
+			m_VelX[write] = m_VelX[read];
+			m_VelY[write] = m_VelY[read];
+			m_VelZ[write] = m_VelZ[read];
+			++write;
+		}
+
+		m_PosX.resize(write);
+		m_PosY.resize(write);
+		m_PosZ.resize(write);
+		m_VelX.resize(write);
+		m_VelY.resize(write);
+		m_VelZ.resize(write);
+	}
+
+	glm::vec3 ParticleSystem::getPos(size_t particle) const {
+		return glm::vec3(m_PosX[particle], m_PosY[particle], m_PosZ[particle]);
+	}
+
+	glm::vec3 ParticleSystem::getVel(size_t particle) const {
+		return glm::vec3(m_VelX[particle], m_VelY[particle], m_VelZ[particle]);
+	}
+
+	void ParticleSystem::saveState(std::vector<float>& state) const {
+		const size_t count = getCount();
+		state.resize(6 * count);
+
+		const std::vector<float>* columns[6] = { &m_PosX, &m_PosY, &m_PosZ, &m_VelX, &m_VelY, &m_VelZ };
+		for (size_t column = 0; column < 6; ++column)
+			std::copy(columns[column]->begin(), columns[column]->end(), state.begin() + column * count);
+	}
+
+	void ParticleSystem::loadState(const std::vector<float>& state) {
+		const size_t count = state.size() / 6;
+
+		std::vector<float>* columns[6] = { &m_PosX, &m_PosY, &m_PosZ, &m_VelX, &m_VelY, &m_VelZ };
+		for (size_t column = 0; column < 6; ++column)
+			columns[column]->assign(state.begin() + column * count, state.begin() + (column + 1) * count);
+	}
+
+	void ParticleSystem::getPositions(std::vector<glm::vec3>& positions) const {
+		positions.resize(getCount());
+
+		for (size_t i = 0; i < positions.size(); ++i) {
+			positions[i] = glm::vec3(m_PosX[i], m_PosY[i], m_PosZ[i]);
+		}
+	}
+
+	void ParticleSystem::accelerate(const float* attrX, const float* attrY, const float* attrZ, const float* attrGM,
+		size_t attrCount, float deltaTime)
+	{
+		const size_t count = getCount();
+		float* __restrict px = m_PosX.data();
+		float* __restrict py = m_PosY.data();
+		float* __restrict pz = m_PosZ.data();
+		float* __restrict vx = m_VelX.data();
+		float* __restrict vy = m_VelY.data();
+		float* __restrict vz = m_VelZ.data();
+
+		// attractors in the outer loop keep the particle arrays streaming through the inner one
+		for (size_t a = 0; a < attrCount; ++a) {
+			const float ax = attrX[a], ay = attrY[a], az = attrZ[a];
+			const float gmdt = attrGM[a] * deltaTime;
+
+			size_t i = 0;
+#if PARTICLES_SSE
+			const __m128 vax = _mm_set1_ps(ax), vay = _mm_set1_ps(ay), vaz = _mm_set1_ps(az);
+			const __m128 vgmdt = _mm_set1_ps(gmdt);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+
+			for (; i + 4 <= count; i += 4) {
+				__m128 dx = _mm_sub_ps(vax, _mm_loadu_ps(px + i));
+				__m128 dy = _mm_sub_ps(vay, _mm_loadu_ps(py + i));
+				__m128 dz = _mm_sub_ps(vaz, _mm_loadu_ps(pz + i));
+
+				__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				__m128 valid = _mm_cmpgt_ps(distSq, zero);
+				__m128 invDist = _mm_div_ps(one, _mm_sqrt_ps(distSq));
+				__m128 scale = _mm_and_ps(valid, _mm_mul_ps(vgmdt, _mm_mul_ps(invDist, _mm_mul_ps(invDist, invDist))));
+
+				_mm_storeu_ps(vx + i, _mm_add_ps(_mm_loadu_ps(vx + i), _mm_mul_ps(dx, scale)));
+				_mm_storeu_ps(vy + i, _mm_add_ps(_mm_loadu_ps(vy + i), _mm_mul_ps(dy, scale)));
+				_mm_storeu_ps(vz + i, _mm_add_ps(_mm_loadu_ps(vz + i), _mm_mul_ps(dz, scale)));
+			}
+#endif
+			for (; i < count; ++i) {
+				float dx = ax - px[i], dy = ay - py[i], dz = az - pz[i];
+				float distSq = dx * dx + dy * dy + dz * dz;
+				if (distSq <= 0.0f)
+					continue;
+
+				float invDist = 1.0f / std::sqrt(distSq);
+				float scale = gmdt * invDist * invDist * invDist;
+
+				vx[i] += dx * scale;
+				vy[i] += dy * scale;
+				vz[i] += dz * scale;
+			}
+		}
+	}
+
+	void ParticleSystem::advance(float deltaTime) {
+		const size_t count = getCount();
+		float* __restrict px = m_PosX.data();
+		float* __restrict py = m_PosY.data();
+		float* __restrict pz = m_PosZ.data();
+		const float* __restrict vx = m_VelX.data();
+		const float* __restrict vy = m_VelY.data();
+		const float* __restrict vz = m_VelZ.data();
+
+		for (size_t i = 0; i < count; ++i) {
+			px[i] += vx[i] * deltaTime;
+			py[i] += vy[i] * deltaTime;
+			pz[i] += vz[i] * deltaTime;
+		}
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "StarSystemSim/physics/porkchop.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/physics/lambert.h"
+
+#include <glm/geometric.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace physics {
+
+	Porkchop::Porkchop()
+		: m_BestDeltaV(0.0f), m_BestDeparture(0.0), m_BestArrival(0.0)
+	{
+		m_Settings = Settings{ 0, 0, 0.0, 0.0, 0.0, 0.0, 0, 0 };
+	}
+
+	void Porkchop::compute(const Ephemeris& ephemeris, const Settings& settings, utils::ThreadPool& pool) {
+		m_Settings = settings;
+		const uint32_t width = settings.width, height = settings.height;
+
+		const float nan = std::numeric_limits<float>::quiet_NaN();
+		m_DeltaV.assign((size_t)width * height, nan);
+		m_C3.assign((size_t)width * height, nan);
+		m_BestDeltaV = nan;
+
+		if (width == 0 || height == 0 || ephemeris.isEmpty())
+			return;
+
+		size_t central = 0;
+		for (size_t i = 1; i < ephemeris.getBodyCount(); ++i) {
+			if (ephemeris.getMass(i) > ephemeris.getMass(central))
+				central = i;
+		}
+
+		const double mu = (double)GRAVITATIONAL_CONSTANT * ephemeris.getMass(central);
+
+		auto getDate = [](double start, double end, uint32_t index, uint32_t count) {
+			return count > 1 ? start + (end - start) * index / (count - 1) : start;
+		};
+
+		// states relative to the central body are sampled once per date
+		std::vector<glm::dvec3> depPos(width), depVel(width), arrPos(height), arrVel(height);
+		for (uint32_t i = 0; i < width; ++i) {
+			double time = getDate(settings.departureStart, settings.departureEnd, i, width);
+			depPos[i] = glm::dvec3(ephemeris.getPos(settings.departureBody, time) - ephemeris.getPos(central, time));
+			depVel[i] = glm::dvec3(ephemeris.getVel(settings.departureBody, time) - ephemeris.getVel(central, time));
+		}
+		for (uint32_t j = 0; j < height; ++j) {
+			double time = getDate(settings.arrivalStart, settings.arrivalEnd, j, height);
+			arrPos[j] = glm::dvec3(ephemeris.getPos(settings.arrivalBody, time) - ephemeris.getPos(central, time));
+			arrVel[j] = glm::dvec3(ephemeris.getVel(settings.arrivalBody, time) - ephemeris.getVel(central, time));
+		}
+
+		// transfers go the same way round as the departure body
+		glm::dvec3 normal = glm::cross(depPos[0], depVel[0]);
+		if (glm::length(normal) > 0.0)
+			normal = glm::normalize(normal);
+		else
+			normal = glm::dvec3(0.0, 1.0, 0.0);
+
+		pool.parallelFor(0, height, [&](size_t rowBegin, size_t rowEnd) {
+			for (size_t j = rowBegin; j < rowEnd; ++j) {
+				double arrivalTime = getDate(settings.arrivalStart, settings.arrivalEnd, (uint32_t)j, height);
+
+				for (uint32_t i = 0; i < width; ++i) {
+					double departureTime = getDate(settings.departureStart, settings.departureEnd, i, width);
+					LambertSolution solution = solveLambert({ depPos[i], arrPos[j], arrivalTime - departureTime }, mu, normal);
+					if (!solution.valid)
+						continue;
+
+					glm::dvec3 departureDV = solution.v1 - depVel[i];
+					glm::dvec3 arrivalDV = arrVel[j] - solution.v2;
+
+					m_C3[j * width + i] = (float)glm::dot(departureDV, departureDV);
+					m_DeltaV[j * width + i] = (float)(glm::length(departureDV) + glm::length(arrivalDV));
+				}
+			}
+		});
+
+		for (uint32_t j = 0; j < height; ++j) {
+			for (uint32_t i = 0; i < width; ++i) {
+				float deltaV = m_DeltaV[j * width + i];
+				if (!std::isnan(deltaV) && (std::isnan(m_BestDeltaV) || deltaV < m_BestDeltaV)) {
+					m_BestDeltaV = deltaV;
+					m_BestDeparture = getDate(settings.departureStart, settings.departureEnd, i, width);
+					m_BestArrival = getDate(settings.arrivalStart, settings.arrivalEnd, j, height);
+				}
+			}
+		}
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "StarSystemSim/physics/potential_field.h"
+
+#include "StarSystemSim/physics/engine.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POTENTIAL_SSE 1
+#else
+#define POTENTIAL_SSE 0
+#endif
+
+namespace physics {
+
+	// incremental updates add and subtract in float, a full pass every so often clears the drift
+	static const uint32_t MAX_INCREMENTAL_UPDATES = 64;
+
+	PotentialField::PotentialField()
+		: m_IncrementalUpdates(0), m_UpdatedBodies(0)
+	{
+		m_Settings = Settings{ glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+			0, 0, 1, 0.05f, false, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f };
+	}
+
+	void PotentialField::setSettings(const Settings& settings) {
+		m_Settings = settings;
+		m_Settings.depth = std::max(m_Settings.depth, 1u);
+
+		const Settings& s = m_Settings;
+		const size_t count = (size_t)s.width * s.height * s.depth;
+		m_PointX.resize(count);
+		m_PointY.resize(count);
+		m_PointZ.resize(count);
+		m_Centrifugal.assign(count, 0.0f);
+
+		auto fraction = [](uint32_t index, uint32_t size) {
+			return size > 1 ? (float)index / (size - 1) : 0.5f;
+		};
+
+		const glm::vec3 axis = glm::length(s.rotationAxis) > 0.0f ? glm::normalize(s.rotationAxis) : glm::vec3(0.0f, 1.0f, 0.0f);
+		size_t i = 0;
+		for (uint32_t z = 0; z < s.depth; ++z) {
+			for (uint32_t y = 0; y < s.height; ++y) {
+				for (uint32_t x = 0; x < s.width; ++x, ++i) {
+					glm::vec3 point = s.origin + s.axisU * fraction(x, s.width) + s.axisV * fraction(y, s.height)
+						+ (s.depth > 1 ? s.axisW * fraction(z, s.depth) : glm::vec3(0.0f));
+					m_PointX[i] = point.x;
+					m_PointY[i] = point.y;
+					m_PointZ[i] = point.z;
+
+					if (s.rotating) {
+						glm::vec3 offset = point - s.rotationCenter;
+						glm::vec3 perpendicular = offset - axis * glm::dot(offset, axis);
+						m_Centrifugal[i] = -0.5f * s.angularVelocity * s.angularVelocity * glm::dot(perpendicular, perpendicular);
+					}
+				}
+			}
+		}
+
+		m_Gravity.assign(count, 0.0f);
+		m_Values = m_Centrifugal;
+		m_Summed.clear();
+		m_IncrementalUpdates = 0;
+	}
+
+	bool PotentialField::update(const std::vector<Body>& bodies, utils::ThreadPool& pool, float tolerance) {
+		m_UpdatedBodies = 0;
+		if (m_PointX.empty())
+			return false;
+
+		std::vector<Source> current(bodies.size());
+		for (size_t i = 0; i < bodies.size(); ++i)
+			current[i] = { bodies[i].pos, GRAVITATIONAL_CONSTANT * bodies[i].mass };
+
+		// old contributions go back in with a negated gm
+		std::vector<Source> changes;
+		bool full = current.size() != m_Summed.size() || m_IncrementalUpdates >= MAX_INCREMENTAL_UPDATES;
+		if (!full) {
+			const float toleranceSq = tolerance * tolerance;
+			for (size_t i = 0; i < current.size(); ++i) {
+				glm::vec3 moved = current[i].pos - m_Summed[i].pos;
+				if (glm::dot(moved, moved) > toleranceSq || current[i].gm != m_Summed[i].gm) {
+					changes.push_back({ m_Summed[i].pos, -m_Summed[i].gm });
+					changes.push_back(current[i]);
+					m_Summed[i] = current[i];
+				}
+			}
+
+			// past this point a fresh sum is cheaper
+			full = changes.size() > current.size();
+		}
+
+		if (full) {
+			std::fill(m_Gravity.begin(), m_Gravity.end(), 0.0f);
+			m_Summed = current;
+			m_IncrementalUpdates = 0;
+			m_UpdatedBodies = current.size();
+			accumulate(current, pool);
+		}
+		else if (!changes.empty()) {
+			m_IncrementalUpdates += 1;
+			m_UpdatedBodies = changes.size() / 2;
+			accumulate(changes, pool);
+		}
+		else
+			return false;
+
+		for (size_t i = 0; i < m_Values.size(); ++i)
+			m_Values[i] = m_Gravity[i] + m_Centrifugal[i];
+
+		return true;
+	}
+
+	void PotentialField::accumulate(const std::vector<Source>& sources, utils::ThreadPool& pool) {
+		const float softeningSq = m_Settings.softening * m_Settings.softening;
+
+		pool.parallelFor(0, m_Gravity.size(), [&](size_t begin, size_t end) {
+			const float* __restrict px = m_PointX.data();
+			const float* __restrict py = m_PointY.data();
+			const float* __restrict pz = m_PointZ.data();
+			float* __restrict phi = m_Gravity.data();
+
+			// sources in the outer loop keep a chunk of cells streaming through the inner one
+			for (const Source& source : sources) {
+				size_t i = begin;
+#if POTENTIAL_SSE
+				const __m128 sx = _mm_set1_ps(source.pos.x), sy = _mm_set1_ps(source.pos.y), sz = _mm_set1_ps(source.pos.z);
+				const __m128 gm = _mm_set1_ps(source.gm);
+				const __m128 eps = _mm_set1_ps(softeningSq);
+
+				for (; i + 4 <= end; i += 4) {
+					__m128 dx = _mm_sub_ps(sx, _mm_loadu_ps(px + i));
+					__m128 dy = _mm_sub_ps(sy, _mm_loadu_ps(py + i));
+					__m128 dz = _mm_sub_ps(sz, _mm_loadu_ps(pz + i));
+
+					__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)), eps);
+					__m128 term = _mm_div_ps(gm, _mm_sqrt_ps(distSq));
+
+					_mm_storeu_ps(phi + i, _mm_sub_ps(_mm_loadu_ps(phi + i), term));
+				}
+#endif
+				for (; i < end; ++i) {
+					float dx = source.pos.x - px[i], dy = source.pos.y - py[i], dz = source.pos.z - pz[i];
+					phi[i] -= source.gm / std::sqrt(dx * dx + dy * dy + dz * dz + softeningSq);
+				}
+			}
+		}, 1024);
+	}
+
+}
\ No newline at end of file
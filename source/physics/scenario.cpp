@@ -0,0 +1,459 @@
+#include "StarSystemSim/physics/scenario.h"
+#include "StarSystemSim/utilities/error.h"
+#include "StarSystemSim/utilities/thread_pool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SCENARIO_MMAP 1
+#else
+#define SCENARIO_MMAP 0
+#endif
+
+namespace physics {
+
+	static const char SCENARIO_MAGIC[8] = { 'S', 'S', 'S', 'C', 'E', 'N', 'E', '\0' };
+	static const uint32_t SCENARIO_VERSION = 1;
+
+	enum BodyColumn { POS_X, POS_Y, POS_Z, VEL_X, VEL_Y, VEL_Z, MASS, RADIUS, BODY_COLUMN_COUNT };
+
+	struct ScenarioHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t modelBytes;
+		uint64_t bodyCount;
+		uint64_t particleCount;
+		double startTime;
+		uint8_t padding[24];
+	};
+
+	// byte offsets of the binary columns, derived from the header alone
+	struct ScenarioLayout {
+		size_t types;
+		size_t bodyColumns[BODY_COLUMN_COUNT];
+		size_t modelOffsets;
+		size_t models;
+		size_t particleColumns[6];
+		size_t size;
+	};
+
+	static size_t alignTo64(size_t size) {
+		return (size + 63) & ~(size_t)63;
+	}
+
+	static void calcLayout(const ScenarioHeader& header, ScenarioLayout& layout) {
+		size_t offset = sizeof(ScenarioHeader);
+		auto place = [&](size_t size) {
+			size_t column = offset;
+			offset += alignTo64(size);
+			return column;
+		};
+
+		layout.types = place(header.bodyCount);
+		for (size_t& column : layout.bodyColumns)
+			column = place(header.bodyCount * sizeof(float));
+		layout.modelOffsets = place(header.bodyCount * sizeof(uint32_t));
+		layout.models = place(header.modelBytes);
+		for (size_t& column : layout.particleColumns)
+			column = place(header.particleCount * sizeof(float));
+		layout.size = offset;
+	}
+
+	// what one chunk of a text scenario parsed into, merged in file order afterwards
+	struct TextChunk {
+		std::vector<Body> bodies;
+		std::vector<std::string> models;
+		std::vector<float> particles[6];
+		bool hasTime = false;
+		double startTime = 0.0;
+		size_t lineCount = 0;
+		// line within the chunk, 0 when it parsed
+		size_t errorLine = 0;
+		std::string error;
+	};
+
+	static void skipBlanks(const char*& cursor, const char* end) {
+		while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r'))
+			++cursor;
+	}
+
+	static bool readWord(const char*& cursor, const char* end, std::string& word) {
+		skipBlanks(cursor, end);
+		const char* start = cursor;
+		while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r')
+			++cursor;
+		word.assign(start, cursor);
+		return cursor != start;
+	}
+
+	template<typename T>
+	static bool readNumber(const char*& cursor, const char* end, T& value) {
+		skipBlanks(cursor, end);
+		if (cursor >= end)
+			return false;
+
+		// the buffer is null terminated and the number stops at the line's end at the latest
+		char* numberEnd = nullptr;
+		if (std::is_same<T, float>::value)
+			value = (T)strtof(cursor, &numberEnd);
+		else
+			value = (T)strtod(cursor, &numberEnd);
+		if (numberEnd == cursor || numberEnd > end)
+			return false;
+
+		cursor = numberEnd;
+		return true;
+	}
+
+	static void parseTextChunk(const char* begin, const char* end, TextChunk& chunk) {
+		std::string keyword, word;
+
+		for (const char* line = begin; line < end; ) {
+			const char* lineEnd = (const char*)memchr(line, '\n', end - line);
+			const char* next = lineEnd ? lineEnd + 1 : end;
+			if (!lineEnd)
+				lineEnd = end;
+
+			const char* comment = (const char*)memchr(line, '#', lineEnd - line);
+			if (comment)
+				lineEnd = comment;
+
+			chunk.lineCount += 1;
+			const char* cursor = line;
+			line = next;
+
+			if (!readWord(cursor, lineEnd, keyword))
+				continue;
+
+			if (keyword == "time") {
+				if (!readNumber(cursor, lineEnd, chunk.startTime)) {
+					chunk.error = "expected a start time";
+					break;
+				}
+				chunk.hasTime = true;
+			}
+			else if (keyword == "body") {
+				Body body;
+				if (!(readNumber(cursor, lineEnd, body.mass) && readNumber(cursor, lineEnd, body.radius)
+					&& readNumber(cursor, lineEnd, body.pos.x) && readNumber(cursor, lineEnd, body.pos.y) && readNumber(cursor, lineEnd, body.pos.z)
+					&& readNumber(cursor, lineEnd, body.vel.x) && readNumber(cursor, lineEnd, body.vel.y) && readNumber(cursor, lineEnd, body.vel.z)))
+				{
+					chunk.error = "expected mass, radius, position and velocity";
+					break;
+				}
+
+				std::string model;
+				while (readWord(cursor, lineEnd, word)) {
+					if (word == "static")
+						body.type = Body::Type::STATIC;
+					else if (word == "model" && readWord(cursor, lineEnd, model))
+						continue;
+					else {
+						chunk.error = "unknown body flag \"" + word + "\"";
+						break;
+					}
+				}
+				if (!chunk.error.empty())
+					break;
+
+				if (body.mass == 0.0f && body.type == Body::Type::DYNAMIC && model.empty()) {
+					for (int axis = 0; axis < 3; ++axis) {
+						chunk.particles[axis].push_back(body.pos[axis]);
+						chunk.particles[3 + axis].push_back(body.vel[axis]);
+					}
+				}
+				else {
+					chunk.bodies.push_back(body);
+					chunk.models.push_back(std::move(model));
+				}
+			}
+			else {
+				chunk.error = "unknown keyword \"" + keyword + "\"";
+				break;
+			}
+		}
+
+		if (!chunk.error.empty())
+			chunk.errorLine = chunk.lineCount;
+	}
+
+	static bool loadTextScenario(const char* path, const char* text, size_t size, Scenario& scenario) {
+		utils::ThreadPool& pool = utils::ThreadPool::getShared();
+
+		// chunks end right after a line break so no line is split
+		const size_t targetChunks = size < (1u << 16) ? 1 : (size_t)pool.getThreadCount() * 4;
+		std::vector<const char*> bounds{ text };
+		for (size_t i = 1; i < targetChunks; ++i) {
+			const char* split = std::max(text + size * i / targetChunks, bounds.back());
+			const char* lineEnd = (const char*)memchr(split, '\n', text + size - split);
+			if (!lineEnd)
+				break;
+			if (lineEnd + 1 > bounds.back())
+				bounds.push_back(lineEnd + 1);
+		}
+		bounds.push_back(text + size);
+
+		std::vector<TextChunk> chunks(bounds.size() - 1);
+		pool.parallelFor(0, chunks.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+				parseTextChunk(bounds[i], bounds[i + 1], chunks[i]);
+		});
+
+		size_t lineNo = 0, bodyCount = 0, particleCount = 0;
+		for (const TextChunk& chunk : chunks) {
+			if (chunk.errorLine) {
+				utils::printError("%s:%zu: %s", path, lineNo + chunk.errorLine, chunk.error.c_str());
+				return false;
+			}
+			lineNo += chunk.lineCount;
+			bodyCount += chunk.bodies.size();
+			particleCount += chunk.particles[0].size();
+		}
+
+		scenario.bodies.reserve(bodyCount);
+		scenario.models.reserve(bodyCount);
+		std::vector<float> particles[6];
+		for (std::vector<float>& column : particles)
+			column.reserve(particleCount);
+
+		for (TextChunk& chunk : chunks) {
+			if (chunk.hasTime)
+				scenario.startTime = chunk.startTime;
+
+			scenario.bodies.insert(scenario.bodies.end(), chunk.bodies.begin(), chunk.bodies.end());
+			std::move(chunk.models.begin(), chunk.models.end(), std::back_inserter(scenario.models));
+			for (int column = 0; column < 6; ++column)
+				particles[column].insert(particles[column].end(), chunk.particles[column].begin(), chunk.particles[column].end());
+		}
+
+		const float* columns[6];
+		for (int column = 0; column < 6; ++column)
+			columns[column] = particles[column].data();
+		scenario.particles.assign(columns, particleCount);
+
+		return true;
+	}
+
+	static bool loadBinaryScenario(const char* path, const uint8_t* data, size_t size, Scenario& scenario) {
+		ScenarioHeader header;
+		std::memcpy(&header, data, sizeof(ScenarioHeader));
+		if (header.version != SCENARIO_VERSION) {
+			utils::printError("\"%s\" is not a supported scenario file", path);
+			return false;
+		}
+
+		ScenarioLayout layout;
+		calcLayout(header, layout);
+		if (size < layout.size) {
+			utils::printError("Scenario file (\"%s\") is truncated", path);
+			return false;
+		}
+
+		const uint8_t* types = data + layout.types;
+		const float* columns[BODY_COLUMN_COUNT];
+		for (size_t column = 0; column < BODY_COLUMN_COUNT; ++column)
+			columns[column] = (const float*)(data + layout.bodyColumns[column]);
+		const uint32_t* modelOffsets = (const uint32_t*)(data + layout.modelOffsets);
+		const char* models = (const char*)(data + layout.models);
+
+		scenario.startTime = header.startTime;
+		scenario.bodies.resize(header.bodyCount);
+		scenario.models.resize(header.bodyCount);
+
+		// offsets are one past the name's start, 0 means no model
+		utils::ThreadPool::getShared().parallelFor(0, header.bodyCount, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				Body& body = scenario.bodies[i];
+				body.pos = { columns[POS_X][i], columns[POS_Y][i], columns[POS_Z][i] };
+				body.vel = { columns[VEL_X][i], columns[VEL_Y][i], columns[VEL_Z][i] };
+				body.mass = columns[MASS][i];
+				body.radius = columns[RADIUS][i];
+				body.type = (Body::Type)types[i];
+
+				if (modelOffsets[i] && modelOffsets[i] <= header.modelBytes)
+					scenario.models[i].assign(models + modelOffsets[i] - 1, strnlen(models + modelOffsets[i] - 1, header.modelBytes - modelOffsets[i] + 1));
+			}
+		}, 4096);
+
+		const float* particleColumns[6];
+		for (int column = 0; column < 6; ++column)
+			particleColumns[column] = (const float*)(data + layout.particleColumns[column]);
+		scenario.particles.assign(particleColumns, header.particleCount);
+
+		return true;
+	}
+
+	bool loadScenario(const char* path, Scenario& scenario) {
+		scenario.startTime = 0.0;
+		scenario.bodies.clear();
+		scenario.models.clear();
+		scenario.particles.clear();
+
+#if SCENARIO_MMAP
+		int fd = open(path, O_RDONLY);
+		struct stat fileStat;
+		if (fd < 0 || fstat(fd, &fileStat) != 0) {
+			if (fd >= 0)
+				close(fd);
+			utils::printError("Failed to open scenario (\"%s\")", path);
+			return false;
+		}
+
+		// one extra zero page past the end keeps the text null terminated
+		size_t fileSize = (size_t)fileStat.st_size;
+		size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		size_t mappingSize = (fileSize / pageSize + 1) * pageSize;
+		void* mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapping != MAP_FAILED && fileSize > 0 && mmap(mapping, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+			munmap(mapping, mappingSize);
+			mapping = MAP_FAILED;
+		}
+		close(fd);
+		if (mapping == MAP_FAILED) {
+			utils::printError("Failed to map scenario (\"%s\")", path);
+			return false;
+		}
+		const char* data = (const char*)mapping;
+#else
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (file.fail()) {
+			utils::printError("Failed to open scenario (\"%s\")", path);
+			return false;
+		}
+
+		size_t fileSize = (size_t)file.tellg();
+		std::string owned(fileSize, '\0');
+		file.seekg(0);
+		if (!file.read(&owned[0], fileSize)) {
+			utils::printError("Failed to read scenario (\"%s\")", path);
+			return false;
+		}
+		const char* data = owned.c_str();
+#endif
+
+		bool ok;
+		if (fileSize >= sizeof(ScenarioHeader) && std::memcmp(data, SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC)) == 0)
+			ok = loadBinaryScenario(path, (const uint8_t*)data, fileSize, scenario);
+		else
+			ok = loadTextScenario(path, data, fileSize, scenario);
+
+#if SCENARIO_MMAP
+		munmap(mapping, mappingSize);
+#endif
+		return ok;
+	}
+
+	static bool saveBinaryScenario(const char* path, const Scenario& scenario) {
+		std::vector<uint32_t> modelOffsets(scenario.bodies.size(), 0);
+		std::string models;
+		for (size_t i = 0; i < scenario.bodies.size() && i < scenario.models.size(); ++i) {
+			if (scenario.models[i].empty())
+				continue;
+			modelOffsets[i] = (uint32_t)models.size() + 1;
+			models += scenario.models[i];
+			models += '\0';
+		}
+
+		ScenarioHeader header;
+		std::memset(&header, 0, sizeof(ScenarioHeader));
+		std::memcpy(header.magic, SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC));
+		header.version = SCENARIO_VERSION;
+		header.modelBytes = (uint32_t)models.size();
+		header.bodyCount = scenario.bodies.size();
+		header.particleCount = scenario.particles.getCount();
+		header.startTime = scenario.startTime;
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (file.fail()) {
+			utils::printError("Failed to write scenario (\"%s\")", path);
+			return false;
+		}
+
+		const char zeros[64] = {};
+		auto writeColumn = [&](const void* data, size_t size) {
+			file.write((const char*)data, size);
+			file.write(zeros, alignTo64(size) - size);
+		};
+
+		file.write((const char*)&header, sizeof(ScenarioHeader));
+
+		std::vector<uint8_t> types;
+		std::vector<float> columns[BODY_COLUMN_COUNT];
+		for (const Body& body : scenario.bodies) {
+			types.push_back((uint8_t)body.type);
+			columns[POS_X].push_back(body.pos.x);
+			columns[POS_Y].push_back(body.pos.y);
+			columns[POS_Z].push_back(body.pos.z);
+			columns[VEL_X].push_back(body.vel.x);
+			columns[VEL_Y].push_back(body.vel.y);
+			columns[VEL_Z].push_back(body.vel.z);
+			columns[MASS].push_back(body.mass);
+			columns[RADIUS].push_back(body.radius);
+		}
+
+		writeColumn(types.data(), types.size());
+		for (const std::vector<float>& column : columns)
+			writeColumn(column.data(), column.size() * sizeof(float));
+		writeColumn(modelOffsets.data(), modelOffsets.size() * sizeof(uint32_t));
+		writeColumn(models.data(), models.size());
+
+		std::vector<float> particles;
+		scenario.particles.saveState(particles);
+		for (size_t column = 0; column < 6; ++column)
+			writeColumn(particles.data() + column * header.particleCount, header.particleCount * sizeof(float));
+
+		if (!file.good()) {
+			utils::printError("Failed to write scenario (\"%s\")", path);
+			return false;
+		}
+		return true;
+	}
+
+	bool saveScenario(const char* path, const Scenario& scenario) {
+		size_t length = strlen(path);
+		if (length >= 4 && strcmp(path + length - 4, ".ssc") == 0)
+			return saveBinaryScenario(path, scenario);
+
+		FILE* file = fopen(path, "w");
+		if (!file) {
+			utils::printError("Failed to write scenario (\"%s\")", path);
+			return false;
+		}
+
+		fprintf(file, "time %.17g\n", scenario.startTime);
+		for (size_t i = 0; i < scenario.bodies.size(); ++i) {
+			const Body& body = scenario.bodies[i];
+			const char* model = i < scenario.models.size() ? scenario.models[i].c_str() : "";
+			fprintf(file, "body %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g%s%s%s\n",
+				body.mass, body.radius,
+				body.pos.x, body.pos.y, body.pos.z,
+				body.vel.x, body.vel.y, body.vel.z,
+				body.type == Body::Type::STATIC ? " static" : "",
+				*model ? " model " : "", model);
+		}
+
+		for (size_t i = 0; i < scenario.particles.getCount(); ++i) {
+			glm::vec3 pos = scenario.particles.getPos(i), vel = scenario.particles.getVel(i);
+			fprintf(file, "body 0 0 %.9g %.9g %.9g %.9g %.9g %.9g\n", pos.x, pos.y, pos.z, vel.x, vel.y, vel.z);
+		}
+
+		bool ok = ferror(file) == 0;
+		ok = fclose(file) == 0 && ok;
+		if (!ok)
+			utils::printError("Failed to write scenario (\"%s\")", path);
+
+		return ok;
+	}
+
+}
\ No newline at end of file
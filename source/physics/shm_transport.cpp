@@ -0,0 +1,238 @@
+#include "StarSystemSim/physics/shm_transport.h"
+
+#include "StarSystemSim/utilities/error.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHM_TRANSPORT 1
+#else
+#define SHM_TRANSPORT 0
+#endif
+
+namespace physics {
+
+	static const uint32_t SHM_MAGIC = 0x53535354; // "SSST"
+	// spins of a wait between liveness checks
+	static const uint32_t LIVENESS_SPINS = 1 << 14;
+
+	static size_t alignTo64(size_t size) {
+		return (size + 63) & ~(size_t)63;
+	}
+
+	// lives at the start of the segment, the slots follow as
+	// [buffer][rank] blocks of a size word and slotCapacity bytes
+	struct ShmTransport::Header {
+		std::atomic<uint32_t> magic;
+		uint32_t rankCount;
+		uint64_t slotCapacity;
+
+		alignas(64) std::atomic<uint32_t> arrived;
+		alignas(64) std::atomic<uint32_t> generation;
+		alignas(64) std::atomic<uint32_t> aborted;
+	};
+
+	ShmTransport::ShmTransport()
+		: m_Rank(0), m_RankCount(1), m_SlotCapacity(0), m_SegmentSize(0), m_Exchanges(0),
+		m_Segment(nullptr), m_Header(nullptr), m_Failed(false)
+	{}
+
+	ShmTransport::~ShmTransport() {
+		close();
+	}
+
+	uint8_t* ShmTransport::getSlot(uint32_t buffer, uint32_t rank) const {
+		size_t slotSize = alignTo64(sizeof(uint64_t) + m_SlotCapacity);
+		return (uint8_t*)m_Segment + alignTo64(sizeof(Header)) + ((size_t)buffer * m_RankCount + rank) * slotSize;
+	}
+
+	bool ShmTransport::open(const char* name, uint32_t rank, uint32_t rankCount, size_t slotCapacity) {
+		close();
+
+		if (rank >= rankCount) {
+			utils::printError("Rank %u is out of range for %u ranks", rank, rankCount);
+			return false;
+		}
+
+#if SHM_TRANSPORT
+		size_t segmentSize = alignTo64(sizeof(Header)) + 2 * (size_t)rankCount * alignTo64(sizeof(uint64_t) + slotCapacity);
+
+		int fd = -1;
+		if (rank == 0) {
+			shm_unlink(name);
+			fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd >= 0 && ftruncate(fd, segmentSize) != 0) {
+				::close(fd);
+				fd = -1;
+			}
+		}
+		else {
+			// the segment may not exist yet or not be sized yet
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+			while (std::chrono::steady_clock::now() < deadline && (!m_LivenessCheck || m_LivenessCheck())) {
+				fd = shm_open(name, O_RDWR, 0600);
+				struct stat segmentStat;
+				if (fd >= 0 && fstat(fd, &segmentStat) == 0 && (size_t)segmentStat.st_size >= segmentSize)
+					break;
+				if (fd >= 0)
+					::close(fd);
+				fd = -1;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		if (fd < 0) {
+			utils::printError("Failed to open shared memory segment (\"%s\")", name);
+			return false;
+		}
+
+		void* segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (segment == MAP_FAILED) {
+			utils::printError("Failed to map shared memory segment (\"%s\")", name);
+			if (rank == 0)
+				shm_unlink(name);
+			return false;
+		}
+
+		m_Name = name;
+		m_Rank = rank;
+		m_RankCount = rankCount;
+		m_SlotCapacity = slotCapacity;
+		m_SegmentSize = segmentSize;
+		m_Exchanges = 0;
+		m_Segment = segment;
+		m_Header = (Header*)segment;
+		m_Failed = false;
+
+		// a fresh segment is zero filled, the magic is published last
+		if (rank == 0) {
+			m_Header->rankCount = rankCount;
+			m_Header->slotCapacity = slotCapacity;
+			m_Header->arrived.store(0, std::memory_order_relaxed);
+			m_Header->generation.store(0, std::memory_order_relaxed);
+			m_Header->aborted.store(0, std::memory_order_relaxed);
+			m_Header->magic.store(SHM_MAGIC, std::memory_order_release);
+		}
+		else {
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+			while (m_Header->magic.load(std::memory_order_acquire) != SHM_MAGIC) {
+				if (std::chrono::steady_clock::now() > deadline || (m_LivenessCheck && !m_LivenessCheck())) {
+					utils::printError("Shared memory segment (\"%s\") was never set up", name);
+					close();
+					return false;
+				}
+				std::this_thread::yield();
+			}
+
+			if (m_Header->rankCount != rankCount || m_Header->slotCapacity != slotCapacity) {
+				utils::printError("Shared memory segment (\"%s\") was made for another layout", name);
+				close();
+				return false;
+			}
+		}
+
+		return true;
+#else
+		(void)name;
+		(void)slotCapacity;
+		utils::printError("Shared memory transport is not supported on this platform");
+		return false;
+#endif
+	}
+
+	void ShmTransport::close() {
+#if SHM_TRANSPORT
+		if (m_Segment) {
+			munmap(m_Segment, m_SegmentSize);
+			if (m_Rank == 0)
+				shm_unlink(m_Name.c_str());
+		}
+#endif
+		m_Segment = nullptr;
+		m_Header = nullptr;
+		m_SegmentSize = 0;
+	}
+
+	void ShmTransport::abort() {
+		m_Failed = true;
+		if (m_Header)
+			m_Header->aborted.store(1, std::memory_order_release);
+	}
+
+	bool ShmTransport::barrier() {
+		if (!m_Header || m_Failed)
+			return false;
+
+		uint32_t generation = m_Header->generation.load(std::memory_order_acquire);
+		if (m_Header->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_RankCount) {
+			m_Header->arrived.store(0, std::memory_order_relaxed);
+			m_Header->generation.store(generation + 1, std::memory_order_release);
+			return true;
+		}
+
+		// short waits spin, longer ones give the core away and now and then check the other ranks
+		for (uint32_t spin = 1; m_Header->generation.load(std::memory_order_acquire) == generation; ++spin) {
+			if (m_Header->aborted.load(std::memory_order_acquire)) {
+				m_Failed = true;
+				return false;
+			}
+			if (spin > 1024)
+				std::this_thread::yield();
+
+			if (spin % LIVENESS_SPINS != 0 || !m_LivenessCheck || m_LivenessCheck())
+				continue;
+
+			// a peer may exit right after releasing this barrier, that is only a loss while it is still closed
+			if (m_Header->generation.load(std::memory_order_acquire) == generation) {
+				utils::printError("Rank %u lost a peer, giving up", m_Rank);
+				abort();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool ShmTransport::allGather(const void* data, size_t size, std::vector<std::vector<uint8_t>>& received) {
+		if (!m_Header || m_Failed) {
+			received.clear();
+			return false;
+		}
+
+		// an oversized message still takes part in the barrier so the other ranks do not hang
+		bool fits = size <= m_SlotCapacity;
+		if (!fits)
+			utils::printError("Rank %u tried to send %zu bytes through %zu byte slots", m_Rank, size, m_SlotCapacity);
+
+		// the buffer written now was last read two exchanges ago, before the previous barrier
+		uint32_t buffer = (uint32_t)(m_Exchanges++ & 1);
+		uint8_t* slot = getSlot(buffer, m_Rank);
+		uint64_t slotSize = fits ? size : 0;
+		std::memcpy(slot, &slotSize, sizeof(uint64_t));
+		if (fits)
+			std::memcpy(slot + sizeof(uint64_t), data, size);
+
+		if (!barrier()) {
+			received.clear();
+			return false;
+		}
+
+		received.resize(m_RankCount);
+		for (uint32_t rank = 0; rank < m_RankCount; ++rank) {
+			const uint8_t* other = getSlot(buffer, rank);
+			uint64_t otherSize;
+			std::memcpy(&otherSize, other, sizeof(uint64_t));
+			received[rank].assign(other + sizeof(uint64_t), other + sizeof(uint64_t) + otherSize);
+		}
+
+		return fits;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,267 @@
+#include "StarSystemSim/physics/state_export.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/physics/particle_system.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define STATE_EXPORT 1
+#else
+#define STATE_EXPORT 0
+#endif
+
+namespace physics {
+
+	static const char EXPORT_MAGIC[8] = { 'S', 'S', 'S', 'S', 'T', 'A', 'T', 'E' };
+	static const uint32_t EXPORT_VERSION = 1;
+
+	static size_t alignTo64(size_t size) {
+		return (size + 63) & ~(size_t)63;
+	}
+
+	static size_t getBodyColumnOffset(const StateExportHeader& header, size_t column) {
+		return alignTo64(sizeof(StateExportHeader)) + column * alignTo64(header.bodyCapacity * sizeof(float));
+	}
+
+	static size_t getParticleColumnOffset(const StateExportHeader& header, size_t column) {
+		return getBodyColumnOffset(header, EXPORT_BODY_COLUMN_COUNT) + column * alignTo64(header.particleCapacity * sizeof(float));
+	}
+
+	StateExport::StateExport()
+		: m_Segment(nullptr), m_SegmentSize(0), m_Header(nullptr), m_Truncated(false)
+	{
+		static_assert(std::atomic<uint64_t>::is_always_lock_free, "the sequence has to work across processes");
+	}
+
+	StateExport::~StateExport() {
+		close();
+	}
+
+	bool StateExport::open(const char* name, size_t bodyCapacity, size_t particleCapacity) {
+		close();
+
+#if STATE_EXPORT
+		StateExportHeader layout;
+		layout.bodyCapacity = bodyCapacity;
+		layout.particleCapacity = particleCapacity;
+		size_t segmentSize = getParticleColumnOffset(layout, 6);
+
+		shm_unlink(name);
+		int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+		if (fd >= 0 && ftruncate(fd, segmentSize) != 0) {
+			::close(fd);
+			shm_unlink(name);
+			fd = -1;
+		}
+		if (fd < 0) {
+			utils::printError("Failed to create shared memory segment (\"%s\")", name);
+			return false;
+		}
+
+		void* segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (segment == MAP_FAILED) {
+			utils::printError("Failed to map shared memory segment (\"%s\")", name);
+			shm_unlink(name);
+			return false;
+		}
+
+		m_Name = name;
+		m_Segment = segment;
+		m_SegmentSize = segmentSize;
+		m_Truncated = false;
+
+		// the segment is zero filled, so readers see an empty frame until the first publish
+		m_Header = (StateExportHeader*)segment;
+		m_Header->version = EXPORT_VERSION;
+		m_Header->headerSize = sizeof(StateExportHeader);
+		m_Header->bodyCapacity = bodyCapacity;
+		m_Header->particleCapacity = particleCapacity;
+		std::atomic_thread_fence(std::memory_order_release);
+		std::memcpy(m_Header->magic, EXPORT_MAGIC, sizeof(EXPORT_MAGIC));
+
+		return true;
+#else
+		(void)name;
+		(void)bodyCapacity;
+		(void)particleCapacity;
+		utils::printError("State export is not supported on this platform");
+		return false;
+#endif
+	}
+
+	void StateExport::close() {
+#if STATE_EXPORT
+		if (m_Segment) {
+			munmap(m_Segment, m_SegmentSize);
+			shm_unlink(m_Name.c_str());
+		}
+#endif
+		m_Segment = nullptr;
+		m_SegmentSize = 0;
+		m_Header = nullptr;
+	}
+
+	void StateExport::publish(const Engine& engine) {
+		if (!m_Header)
+			return;
+
+		// gathered before the frame is opened so readers retry as rarely as possible
+		for (std::vector<float>& column : m_Columns)
+			column.clear();
+
+		engine.getBodies(m_Bodies);
+		size_t bodyCount = std::min<size_t>(m_Bodies.size(), m_Header->bodyCapacity);
+		for (size_t i = 0; i < bodyCount; ++i) {
+			for (int axis = 0; axis < 3; ++axis) {
+				m_Columns[EXPORT_POS_X + axis].push_back(m_Bodies[i].pos[axis]);
+				m_Columns[EXPORT_VEL_X + axis].push_back(m_Bodies[i].vel[axis]);
+			}
+			m_Columns[EXPORT_MASS].push_back(m_Bodies[i].mass);
+		}
+
+		size_t particleTotal = 0;
+		for (const ParticleSystem* particles : engine.getParticleSystems())
+			particleTotal += particles->getCount();
+		size_t particleCount = std::min<size_t>(particleTotal, m_Header->particleCapacity);
+
+		if ((bodyCount < m_Bodies.size() || particleCount < particleTotal) && !m_Truncated) {
+			utils::printError("State export (\"%s\") only holds %zu bodies and %zu particles", m_Name.c_str(),
+				(size_t)m_Header->bodyCapacity, (size_t)m_Header->particleCapacity);
+			m_Truncated = true;
+		}
+
+		uint8_t* base = (uint8_t*)m_Segment;
+		uint64_t sequence = m_Header->sequence.load(std::memory_order_relaxed);
+		m_Header->sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		m_Header->simTime = engine.getSimTime();
+		m_Header->bodyCount = bodyCount;
+		m_Header->particleCount = particleCount;
+
+		for (size_t column = 0; column < EXPORT_BODY_COLUMN_COUNT; ++column)
+			std::memcpy(base + getBodyColumnOffset(*m_Header, column), m_Columns[column].data(), bodyCount * sizeof(float));
+
+		// every system's particles one after the other
+		size_t written = 0;
+		for (const ParticleSystem* particles : engine.getParticleSystems()) {
+			size_t count = std::min(particles->getCount(), particleCount - written);
+			if (count == 0)
+				break;
+
+			particles->saveState(m_ParticleState);
+			for (size_t column = 0; column < 6; ++column) {
+				std::memcpy(base + getParticleColumnOffset(*m_Header, column) + written * sizeof(float),
+					m_ParticleState.data() + column * particles->getCount(), count * sizeof(float));
+			}
+			written += count;
+		}
+
+		m_Header->sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	StateExportReader::StateExportReader()
+		: m_Segment(nullptr), m_SegmentSize(0), m_Header(nullptr)
+	{}
+
+	StateExportReader::~StateExportReader() {
+		close();
+	}
+
+	bool StateExportReader::open(const char* name) {
+		close();
+
+#if STATE_EXPORT
+		int fd = shm_open(name, O_RDONLY, 0);
+		struct stat segmentStat;
+		if (fd < 0 || fstat(fd, &segmentStat) != 0 || (size_t)segmentStat.st_size < sizeof(StateExportHeader)) {
+			if (fd >= 0)
+				::close(fd);
+			utils::printError("Failed to open shared memory segment (\"%s\")", name);
+			return false;
+		}
+
+		size_t segmentSize = (size_t)segmentStat.st_size;
+		void* segment = mmap(nullptr, segmentSize, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (segment == MAP_FAILED) {
+			utils::printError("Failed to map shared memory segment (\"%s\")", name);
+			return false;
+		}
+
+		const StateExportHeader* header = (const StateExportHeader*)segment;
+		if (std::memcmp(header->magic, EXPORT_MAGIC, sizeof(EXPORT_MAGIC)) != 0 || header->version != EXPORT_VERSION
+			|| segmentSize < getParticleColumnOffset(*header, 6))
+		{
+			utils::printError("\"%s\" is not a state export segment", name);
+			munmap(segment, segmentSize);
+			return false;
+		}
+
+		m_Segment = segment;
+		m_SegmentSize = segmentSize;
+		m_Header = header;
+		return true;
+#else
+		(void)name;
+		utils::printError("State export is not supported on this platform");
+		return false;
+#endif
+	}
+
+	void StateExportReader::close() {
+#if STATE_EXPORT
+		if (m_Segment)
+			munmap((void*)m_Segment, m_SegmentSize);
+#endif
+		m_Segment = nullptr;
+		m_SegmentSize = 0;
+		m_Header = nullptr;
+	}
+
+	bool StateExportReader::read(Frame& frame, uint32_t attempts) const {
+		if (!m_Header)
+			return false;
+
+		const uint8_t* base = (const uint8_t*)m_Segment;
+		for (uint32_t attempt = 0; attempt < attempts; ++attempt) {
+			uint64_t sequence = m_Header->sequence.load(std::memory_order_acquire);
+			if (sequence & 1) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			// counts are clamped in case they were read mid-write, the sequence check throws such reads away
+			size_t bodyCount = std::min<size_t>(m_Header->bodyCount, m_Header->bodyCapacity);
+			size_t particleCount = std::min<size_t>(m_Header->particleCount, m_Header->particleCapacity);
+			frame.simTime = m_Header->simTime;
+
+			for (size_t column = 0; column < EXPORT_BODY_COLUMN_COUNT; ++column) {
+				const float* source = (const float*)(base + getBodyColumnOffset(*m_Header, column));
+				frame.bodies[column].assign(source, source + bodyCount);
+			}
+			for (size_t column = 0; column < 6; ++column) {
+				const float* source = (const float*)(base + getParticleColumnOffset(*m_Header, column));
+				frame.particles[column].assign(source, source + particleCount);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (m_Header->sequence.load(std::memory_order_relaxed) == sequence) {
+				frame.frame = sequence / 2;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+}
\ No newline at end of file
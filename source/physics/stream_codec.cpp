@@ -0,0 +1,240 @@
+#include "StarSystemSim/physics/stream_codec.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace physics {
+
+	static const uint32_t STREAM_MAGIC = 0x46535353; // "SSSF"
+	static const size_t STREAM_HEADER_SIZE = 16;
+
+	enum FrameType : uint8_t { KEYFRAME = 0, DELTA = 1 };
+
+	// the box grows by this much of its size so slow drifts stay inside it for a while
+	static const float BOX_MARGIN = 0.25f;
+
+	static void putBytes(std::vector<uint8_t>& out, const void* data, size_t size) {
+		const uint8_t* bytes = (const uint8_t*)data;
+		out.insert(out.end(), bytes, bytes + size);
+	}
+
+	static void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+		while (value >= 0x80) {
+			out.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((uint8_t)value);
+	}
+
+	static bool getVarint(const uint8_t*& cursor, const uint8_t* end, uint32_t& value) {
+		value = 0;
+		for (uint32_t shift = 0; shift < 35; shift += 7) {
+			if (cursor >= end)
+				return false;
+			uint8_t byte = *cursor++;
+			value |= (uint32_t)(byte & 0x7f) << shift;
+			if (!(byte & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	static uint32_t zigzag(int32_t value) {
+		return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+	}
+
+	static int32_t unzigzag(uint32_t value) {
+		return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+	}
+
+	StreamEncoder::StreamEncoder(uint32_t bits, uint32_t keyframeInterval)
+		: m_Bits(std::min(std::max(bits, 8u), 24u)), m_KeyframeInterval(std::max(keyframeInterval, 1u)),
+		m_SinceKeyframe(0), m_BoxMin(0.0f), m_BoxExtent(1.0f)
+	{}
+
+	void StreamEncoder::encode(uint64_t frame, double simTime, const std::vector<glm::vec3>& positions, std::vector<uint8_t>& out,
+		bool forceKeyframe)
+	{
+		const size_t count = positions.size();
+		const float scale = (float)((1u << m_Bits) - 1);
+
+		bool keyframe = forceKeyframe || m_SinceKeyframe + 1 >= m_KeyframeInterval || m_Previous[0].size() != count;
+		if (!keyframe) {
+			const glm::vec3 boxMax = m_BoxMin + m_BoxExtent;
+			for (const glm::vec3& pos : positions) {
+				if (pos.x < m_BoxMin.x || pos.y < m_BoxMin.y || pos.z < m_BoxMin.z
+					|| pos.x > boxMax.x || pos.y > boxMax.y || pos.z > boxMax.z || std::isnan(pos.x + pos.y + pos.z))
+				{
+					keyframe = true;
+					break;
+				}
+			}
+		}
+
+		if (keyframe) {
+			glm::vec3 low(0.0f), high(0.0f);
+			if (count) {
+				low = high = positions[0];
+				for (const glm::vec3& pos : positions) {
+					low = glm::min(low, pos);
+					high = glm::max(high, pos);
+				}
+			}
+
+			glm::vec3 margin = glm::max((high - low) * BOX_MARGIN, glm::vec3(1e-3f));
+			m_BoxMin = low - margin;
+			m_BoxExtent = high - low + 2.0f * margin;
+			m_SinceKeyframe = 0;
+		}
+		else {
+			m_SinceKeyframe += 1;
+		}
+
+		for (int axis = 0; axis < 3; ++axis) {
+			m_Current[axis].resize(count);
+			for (size_t i = 0; i < count; ++i) {
+				float unit = (positions[i][axis] - m_BoxMin[axis]) / m_BoxExtent[axis];
+				float clamped = std::min(std::max(unit, 0.0f), 1.0f);
+				m_Current[axis][i] = (int32_t)std::lround(clamped * scale);
+			}
+		}
+
+		size_t start = out.size();
+		uint8_t type = keyframe ? KEYFRAME : DELTA;
+		uint8_t bits = (uint8_t)m_Bits;
+		uint16_t reserved = 0;
+		uint32_t bodyCount = (uint32_t)count;
+		uint32_t payloadSize = 0;
+
+		putBytes(out, &STREAM_MAGIC, 4);
+		putBytes(out, &payloadSize, 4);
+		putBytes(out, &type, 1);
+		putBytes(out, &bits, 1);
+		putBytes(out, &reserved, 2);
+		putBytes(out, &bodyCount, 4);
+		putBytes(out, &frame, 8);
+		putBytes(out, &simTime, 8);
+
+		if (keyframe) {
+			putBytes(out, &m_BoxMin, sizeof(glm::vec3));
+			putBytes(out, &m_BoxExtent, sizeof(glm::vec3));
+
+			const size_t width = (m_Bits + 7) / 8;
+			for (int axis = 0; axis < 3; ++axis) {
+				for (size_t i = 0; i < count; ++i) {
+					uint32_t value = (uint32_t)m_Current[axis][i];
+					putBytes(out, &value, width);
+				}
+			}
+		}
+		else {
+			for (int axis = 0; axis < 3; ++axis) {
+				for (size_t i = 0; i < count; ++i)
+					putVarint(out, zigzag(m_Current[axis][i] - m_Previous[axis][i]));
+			}
+		}
+
+		payloadSize = (uint32_t)(out.size() - start - STREAM_HEADER_SIZE);
+		std::memcpy(out.data() + start + 4, &payloadSize, 4);
+
+		for (int axis = 0; axis < 3; ++axis)
+			std::swap(m_Previous[axis], m_Current[axis]);
+	}
+
+	StreamDecoder::StreamDecoder()
+		: m_Offset(0), m_Failed(false), m_HasKeyframe(false), m_Bits(16),
+		m_BoxMin(0.0f), m_BoxExtent(1.0f)
+	{}
+
+	void StreamDecoder::feed(const uint8_t* data, size_t size) {
+		// parsed bytes are dropped once they make up most of the buffer
+		if (m_Offset > m_Buffer.size() / 2) {
+			m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + m_Offset);
+			m_Offset = 0;
+		}
+		m_Buffer.insert(m_Buffer.end(), data, data + size);
+	}
+
+	bool StreamDecoder::next(Frame& frame) {
+		if (m_Failed || m_Buffer.size() - m_Offset < STREAM_HEADER_SIZE)
+			return false;
+
+		const uint8_t* header = m_Buffer.data() + m_Offset;
+		uint32_t magic, payloadSize, bodyCount;
+		std::memcpy(&magic, header, 4);
+		std::memcpy(&payloadSize, header + 4, 4);
+		uint8_t type = header[8], bits = header[9];
+		std::memcpy(&bodyCount, header + 12, 4);
+
+		if (magic != STREAM_MAGIC || bits < 8 || bits > 24 || type > DELTA) {
+			m_Failed = true;
+			return false;
+		}
+		if (m_Buffer.size() - m_Offset - STREAM_HEADER_SIZE < payloadSize)
+			return false;
+
+		const uint8_t* cursor = header + STREAM_HEADER_SIZE;
+		const uint8_t* end = cursor + payloadSize;
+		m_Offset += STREAM_HEADER_SIZE + payloadSize;
+
+		if (payloadSize < 16 || (type == DELTA && (!m_HasKeyframe || bodyCount != m_Values[0].size() || bits != m_Bits))) {
+			m_Failed = true;
+			return false;
+		}
+
+		std::memcpy(&frame.frame, cursor, 8);
+		std::memcpy(&frame.simTime, cursor + 8, 8);
+		cursor += 16;
+
+		if (type == KEYFRAME) {
+			const size_t width = (bits + 7) / 8;
+			if ((size_t)(end - cursor) < 2 * sizeof(glm::vec3) + 3 * width * bodyCount) {
+				m_Failed = true;
+				return false;
+			}
+
+			std::memcpy(&m_BoxMin, cursor, sizeof(glm::vec3));
+			std::memcpy(&m_BoxExtent, cursor + sizeof(glm::vec3), sizeof(glm::vec3));
+			cursor += 2 * sizeof(glm::vec3);
+
+			for (int axis = 0; axis < 3; ++axis) {
+				m_Values[axis].resize(bodyCount);
+				for (uint32_t i = 0; i < bodyCount; ++i) {
+					uint32_t value = 0;
+					std::memcpy(&value, cursor, width);
+					cursor += width;
+					m_Values[axis][i] = (int32_t)value;
+				}
+			}
+
+			m_Bits = bits;
+			m_HasKeyframe = true;
+		}
+		else {
+			for (int axis = 0; axis < 3; ++axis) {
+				for (uint32_t i = 0; i < bodyCount; ++i) {
+					uint32_t value;
+					if (!getVarint(cursor, end, value)) {
+						m_Failed = true;
+						return false;
+					}
+					m_Values[axis][i] += unzigzag(value);
+				}
+			}
+		}
+
+		const float scale = (float)((1u << m_Bits) - 1);
+		frame.keyframe = type == KEYFRAME;
+		frame.positions.resize(bodyCount);
+		for (uint32_t i = 0; i < bodyCount; ++i) {
+			for (int axis = 0; axis < 3; ++axis)
+				frame.positions[i][axis] = m_BoxMin[axis] + m_Values[axis][i] / scale * m_BoxExtent[axis];
+		}
+
+		return true;
+	}
+
+}
\ No newline at end of file
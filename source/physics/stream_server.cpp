@@ -0,0 +1,298 @@
+#include "StarSystemSim/physics/stream_server.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define STREAM_SERVER 1
+#else
+#define STREAM_SERVER 0
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace physics {
+
+	struct StreamServer::Subscriber {
+		int socket;
+		StreamEncoder encoder;
+		// bytes of the frame being sent, no newer frame is encoded until they are out
+		std::vector<uint8_t> pending;
+		size_t sent;
+		uint64_t lastFrame;
+
+		Subscriber(int socket, const Settings& settings)
+			: socket(socket), encoder(settings.bits, settings.keyframeInterval), sent(0), lastFrame(0)
+		{}
+	};
+
+	StreamServer::StreamServer()
+		: m_ListenSocket(-1), m_WakePipe{ -1, -1 }, m_Quit(false),
+		m_LatestTime(0.0), m_LatestFrame(0),
+		m_SubscriberCount(0), m_SentBytes(0), m_DroppedFrames(0)
+	{}
+
+	StreamServer::~StreamServer() {
+		close();
+	}
+
+#if STREAM_SERVER
+	static bool setNonBlocking(int fd) {
+		int flags = fcntl(fd, F_GETFL, 0);
+		return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+	}
+
+	static void setNoSigPipe(int fd) {
+#ifdef SO_NOSIGPIPE
+		int one = 1;
+		setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#else
+		(void)fd;
+#endif
+	}
+#endif
+
+	bool StreamServer::open(const char* address, const Settings& settings) {
+		close();
+
+#if STREAM_SERVER
+		int listenSocket = -1;
+		std::string unixPath;
+
+		const char* colon = strrchr(address, ':');
+		if (colon) {
+			std::string host(address, colon);
+			if (host.empty() || host == "localhost")
+				host = "127.0.0.1";
+
+			sockaddr_in socketAddress;
+			std::memset(&socketAddress, 0, sizeof(socketAddress));
+			socketAddress.sin_family = AF_INET;
+			socketAddress.sin_port = htons((uint16_t)atoi(colon + 1));
+			if (inet_pton(AF_INET, host.c_str(), &socketAddress.sin_addr) != 1) {
+				utils::printError("Cannot listen on \"%s\", expected an IPv4 address", address);
+				return false;
+			}
+
+			listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+			int one = 1;
+			if (listenSocket >= 0)
+				setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+			if (listenSocket >= 0 && bind(listenSocket, (sockaddr*)&socketAddress, sizeof(socketAddress)) != 0) {
+				::close(listenSocket);
+				listenSocket = -1;
+			}
+		}
+		else {
+			sockaddr_un socketAddress;
+			std::memset(&socketAddress, 0, sizeof(socketAddress));
+			socketAddress.sun_family = AF_UNIX;
+			if (strlen(address) >= sizeof(socketAddress.sun_path)) {
+				utils::printError("Socket path \"%s\" is too long", address);
+				return false;
+			}
+			strcpy(socketAddress.sun_path, address);
+
+			// a socket file left behind by an earlier run
+			unlink(address);
+			listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (listenSocket >= 0 && bind(listenSocket, (sockaddr*)&socketAddress, sizeof(socketAddress)) != 0) {
+				::close(listenSocket);
+				listenSocket = -1;
+			}
+			unixPath = address;
+		}
+
+		if (listenSocket < 0 || listen(listenSocket, 16) != 0 || !setNonBlocking(listenSocket)) {
+			if (listenSocket >= 0)
+				::close(listenSocket);
+			utils::printError("Failed to listen on \"%s\"", address);
+			return false;
+		}
+
+		if (pipe(m_WakePipe) != 0 || !setNonBlocking(m_WakePipe[0]) || !setNonBlocking(m_WakePipe[1])) {
+			::close(listenSocket);
+			utils::printError("Failed to create the stream server's wake pipe");
+			return false;
+		}
+
+		m_Settings = settings;
+		m_UnixPath = unixPath;
+		m_ListenSocket = listenSocket;
+		m_LatestFrame = 0;
+		m_SentBytes = 0;
+		m_DroppedFrames = 0;
+		m_Quit = false;
+		m_Thread = std::thread(&StreamServer::networkLoop, this);
+
+		return true;
+#else
+		(void)address;
+		(void)settings;
+		utils::printError("The stream server is not supported on this platform");
+		return false;
+#endif
+	}
+
+	void StreamServer::close() {
+#if STREAM_SERVER
+		if (m_Thread.joinable()) {
+			m_Quit = true;
+			char wake = 0;
+			if (write(m_WakePipe[1], &wake, 1) < 0) {}
+			m_Thread.join();
+		}
+
+		if (m_ListenSocket >= 0)
+			::close(m_ListenSocket);
+		for (int& fd : m_WakePipe) {
+			if (fd >= 0)
+				::close(fd);
+			fd = -1;
+		}
+		if (!m_UnixPath.empty())
+			unlink(m_UnixPath.c_str());
+#endif
+		m_ListenSocket = -1;
+		m_UnixPath.clear();
+		m_SubscriberCount = 0;
+	}
+
+	void StreamServer::publish(const Engine& engine) {
+		if (!isOpen())
+			return;
+
+		engine.getBodies(m_Bodies);
+
+		std::unique_lock<std::mutex> lock(m_FrameMutex, std::try_to_lock);
+		if (!lock.owns_lock()) {
+			m_DroppedFrames.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		m_Latest.resize(m_Bodies.size());
+		for (size_t i = 0; i < m_Bodies.size(); ++i)
+			m_Latest[i] = m_Bodies[i].pos;
+		m_LatestTime = engine.getSimTime();
+		m_LatestFrame += 1;
+		lock.unlock();
+
+#if STREAM_SERVER
+		// a full pipe already holds a wake up
+		char wake = 0;
+		if (write(m_WakePipe[1], &wake, 1) < 0) {}
+#endif
+	}
+
+	void StreamServer::networkLoop() {
+#if STREAM_SERVER
+		std::vector<std::unique_ptr<Subscriber>> subscribers;
+		std::vector<pollfd> fds;
+		std::vector<glm::vec3> positions;
+		double simTime = 0.0;
+		uint64_t frame = 0;
+		uint8_t scratch[4096];
+
+		auto flush = [this](Subscriber& subscriber) {
+			while (subscriber.sent < subscriber.pending.size()) {
+				ssize_t count = send(subscriber.socket, subscriber.pending.data() + subscriber.sent,
+					subscriber.pending.size() - subscriber.sent, MSG_NOSIGNAL);
+				if (count < 0)
+					return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+				subscriber.sent += (size_t)count;
+				m_SentBytes.fetch_add((uint64_t)count, std::memory_order_relaxed);
+			}
+
+			subscriber.pending.clear();
+			subscriber.sent = 0;
+			return true;
+		};
+
+		while (!m_Quit) {
+			fds.clear();
+			fds.push_back({ m_ListenSocket, POLLIN, 0 });
+			fds.push_back({ m_WakePipe[0], POLLIN, 0 });
+			for (const std::unique_ptr<Subscriber>& subscriber : subscribers)
+				fds.push_back({ subscriber->socket, (short)(POLLIN | (subscriber->pending.empty() ? 0 : POLLOUT)), 0 });
+
+			if (poll(fds.data(), (nfds_t)fds.size(), 100) < 0 && errno != EINTR)
+				break;
+
+			if (fds[1].revents & POLLIN) {
+				while (read(m_WakePipe[0], scratch, sizeof(scratch)) > 0) {}
+			}
+
+			if (fds[0].revents & POLLIN) {
+				int fd;
+				while ((fd = accept(m_ListenSocket, nullptr, nullptr)) >= 0) {
+					setNonBlocking(fd);
+					setNoSigPipe(fd);
+					int one = 1;
+					setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+					subscribers.emplace_back(new Subscriber(fd, m_Settings));
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_FrameMutex);
+				if (m_LatestFrame != frame) {
+					positions.swap(m_Latest);
+					simTime = m_LatestTime;
+					frame = m_LatestFrame;
+				}
+			}
+
+			for (size_t i = 0; i < subscribers.size(); ++i) {
+				Subscriber& subscriber = *subscribers[i];
+				bool alive = true;
+
+				// subscribers have nothing to say, reading only tells when they hang up
+				short events = i + 2 < fds.size() && fds[i + 2].fd == subscriber.socket ? fds[i + 2].revents : 0;
+				if (events & (POLLIN | POLLHUP | POLLERR)) {
+					ssize_t count = recv(subscriber.socket, scratch, sizeof(scratch), 0);
+					alive = count > 0 || (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+				}
+
+				if (alive)
+					alive = flush(subscriber);
+
+				if (alive && subscriber.pending.empty() && frame > subscriber.lastFrame && frame) {
+					if (subscriber.lastFrame)
+						m_DroppedFrames.fetch_add(frame - subscriber.lastFrame - 1, std::memory_order_relaxed);
+
+					subscriber.encoder.encode(frame, simTime, positions, subscriber.pending, subscriber.lastFrame == 0);
+					subscriber.lastFrame = frame;
+					alive = flush(subscriber);
+				}
+
+				if (!alive) {
+					::close(subscriber.socket);
+					subscribers.erase(subscribers.begin() + i);
+					fds.erase(fds.begin() + i + 2);
+					--i;
+				}
+			}
+
+			m_SubscriberCount.store((uint32_t)subscribers.size(), std::memory_order_relaxed);
+		}
+
+		for (const std::unique_ptr<Subscriber>& subscriber : subscribers)
+			::close(subscriber->socket);
+#endif
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "StarSystemSim/physics/timeline.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/physics/particle_system.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace physics {
+
+	Timeline::Timeline()
+		: Timeline(64, (size_t)256 << 20)
+	{}
+
+	Timeline::Timeline(size_t keyframeInterval, size_t memoryBudget)
+		: m_Interval(std::max<size_t>(keyframeInterval, 1)), m_MemoryBudget(memoryBudget),
+		m_KeyframeBytes(0), m_Cursor(0), m_CollisionsEnabled(true),
+		m_Revision(0), m_PendingSeek(false), m_PendingTime(0.0)
+	{}
+
+	Timeline::~Timeline() {
+		if (m_Job.valid())
+			m_Job.wait();
+	}
+
+	void Timeline::clear() {
+		m_Times.clear();
+		m_Steps.clear();
+		m_Keyframes.clear();
+		m_KeyframeBytes = 0;
+		m_Cursor = 0;
+		m_PendingSeek = false;
+		m_Revision += 1;
+	}
+
+	void Timeline::onStep(const Engine& engine, float deltaTime) {
+		// a paused engine still steps by zero
+		if (deltaTime == 0.0f && !m_Times.empty())
+			return;
+
+		bool continues = !m_Times.empty()
+			&& m_Times[m_Cursor] + deltaTime == engine.getSimTime()
+			&& m_Keyframes.front().bodies.size() == engine.getBodyCount()
+			&& m_Keyframes.front().particles.size() == engine.getParticleSystems().size()
+			&& m_CollisionsEnabled == engine.collisionsEnabled;
+
+		if (!continues) {
+			clear();
+			m_CollisionsEnabled = engine.collisionsEnabled;
+			m_Times.push_back(engine.getSimTime());
+			addKeyframe(engine);
+			return;
+		}
+
+		if (m_Cursor + 1 < m_Times.size())
+			truncate(m_Cursor);
+
+		m_Steps.push_back(deltaTime);
+		m_Times.push_back(engine.getSimTime());
+		m_Cursor = m_Steps.size();
+		m_Revision += 1;
+
+		if (m_Cursor % m_Interval == 0)
+			addKeyframe(engine);
+	}
+
+	void Timeline::addKeyframe(const Engine& engine) {
+		Keyframe keyframe;
+		keyframe.step = m_Cursor;
+		engine.getBodies(keyframe.bodies);
+		keyframe.bytes = keyframe.bodies.size() * sizeof(Body);
+
+		const std::vector<ParticleSystem*>& systems = engine.getParticleSystems();
+		keyframe.particles.resize(systems.size());
+		for (size_t i = 0; i < systems.size(); ++i) {
+			systems[i]->saveState(keyframe.particles[i]);
+			keyframe.bytes += keyframe.particles[i].size() * sizeof(float);
+		}
+
+		m_KeyframeBytes += keyframe.bytes;
+		m_Keyframes.push_back(std::move(keyframe));
+
+		while (m_KeyframeBytes > m_MemoryBudget && m_Keyframes.size() > 1)
+			thinKeyframes();
+	}
+
+	void Timeline::thinKeyframes() {
+		// the first keyframe always stays, it is where the history starts
+		m_Interval *= 2;
+
+		std::vector<Keyframe> kept;
+		m_KeyframeBytes = 0;
+		for (size_t i = 0; i < m_Keyframes.size(); ++i) {
+			if (i == 0 || m_Keyframes[i].step % m_Interval == 0) {
+				m_KeyframeBytes += m_Keyframes[i].bytes;
+				kept.push_back(std::move(m_Keyframes[i]));
+			}
+		}
+		m_Keyframes = std::move(kept);
+	}
+
+	void Timeline::truncate(size_t step) {
+		m_Steps.resize(step);
+		m_Times.resize(step + 1);
+
+		while (m_Keyframes.size() > 1 && m_Keyframes.back().step > step) {
+			m_KeyframeBytes -= m_Keyframes.back().bytes;
+			m_Keyframes.pop_back();
+		}
+	}
+
+	size_t Timeline::findStep(double time) const {
+		auto it = std::upper_bound(m_Times.begin(), m_Times.end(), time);
+		return it == m_Times.begin() ? 0 : (size_t)(it - m_Times.begin()) - 1;
+	}
+
+	Timeline::Replay Timeline::startReplay(size_t step) const {
+		auto it = std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), step,
+			[](size_t value, const Keyframe& keyframe) { return value < keyframe.step; });
+		const Keyframe& keyframe = *(it - 1);
+
+		Replay replay;
+		replay.step = step;
+		replay.revision = m_Revision;
+		replay.collisionsEnabled = m_CollisionsEnabled;
+		replay.steps.assign(m_Steps.begin() + keyframe.step, m_Steps.begin() + step);
+		replay.bodies = keyframe.bodies;
+		replay.particles = keyframe.particles;
+		return replay;
+	}
+
+	void Timeline::runReplay(Replay& replay) {
+		if (replay.steps.empty())
+			return;
+
+		// the bodies are consecutive in memory, so a scratch engine iterates them
+		// in the same order as the engine they were copied from and every sum
+		// is carried out the same way
+		std::vector<Body> bodies = replay.bodies;
+		std::vector<ParticleSystem> systems(replay.particles.size());
+
+		Engine scratch;
+		scratch.predictionEnabled = false;
+		scratch.collisionsEnabled = replay.collisionsEnabled;
+		for (Body& body : bodies)
+			scratch.addBody(&body);
+		for (size_t i = 0; i < systems.size(); ++i) {
+			systems[i].loadState(replay.particles[i]);
+			scratch.addParticleSystem(&systems[i]);
+		}
+
+		for (float deltaTime : replay.steps)
+			scratch.simulateStep(deltaTime);
+
+		scratch.getBodies(replay.bodies);
+		for (size_t i = 0; i < systems.size(); ++i)
+			systems[i].saveState(replay.particles[i]);
+	}
+
+	void Timeline::apply(Engine& engine, const Replay& replay) {
+		if (replay.bodies.size() != engine.getBodyCount() || replay.particles.size() != engine.getParticleSystems().size()) {
+			utils::printError("Timeline no longer matches the engine");
+			clear();
+			return;
+		}
+
+		engine.setBodies(replay.bodies);
+		const std::vector<ParticleSystem*>& systems = engine.getParticleSystems();
+		for (size_t i = 0; i < systems.size(); ++i)
+			systems[i]->loadState(replay.particles[i]);
+		engine.setSimTime(m_Times[replay.step]);
+
+		m_Cursor = replay.step;
+	}
+
+	bool Timeline::seek(Engine& engine, double time) {
+		if (m_Times.empty())
+			return false;
+
+		Replay replay = startReplay(findStep(time));
+		runReplay(replay);
+		apply(engine, replay);
+		return true;
+	}
+
+	void Timeline::seekAsync(double time) {
+		if (m_Times.empty())
+			return;
+
+		if (m_Job.valid()) {
+			m_PendingSeek = true;
+			m_PendingTime = time;
+			return;
+		}
+
+		Replay replay = startReplay(findStep(time));
+		m_Job = std::async(std::launch::async, [](Replay replay) {
+			runReplay(replay);
+			return replay;
+		}, std::move(replay));
+	}
+
+	bool Timeline::poll(Engine& engine) {
+		if (!m_Job.valid() || m_Job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+
+		Replay replay = m_Job.get();
+		bool applied = replay.revision == m_Revision;
+		if (applied)
+			apply(engine, replay);
+
+		if (m_PendingSeek) {
+			m_PendingSeek = false;
+			seekAsync(m_PendingTime);
+		}
+		return applied;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include "StarSystemSim/physics/trajectory.h"
+
+#include "StarSystemSim/physics/engine.h"
+#include "StarSystemSim/utilities/column_codec.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace physics {
+
+	static const char TRAJECTORY_MAGIC[8] = { 'S', 'S', 'S', 'T', 'R', 'A', 'J', '\0' };
+	static const char TRAJECTORY_INDEX_MAGIC[8] = { 'S', 'S', 'S', 'T', 'I', 'D', 'X', '\0' };
+	static const uint32_t TRAJECTORY_VERSION = 1;
+	static const uint32_t CHUNK_MAGIC = 0x43545353; // "SSTC"
+
+	static const size_t COLUMNS_PER_BODY = 6;
+
+	struct TrajectoryHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t bodyCount;
+		uint32_t every;
+		uint32_t samplesPerChunk;
+		uint8_t padding[40];
+	};
+
+	// followed by the time column and then every body column, each one
+	// as its encoded size (uint32_t) and the encoded bytes
+	struct ChunkHeader {
+		uint32_t magic;
+		uint32_t sampleCount;
+		double startTime, endTime;
+		uint64_t payloadSize;
+	};
+
+	// the index entries come last, then this trailer
+	struct IndexTrailer {
+		uint64_t indexOffset;
+		uint64_t chunkCount;
+		char magic[8];
+	};
+
+	TrajectoryRecorder::TrajectoryRecorder()
+		: m_BodyCount(0), m_Every(1), m_SamplesPerChunk(0), m_Calls(0),
+		m_Head(0), m_Tail(0), m_Filling(nullptr), m_Stop(false),
+		m_Offset(0), m_Dropped(0), m_Written(0)
+	{}
+
+	TrajectoryRecorder::~TrajectoryRecorder() {
+		close();
+	}
+
+	bool TrajectoryRecorder::open(const char* path, size_t bodyCount, uint32_t every, uint32_t samplesPerChunk) {
+		close();
+
+		m_File.open(path, std::ios::binary | std::ios::trunc);
+		if (m_File.fail()) {
+			utils::printError("Failed to open trajectory file (\"%s\") for writing", path);
+			return false;
+		}
+
+		m_BodyCount = bodyCount;
+		m_Every = std::max(every, 1u);
+		m_SamplesPerChunk = std::max(samplesPerChunk, 1u);
+		m_Calls = 0;
+		m_Head = m_Tail = 0;
+		m_Filling = nullptr;
+		m_Stop = false;
+		m_Offset = 0;
+		m_Index.clear();
+		m_Dropped = m_Written = 0;
+
+		// every chunk is allocated up front, recording never allocates
+		for (Chunk& chunk : m_Ring) {
+			chunk.sampleCount = 0;
+			chunk.times.resize(m_SamplesPerChunk);
+			chunk.columns.resize(COLUMNS_PER_BODY * m_BodyCount * m_SamplesPerChunk);
+		}
+		m_Scratch.reserve(bodyCount);
+
+		TrajectoryHeader header;
+		std::memset(&header, 0, sizeof(TrajectoryHeader));
+		std::memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC));
+		header.version = TRAJECTORY_VERSION;
+		header.bodyCount = (uint32_t)bodyCount;
+		header.every = m_Every;
+		header.samplesPerChunk = m_SamplesPerChunk;
+		writeBytes(&header, sizeof(TrajectoryHeader));
+
+		m_Writer = std::thread(&TrajectoryRecorder::writerLoop, this);
+		return true;
+	}
+
+	void TrajectoryRecorder::finish() {
+		if (!isOpen())
+			return;
+
+		if (m_Filling && m_Filling->sampleCount > 0)
+			m_Head.fetch_add(1, std::memory_order_release);
+		m_Filling = nullptr;
+
+		m_Stop.store(true, std::memory_order_release);
+		m_Wake.notify_one();
+	}
+
+	void TrajectoryRecorder::close() {
+		finish();
+		if (m_Writer.joinable())
+			m_Writer.join();
+	}
+
+	void TrajectoryRecorder::record(const Engine& engine) {
+		if (!isOpen() || m_Calls++ % m_Every != 0)
+			return;
+
+		engine.getBodies(m_Scratch);
+		record(engine.getSimTime(), m_Scratch);
+	}
+
+	void TrajectoryRecorder::record(double time, const std::vector<Body>& bodies) {
+		if (!isOpen())
+			return;
+
+		if (bodies.size() != m_BodyCount) {
+			utils::printError("Trajectory was opened for %zu bodies, stopping at %zu", m_BodyCount, bodies.size());
+			finish();
+			return;
+		}
+
+		if (!m_Filling) {
+			uint64_t head = m_Head.load(std::memory_order_relaxed);
+			if (head - m_Tail.load(std::memory_order_acquire) >= RING_SIZE) {
+				m_Dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			m_Filling = &m_Ring[head % RING_SIZE];
+			m_Filling->sampleCount = 0;
+		}
+
+		Chunk& chunk = *m_Filling;
+		const uint32_t sample = chunk.sampleCount;
+		const size_t stride = m_SamplesPerChunk;
+
+		chunk.times[sample] = time;
+		float* columns = chunk.columns.data();
+		for (size_t i = 0; i < m_BodyCount; ++i) {
+			float* body = columns + i * COLUMNS_PER_BODY * stride + sample;
+			body[0 * stride] = bodies[i].pos.x;
+			body[1 * stride] = bodies[i].pos.y;
+			body[2 * stride] = bodies[i].pos.z;
+			body[3 * stride] = bodies[i].vel.x;
+			body[4 * stride] = bodies[i].vel.y;
+			body[5 * stride] = bodies[i].vel.z;
+		}
+
+		if (++chunk.sampleCount == m_SamplesPerChunk) {
+			m_Filling = nullptr;
+			m_Head.fetch_add(1, std::memory_order_release);
+			m_Wake.notify_one();
+		}
+	}
+
+	void TrajectoryRecorder::writerLoop() {
+		while (true) {
+			uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+
+			if (tail < m_Head.load(std::memory_order_acquire)) {
+				writeChunk(m_Ring[tail % RING_SIZE]);
+				m_Tail.store(tail + 1, std::memory_order_release);
+				continue;
+			}
+
+			if (m_Stop.load(std::memory_order_acquire) && tail == m_Head.load(std::memory_order_acquire))
+				break;
+
+			// the simulation thread notifies without the lock, the timeout covers a missed wake up
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			m_Wake.wait_for(lock, std::chrono::milliseconds(5));
+		}
+
+		IndexTrailer trailer;
+		trailer.indexOffset = m_Offset;
+		trailer.chunkCount = m_Index.size();
+		std::memcpy(trailer.magic, TRAJECTORY_INDEX_MAGIC, sizeof(TRAJECTORY_INDEX_MAGIC));
+
+		writeBytes(m_Index.data(), m_Index.size() * sizeof(TrajectoryChunk));
+		writeBytes(&trailer, sizeof(IndexTrailer));
+		m_File.close();
+
+		if (m_Dropped > 0)
+			utils::printError("Trajectory recorder dropped %llu samples", (unsigned long long)m_Dropped.load());
+	}
+
+	void TrajectoryRecorder::writeChunk(const Chunk& chunk) {
+		const uint32_t samples = chunk.sampleCount;
+		const size_t columnCount = 1 + COLUMNS_PER_BODY * m_BodyCount;
+
+		// the payload size is only known once every column is encoded
+		static thread_local std::vector<uint8_t> payload;
+		payload.clear();
+
+		auto appendColumn = [&](const void* values, size_t width) {
+			utils::encodeColumn(values, samples, width, m_Encoded);
+			uint32_t size = (uint32_t)m_Encoded.size();
+			payload.insert(payload.end(), (const uint8_t*)&size, (const uint8_t*)&size + sizeof(uint32_t));
+			payload.insert(payload.end(), m_Encoded.begin(), m_Encoded.end());
+		};
+
+		appendColumn(chunk.times.data(), sizeof(double));
+		for (size_t column = 1; column < columnCount; ++column)
+			appendColumn(chunk.columns.data() + (column - 1) * m_SamplesPerChunk, sizeof(float));
+
+		ChunkHeader header;
+		header.magic = CHUNK_MAGIC;
+		header.sampleCount = samples;
+		header.startTime = chunk.times[0];
+		header.endTime = chunk.times[samples - 1];
+		header.payloadSize = payload.size();
+
+		m_Index.push_back({ m_Offset, header.startTime, header.endTime, samples });
+		writeBytes(&header, sizeof(ChunkHeader));
+		writeBytes(payload.data(), payload.size());
+	}
+
+	void TrajectoryRecorder::writeBytes(const void* data, size_t size) {
+		m_File.write((const char*)data, size);
+		m_Offset += size;
+		m_Written.fetch_add(size, std::memory_order_relaxed);
+	}
+
+	TrajectoryReader::TrajectoryReader()
+		: m_BodyCount(0), m_Every(0)
+	{}
+
+	bool TrajectoryReader::open(const char* path) {
+		close();
+
+		m_File.open(path, std::ios::binary | std::ios::ate);
+		if (m_File.fail()) {
+			utils::printError("Failed to open trajectory file (\"%s\")", path);
+			return false;
+		}
+		uint64_t fileSize = (uint64_t)m_File.tellg();
+		m_File.seekg(0);
+
+		TrajectoryHeader header;
+		if (!m_File.read((char*)&header, sizeof(TrajectoryHeader))
+			|| std::memcmp(header.magic, TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC)) != 0
+			|| header.version != TRAJECTORY_VERSION)
+		{
+			utils::printError("\"%s\" is not a supported trajectory file", path);
+			close();
+			return false;
+		}
+
+		m_BodyCount = header.bodyCount;
+		m_Every = header.every;
+
+		IndexTrailer trailer;
+		bool indexed = fileSize >= sizeof(TrajectoryHeader) + sizeof(IndexTrailer);
+		if (indexed) {
+			m_File.seekg(fileSize - sizeof(IndexTrailer));
+			indexed = m_File.read((char*)&trailer, sizeof(IndexTrailer))
+				&& std::memcmp(trailer.magic, TRAJECTORY_INDEX_MAGIC, sizeof(TRAJECTORY_INDEX_MAGIC)) == 0
+				&& trailer.indexOffset + trailer.chunkCount * sizeof(TrajectoryChunk) + sizeof(IndexTrailer) == fileSize;
+		}
+
+		if (indexed) {
+			m_Chunks.resize(trailer.chunkCount);
+			m_File.seekg(trailer.indexOffset);
+			m_File.read((char*)m_Chunks.data(), m_Chunks.size() * sizeof(TrajectoryChunk));
+			indexed = !m_File.fail();
+		}
+
+		if (!indexed && !scanChunks(fileSize)) {
+			utils::printError("Trajectory file (\"%s\") is damaged", path);
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool TrajectoryReader::scanChunks(uint64_t fileSize) {
+		m_File.clear();
+		m_Chunks.clear();
+
+		// an interrupted recording ends in a partial chunk, which is left out
+		uint64_t offset = sizeof(TrajectoryHeader);
+		while (offset + sizeof(ChunkHeader) <= fileSize) {
+			ChunkHeader header;
+			m_File.seekg(offset);
+			if (!m_File.read((char*)&header, sizeof(ChunkHeader)) || header.magic != CHUNK_MAGIC)
+				break;
+			if (offset + sizeof(ChunkHeader) + header.payloadSize > fileSize)
+				break;
+
+			m_Chunks.push_back({ offset, header.startTime, header.endTime, header.sampleCount });
+			offset += sizeof(ChunkHeader) + header.payloadSize;
+		}
+
+		m_File.clear();
+		return true;
+	}
+
+	void TrajectoryReader::close() {
+		if (m_File.is_open())
+			m_File.close();
+		m_File.clear();
+		m_BodyCount = 0;
+		m_Every = 0;
+		m_Chunks.clear();
+	}
+
+	double TrajectoryReader::getStartTime() const {
+		return m_Chunks.empty() ? 0.0 : m_Chunks.front().startTime;
+	}
+
+	double TrajectoryReader::getEndTime() const {
+		return m_Chunks.empty() ? 0.0 : m_Chunks.back().endTime;
+	}
+
+	bool TrajectoryReader::read(double from, double to, Frames& frames) {
+		// chunks are in time order, the first one that can overlap is found by bisection
+		auto first = std::lower_bound(m_Chunks.begin(), m_Chunks.end(), from,
+			[](const TrajectoryChunk& chunk, double time) { return chunk.endTime < time; });
+
+		for (auto chunk = first; chunk != m_Chunks.end() && chunk->startTime <= to; ++chunk) {
+			ChunkHeader header;
+			m_File.seekg(chunk->offset);
+			if (!m_File.read((char*)&header, sizeof(ChunkHeader)) || header.magic != CHUNK_MAGIC)
+				return false;
+
+			m_Encoded.resize(header.payloadSize);
+			if (!m_File.read((char*)m_Encoded.data(), m_Encoded.size()))
+				return false;
+
+			const size_t samples = header.sampleCount;
+			const uint8_t* cursor = m_Encoded.data();
+			const uint8_t* end = cursor + m_Encoded.size();
+
+			auto nextColumn = [&](size_t width, void* values) {
+				uint32_t size;
+				if (end - cursor < (ptrdiff_t)sizeof(uint32_t))
+					return false;
+				std::memcpy(&size, cursor, sizeof(uint32_t));
+				cursor += sizeof(uint32_t);
+				if ((size_t)(end - cursor) < size)
+					return false;
+
+				bool ok = utils::decodeColumn(cursor, size, samples, width, values);
+				cursor += size;
+				return ok;
+			};
+
+			m_Times.resize(samples);
+			if (!nextColumn(sizeof(double), m_Times.data()))
+				return false;
+
+			// samples of this chunk inside [from, to]
+			size_t begin = std::lower_bound(m_Times.begin(), m_Times.end(), from) - m_Times.begin();
+			size_t stop = std::upper_bound(m_Times.begin(), m_Times.end(), to) - m_Times.begin();
+			if (begin >= stop)
+				continue;
+
+			const size_t base = frames.times.size();
+			const size_t count = stop - begin;
+			frames.times.insert(frames.times.end(), m_Times.begin() + begin, m_Times.begin() + stop);
+			frames.pos.resize((base + count) * m_BodyCount);
+			frames.vel.resize((base + count) * m_BodyCount);
+
+			m_Column.resize(samples);
+			for (size_t body = 0; body < m_BodyCount; ++body) {
+				for (size_t column = 0; column < COLUMNS_PER_BODY; ++column) {
+					if (!nextColumn(sizeof(float), m_Column.data()))
+						return false;
+
+					std::vector<glm::vec3>& target = column < 3 ? frames.pos : frames.vel;
+					for (size_t sample = 0; sample < count; ++sample)
+						target[(base + sample) * m_BodyCount + body][(int)(column % 3)] = m_Column[begin + sample];
+				}
+			}
+		}
+
+		return true;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "StarSystemSim/utilities/alloc_tracker.h"
+#include "StarSystemSim/utilities/error.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace utils {
+
+	struct ThreadAllocs;
+
+	// every thread that allocated and has not exited yet, plus what the exited ones
+	// made; registering takes no allocation, so it is safe inside operator new
+	static std::mutex s_ThreadsMutex;
+	static ThreadAllocs* s_Threads = nullptr;
+	static uint64_t s_RetiredAllocations = 0, s_RetiredBytes = 0;
+
+	struct ThreadAllocs {
+		// only written by the owning thread, other threads read them for the totals
+		std::atomic<uint64_t> allocations, bytes;
+		// innermost no-allocation scope of the thread
+		const char* scope;
+		ThreadAllocs* prev;
+		ThreadAllocs* next;
+		bool registered, exited;
+
+		constexpr ThreadAllocs()
+			: allocations(0), bytes(0), scope(nullptr), prev(nullptr), next(nullptr), registered(false), exited(false)
+		{}
+
+		void add(uint64_t size) {
+			allocations.store(allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			bytes.store(bytes.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+		}
+
+		~ThreadAllocs() {
+			std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+			exited = true;
+			if (!registered)
+				return;
+
+			s_RetiredAllocations += allocations.load(std::memory_order_relaxed);
+			s_RetiredBytes += bytes.load(std::memory_order_relaxed);
+
+			if (prev)
+				prev->next = next;
+			else
+				s_Threads = next;
+			if (next)
+				next->prev = prev;
+			registered = false;
+		}
+	};
+
+	// constant initialised, so reading it never runs a constructor inside operator new
+	static thread_local ThreadAllocs t_Allocs;
+
+	static std::atomic<uint64_t> s_Violations(0);
+	static std::atomic<const char*> s_LastViolation(nullptr);
+	static std::atomic<bool> s_Assertions(false);
+
+	// false once the thread's counters were retired, later allocations made
+	// while it exits go straight to the totals
+	static bool registerThread(size_t size) {
+		std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+		if (t_Allocs.exited) {
+			s_RetiredAllocations += 1;
+			s_RetiredBytes += size;
+			return false;
+		}
+
+		t_Allocs.next = s_Threads;
+		if (s_Threads)
+			s_Threads->prev = &t_Allocs;
+		s_Threads = &t_Allocs;
+		t_Allocs.registered = true;
+		return true;
+	}
+
+	static void countAllocation(size_t size) {
+		if (t_Allocs.registered || registerThread(size))
+			t_Allocs.add(size);
+
+		if (t_Allocs.scope && s_Assertions.load(std::memory_order_relaxed)) {
+			// printing may allocate itself
+			const char* scope = t_Allocs.scope;
+			t_Allocs.scope = nullptr;
+			printError("Allocated %zu bytes in no-allocation scope \"%s\"", size, scope);
+			std::abort();
+		}
+	}
+
+	AllocTracker::Counts AllocTracker::getThreadCounts() {
+		return { t_Allocs.allocations.load(std::memory_order_relaxed), t_Allocs.bytes.load(std::memory_order_relaxed) };
+	}
+
+	AllocTracker::Counts AllocTracker::getTotalCounts() {
+		std::lock_guard<std::mutex> lock(s_ThreadsMutex);
+
+		Counts counts = { s_RetiredAllocations, s_RetiredBytes };
+		for (const ThreadAllocs* thread = s_Threads; thread; thread = thread->next) {
+			counts.allocations += thread->allocations.load(std::memory_order_relaxed);
+			counts.bytes += thread->bytes.load(std::memory_order_relaxed);
+		}
+		return counts;
+	}
+
+	uint64_t AllocTracker::getViolations() {
+		return s_Violations.load(std::memory_order_relaxed);
+	}
+
+	const char* AllocTracker::getLastViolation() {
+		return s_LastViolation.load(std::memory_order_relaxed);
+	}
+
+	void AllocTracker::setAssertions(bool enabled) {
+		s_Assertions.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool AllocTracker::getAssertions() {
+		return s_Assertions.load(std::memory_order_relaxed);
+	}
+
+	NoAllocScope::NoAllocScope(const char* name)
+		: m_Name(name), m_Outer(t_Allocs.scope), m_Allocations(t_Allocs.allocations.load(std::memory_order_relaxed))
+	{
+		t_Allocs.scope = name;
+	}
+
+	NoAllocScope::~NoAllocScope() {
+		t_Allocs.scope = m_Outer;
+
+		if (t_Allocs.allocations.load(std::memory_order_relaxed) != m_Allocations) {
+			s_Violations.fetch_add(1, std::memory_order_relaxed);
+			s_LastViolation.store(m_Name, std::memory_order_relaxed);
+		}
+	}
+
+}
+
+#if STARSIM_ALLOC_TRACKING
+
+void* operator new(size_t size) {
+	utils::countAllocation(size);
+	if (void* memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	utils::countAllocation(size);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+// aligned_alloc wants a multiple of the alignment, MSVC has its own aligned heap
+static void* allocateAligned(size_t size, std::align_val_t alignment) {
+	size_t align = (size_t)alignment;
+	size = (std::max<size_t>(size, 1) + align - 1) & ~(align - 1);
+#if defined(_WIN32)
+	return _aligned_malloc(size, align);
+#else
+	return std::aligned_alloc(align, size);
+#endif
+}
+
+static void freeAligned(void* memory) {
+#if defined(_WIN32)
+	_aligned_free(memory);
+#else
+	std::free(memory);
+#endif
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	utils::countAllocation(size);
+	if (void* memory = allocateAligned(size, alignment))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	utils::countAllocation(size);
+	return allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return operator new(size, alignment, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(memory); }
+
+#endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "StarSystemSim/utilities/column_codec.h"
+
+#include <cstring>
+
+namespace utils {
+
+	template<typename T>
+	static void deltaShuffle(const void* values, size_t count, uint8_t* shuffled) {
+		T previous = 0;
+		for (size_t i = 0; i < count; ++i) {
+			T value;
+			std::memcpy(&value, (const uint8_t*)values + i * sizeof(T), sizeof(T));
+			T delta = value - previous;
+			previous = value;
+
+			for (size_t byte = 0; byte < sizeof(T); ++byte)
+				shuffled[byte * count + i] = (uint8_t)(delta >> (8 * byte));
+		}
+	}
+
+	template<typename T>
+	static void unshuffleDelta(const uint8_t* shuffled, size_t count, void* values) {
+		T previous = 0;
+		for (size_t i = 0; i < count; ++i) {
+			T delta = 0;
+			for (size_t byte = 0; byte < sizeof(T); ++byte)
+				delta |= (T)shuffled[byte * count + i] << (8 * byte);
+
+			previous += delta;
+			std::memcpy((uint8_t*)values + i * sizeof(T), &previous, sizeof(T));
+		}
+	}
+
+	void encodeColumn(const void* values, size_t count, size_t width, std::vector<uint8_t>& encoded) {
+		static thread_local std::vector<uint8_t> shuffled;
+		shuffled.resize(count * width);
+
+		if (width == 8)
+			deltaShuffle<uint64_t>(values, count, shuffled.data());
+		else
+			deltaShuffle<uint32_t>(values, count, shuffled.data());
+
+		// a zero byte is followed by the number of further zeros (up to 255)
+		encoded.clear();
+		for (size_t i = 0; i < shuffled.size(); ++i) {
+			encoded.push_back(shuffled[i]);
+			if (shuffled[i] != 0)
+				continue;
+
+			uint8_t run = 0;
+			while (run < 255 && i + 1 < shuffled.size() && shuffled[i + 1] == 0) {
+				++run;
+				++i;
+			}
+			encoded.push_back(run);
+		}
+	}
+
+	bool decodeColumn(const uint8_t* encoded, size_t size, size_t count, size_t width, void* values) {
+		static thread_local std::vector<uint8_t> shuffled;
+		shuffled.clear();
+		shuffled.reserve(count * width);
+
+		for (size_t i = 0; i < size; ++i) {
+			if (encoded[i] != 0) {
+				shuffled.push_back(encoded[i]);
+				continue;
+			}
+
+			if (++i >= size)
+				return false;
+			shuffled.insert(shuffled.end(), (size_t)encoded[i] + 1, 0);
+		}
+
+		if (shuffled.size() != count * width)
+			return false;
+
+		if (width == 8)
+			unshuffleDelta<uint64_t>(shuffled.data(), count, values);
+		else
+			unshuffleDelta<uint32_t>(shuffled.data(), count, values);
+
+		return true;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "StarSystemSim/utilities/perf_counters.h"
+#include "StarSystemSim/utilities/error.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+
+namespace utils {
+
+	double PerfCounters::Values::getIPC() const {
+		uint64_t cycles = get(Counter::CYCLES);
+		return cycles ? (double)get(Counter::INSTRUCTIONS) / cycles : 0.0;
+	}
+
+	PerfCounters::Values& PerfCounters::Values::operator+=(const Values& other) {
+		for (uint32_t i = 0; i < COUNTER_COUNT; ++i)
+			counts[i] += other.counts[i];
+		return *this;
+	}
+
+	PerfCounters::Values PerfCounters::Values::operator-(const Values& other) const {
+		Values difference;
+		for (uint32_t i = 0; i < COUNTER_COUNT; ++i)
+			difference.counts[i] = counts[i] - other.counts[i];
+		return difference;
+	}
+
+	PerfCounters::PerfCounters()
+		: m_Leader(-1), m_Order(), m_Opened(0)
+	{
+		for (uint32_t i = 0; i < COUNTER_COUNT; ++i)
+			m_Fds[i] = -1;
+	}
+
+	PerfCounters::~PerfCounters() {
+		close();
+	}
+
+	const char* PerfCounters::getCounterName(Counter counter) {
+		switch (counter) {
+			case Counter::CYCLES: return "cycles";
+			case Counter::INSTRUCTIONS: return "instructions";
+			case Counter::L1D_MISSES: return "l1d_misses";
+			case Counter::LLC_MISSES: return "llc_misses";
+			case Counter::BRANCH_MISSES: return "branch_misses";
+		}
+		return "unknown";
+	}
+
+#if defined(__linux__)
+
+	static void setEvent(PerfCounters::Counter counter, perf_event_attr& attr) {
+		switch (counter) {
+			case PerfCounters::Counter::CYCLES:
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_CPU_CYCLES;
+				break;
+			case PerfCounters::Counter::INSTRUCTIONS:
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+				break;
+			case PerfCounters::Counter::L1D_MISSES:
+				attr.type = PERF_TYPE_HW_CACHE;
+				attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+				break;
+			case PerfCounters::Counter::LLC_MISSES:
+				// the generic event the kernel maps to last level misses
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_CACHE_MISSES;
+				break;
+			case PerfCounters::Counter::BRANCH_MISSES:
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+				break;
+		}
+	}
+
+	bool PerfCounters::open() {
+		close();
+
+		int error = 0;
+		for (uint32_t i = 0; i < COUNTER_COUNT; ++i) {
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			setEvent((Counter)i, attr);
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, m_Leader, PERF_FLAG_FD_CLOEXEC);
+			if (fd < 0) {
+				error = errno;
+				continue;
+			}
+
+			m_Fds[i] = fd;
+			m_Order[m_Opened++] = (Counter)i;
+			if (m_Leader < 0)
+				m_Leader = fd;
+		}
+
+		if (m_Leader < 0) {
+			printError("Failed to open hardware counters: %s%s", strerror(error),
+				error == EACCES || error == EPERM ? ", see /proc/sys/kernel/perf_event_paranoid" : "");
+			return false;
+		}
+		if (error)
+			printError("Only %u of %u hardware counters available: %s", m_Opened, COUNTER_COUNT, strerror(error));
+		return true;
+	}
+
+	void PerfCounters::close() {
+		for (uint32_t i = 0; i < COUNTER_COUNT; ++i) {
+			if (m_Fds[i] >= 0)
+				::close(m_Fds[i]);
+			m_Fds[i] = -1;
+		}
+		m_Leader = -1;
+		m_Opened = 0;
+	}
+
+	PerfCounters::Values PerfCounters::read() const {
+		Values values = {};
+		if (m_Leader < 0)
+			return values;
+
+		// count, time enabled, time running and one value per opened counter
+		uint64_t data[3 + COUNTER_COUNT];
+		ssize_t size = ::read(m_Leader, data, sizeof(data));
+		if (size < (ssize_t)(3 * sizeof(uint64_t)))
+			return values;
+
+		double scale = data[2] && data[2] < data[1] ? (double)data[1] / data[2] : 1.0;
+		for (uint64_t i = 0; i < data[0] && i < m_Opened; ++i)
+			values.counts[(uint32_t)m_Order[i]] = (uint64_t)(data[3 + i] * scale);
+		return values;
+	}
+
+#else
+
+	bool PerfCounters::open() {
+		printError("Hardware counters are only read on Linux");
+		return false;
+	}
+
+	void PerfCounters::close() {}
+
+	PerfCounters::Values PerfCounters::read() const {
+		return {};
+	}
+
+#endif
+
+}
\ No newline at end of file
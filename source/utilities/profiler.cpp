@@ -0,0 +1,175 @@
+#include "StarSystemSim/utilities/profiler.h"
+
+#include "StarSystemSim/utilities/error.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+	// zones kept per thread, about 2.5 MB each
+	static const uint32_t RING_SIZE = 1 << 16;
+
+	struct ThreadRing {
+		Profiler::Zone zones[RING_SIZE];
+		// zones ever written, the ring holds the last RING_SIZE of them
+		std::atomic<uint64_t> head;
+		// cleared when the thread exits so the next new thread takes the ring over,
+		// the exited thread's zones are kept until then
+		std::atomic<bool> owned;
+		uint32_t id;
+		std::string name;
+	};
+
+	static std::atomic<bool> s_Enabled(true);
+
+	static std::mutex s_RingsMutex;
+	// never freed, a trace may be written after a thread is gone
+	static std::vector<std::unique_ptr<ThreadRing>> s_Rings;
+
+	static ThreadRing* acquireRing() {
+		std::lock_guard<std::mutex> lock(s_RingsMutex);
+
+		for (std::unique_ptr<ThreadRing>& ring : s_Rings) {
+			bool owned = false;
+			if (ring->owned.compare_exchange_strong(owned, true)) {
+				// the zones left in it belong to the exited thread, not to the new one
+				ring->head.store(0, std::memory_order_relaxed);
+				ring->name = "thread " + std::to_string(ring->id);
+				return ring.get();
+			}
+		}
+
+		s_Rings.emplace_back(new ThreadRing());
+		ThreadRing* ring = s_Rings.back().get();
+		ring->head.store(0, std::memory_order_relaxed);
+		ring->owned.store(true, std::memory_order_relaxed);
+		ring->id = (uint32_t)s_Rings.size();
+		ring->name = "thread " + std::to_string(ring->id);
+		return ring;
+	}
+
+	struct RingHandle {
+		ThreadRing* ring = nullptr;
+
+		~RingHandle() {
+			if (ring)
+				ring->owned.store(false, std::memory_order_release);
+		}
+	};
+
+	static ThreadRing& getThreadRing() {
+		static thread_local RingHandle handle;
+		if (!handle.ring)
+			handle.ring = acquireRing();
+		return *handle.ring;
+	}
+
+	void Profiler::setEnabled(bool enabled) {
+		s_Enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	bool Profiler::isEnabled() {
+		return s_Enabled.load(std::memory_order_relaxed);
+	}
+
+	void Profiler::setThreadName(const char* name) {
+		ThreadRing& ring = getThreadRing();
+		std::lock_guard<std::mutex> lock(s_RingsMutex);
+		ring.name = name;
+	}
+
+	uint64_t Profiler::now() {
+		static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		// never 0, zones use it for not recording
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() + 1;
+	}
+
+	void Profiler::record(const char* name, uint64_t start, uint64_t end, uint64_t allocations, uint64_t bytes) {
+		ThreadRing& ring = getThreadRing();
+		uint64_t head = ring.head.load(std::memory_order_relaxed);
+
+		ring.zones[head % RING_SIZE] = { name, start, end, allocations, bytes };
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+	void Profiler::getThreadZones(uint64_t since, std::vector<Zone>& zones) {
+		zones.clear();
+		ThreadRing& ring = getThreadRing();
+		uint64_t head = ring.head.load(std::memory_order_relaxed);
+		uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+
+		// a thread records zones as they end, so end times only grow along the ring
+		uint64_t begin = head;
+		while (begin > first && ring.zones[(begin - 1) % RING_SIZE].end > since)
+			begin -= 1;
+
+		for (uint64_t i = begin; i < head; ++i)
+			zones.push_back(ring.zones[i % RING_SIZE]);
+	}
+
+	bool Profiler::writeTrace(const char* path) {
+		struct Copy {
+			uint32_t id;
+			std::string name;
+			std::vector<Zone> zones;
+		};
+		std::vector<Copy> copies;
+
+		{
+			std::lock_guard<std::mutex> lock(s_RingsMutex);
+			for (const std::unique_ptr<ThreadRing>& ring : s_Rings) {
+				Copy copy = { ring->id, ring->name, {} };
+
+				uint64_t head = ring->head.load(std::memory_order_acquire);
+				uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+				for (uint64_t i = first; i < head; ++i)
+					copy.zones.push_back(ring->zones[i % RING_SIZE]);
+
+				// the owner kept writing meanwhile, whatever it may have overwritten is dropped
+				uint64_t after = ring->head.load(std::memory_order_acquire);
+				if (after > first + RING_SIZE) {
+					size_t stale = (size_t)std::min<uint64_t>(after - RING_SIZE - first, copy.zones.size());
+					copy.zones.erase(copy.zones.begin(), copy.zones.begin() + stale);
+				}
+
+				copies.push_back(std::move(copy));
+			}
+		}
+
+		FILE* file = fopen(path, "w");
+		if (!file) {
+			printError("Failed to open %s", path);
+			return false;
+		}
+
+		size_t count = 0;
+		fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+		for (const Copy& copy : copies) {
+			fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+				count++ ? ",\n" : "", copy.id, copy.name.c_str());
+
+			for (const Zone& zone : copy.zones) {
+				fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f",
+					zone.name, copy.id, zone.start * 1e-3, (zone.end - zone.start) * 1e-3);
+				if (zone.allocations)
+					fprintf(file, ", \"args\": {\"allocations\": %llu, \"bytes\": %llu}",
+						(unsigned long long)zone.allocations, (unsigned long long)zone.bytes);
+				fprintf(file, "}");
+				count += 1;
+			}
+		}
+		fprintf(file, "\n]}\n");
+		fclose(file);
+
+		print("Wrote %zu trace events to %s", count, path);
+		return true;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "StarSystemSim/utilities/thread_pool.h"
+
+#include "StarSystemSim/utilities/profiler.h"
+
+#include <algorithm>
+
+namespace utils {
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+		: m_Quit(false)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		// the calling thread takes part in every loop
+		for (uint32_t i = 1; i < threadCount; ++i) {
+			m_Workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Quit = true;
+		}
+		m_WorkReady.notify_all();
+
+		for (std::thread& worker : m_Workers) {
+			worker.join();
+		}
+	}
+
+	ThreadPool& ThreadPool::getShared() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& func, size_t grain) {
+		if (begin >= end)
+			return;
+
+		size_t autoGrain = (end - begin) / ((size_t)getThreadCount() * 4);
+		grain = std::max<size_t>(std::max<size_t>(grain, autoGrain), 1);
+
+		if (m_Workers.empty() || end - begin <= grain) {
+			func(begin, end);
+			return;
+		}
+
+		Job job = { &func, begin, end, grain, 0 };
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back(&job);
+		m_WorkReady.notify_all();
+
+		runChunks(lock, job);
+
+		m_WorkDone.wait(lock, [&job]() { return job.next >= job.end && job.busy == 0; });
+	}
+
+	void ThreadPool::runChunks(std::unique_lock<std::mutex>& lock, Job& job) {
+		while (job.next < job.end) {
+			size_t chunkBegin = job.next;
+			size_t chunkEnd = std::min(job.end, chunkBegin + job.grain);
+			job.next = chunkEnd;
+			job.busy += 1;
+
+			// once every chunk is handed out only the threads running them still touch the job
+			if (job.next >= job.end)
+				m_Jobs.erase(std::find(m_Jobs.begin(), m_Jobs.end(), &job));
+
+			lock.unlock();
+			{
+				PROFILE_ZONE("parallel chunk");
+				(*job.func)(chunkBegin, chunkEnd);
+			}
+			lock.lock();
+
+			job.busy -= 1;
+		}
+
+		if (job.busy == 0)
+			m_WorkDone.notify_all();
+	}
+
+	void ThreadPool::workerLoop() {
+		Profiler::setThreadName("pool worker");
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		while (true) {
+			m_WorkReady.wait(lock, [this]() { return m_Quit || !m_Jobs.empty(); });
+			if (m_Quit)
+				return;
+
+			// the newest loop first, a short one started during a long one is not held up by it
+			runChunks(lock, *m_Jobs.back());
+		}
+	}
+
+}
\ No newline at end of file
@@ -1,15 +1,35 @@
 #include "StarSystemSim/utilities/timer.h"
 
-#include <GLFW/glfw3.h>
+#include <chrono>
 
 namespace utils {
 
-	float Timer::measureTime() {
-		double now = glfwGetTime();
-		deltaTime = (float)(now - lastTime);
-		lastTime = now;
+	static double steadyClock() {
+		static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	Timer::Timer()
+		: m_Clock(steadyClock)
+	{
+		m_LastTime = m_Clock();
+		lastTime = (float)m_LastTime;
+	}
+
+	double Timer::measureTime() {
+		double now = m_Clock();
+		deltaTime = (float)(now - m_LastTime);
+		m_LastTime = now;
+		lastTime = (float)now;
 
 		return now;
 	}
 
+	void Timer::setClock(std::function<double()> clock) {
+		m_Clock = clock ? std::move(clock) : std::function<double()>(steadyClock);
+		m_LastTime = m_Clock();
+		lastTime = (float)m_LastTime;
+		deltaTime = 0.0f;
+	}
+
 }
\ No newline at end of file